@@ -1,4 +1,5 @@
 #include <cassert>
+#include <atomic>
 
 #include <boost/algorithm/string/join.hpp>
 #include <boost/algorithm/string/replace.hpp>
@@ -55,7 +56,9 @@ namespace node_type {
 
 std::size_t generate_id() noexcept
 {
-    static std::size_t current_id = 0;
+    // Note:
+    // Nodes may be created in some threads concurrently when compiling files in parallel.
+    static std::atomic<std::size_t> current_id{0};
     return ++current_id;
 }
 
@@ -4,6 +4,7 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <unordered_map>
 #include <cstddef>
 #include <cassert>
 
@@ -16,6 +17,7 @@
 #include "dachs/semantics/symbol.hpp"
 #include "dachs/semantics/type.hpp"
 #include "dachs/helper/variant.hpp"
+#include "dachs/helper/identifier.hpp"
 
 // Note:
 // This AST is heterogeneous (patially homogeneous).
@@ -358,7 +360,7 @@ struct lambda_expr final : public expression {
 
 // This node will have kind of variable (global, member, local variables and functions)
 struct var_ref final : public expression {
-    std::string name;
+    helper::identifier name;
     dachs::symbol::weak_var_symbol symbol;
     bool is_lhs_of_assignment = false;
 
@@ -384,7 +386,7 @@ struct var_ref final : public expression {
 
 struct parameter final : public base {
     bool is_var;
-    std::string name;
+    helper::identifier name;
     boost::optional<node::any_type> param_type;
     dachs::symbol::weak_var_symbol param_symbol;
     type::type type;
@@ -547,7 +549,7 @@ struct index_access final : public expression {
 
 struct ufcs_invocation final : public expression {
     node::any_expr child;
-    std::string member_name;
+    helper::identifier member_name;
     scope::weak_func_scope callee_scope;
     bool is_assign = false;
 
@@ -744,7 +746,7 @@ struct typed_expr final : public expression {
 };
 
 struct primary_type final : public base {
-    std::string name;
+    helper::identifier name;
     std::vector<node::any_type> template_params;
 
     primary_type(std::string const& tmpl
@@ -894,7 +896,7 @@ struct qualified_type final : public base {
 
 struct variable_decl final : public base {
     bool is_var;
-    std::string name;
+    helper::identifier name;
     boost::optional<node::any_type> maybe_type;
     dachs::symbol::weak_var_symbol symbol;
     boost::optional<bool> accessibility = boost::none;
@@ -1148,7 +1150,7 @@ struct function_definition final : public statement {
     struct converter_tag {};
 
     symbol::func_kind kind;
-    std::string name;
+    helper::identifier name;
     std::vector<node::parameter> params;
     boost::optional<node::any_type> return_type;
     node::statement_block body;
@@ -1156,6 +1158,12 @@ struct function_definition final : public statement {
     scope::weak_func_scope scope;
     boost::optional<type::type> ret_type;
     std::vector<node::function_definition> instantiated; // Note: This is not a part of AST!
+    // Note:
+    // Index of 'instantiated' for semantic analysis (not a part of AST).  Fully instantiated
+    // functions are keyed on the hash of their parameter types.  Functions which are still
+    // templates after instantiation (see analyzer) are listed in 'partially_instantiated'.
+    std::unordered_multimap<std::size_t, node::function_definition> instantiated_index;
+    std::vector<node::function_definition> partially_instantiated;
     boost::optional<bool> accessibility = boost::none;
     boost::optional<bool> is_template_memo = boost::none;
 
@@ -1283,7 +1291,7 @@ struct function_definition final : public statement {
 };
 
 struct class_definition final : public statement {
-    std::string name;
+    helper::identifier name;
     std::vector<node::variable_decl> instance_vars;
     std::vector<node::function_definition> member_funcs;
     scope::weak_class_scope scope;
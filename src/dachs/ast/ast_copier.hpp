@@ -40,8 +40,95 @@ inline Node copy_node(SourceNode const& node, Args &&... args)
     return copied;
 }
 
+// Note:
+// Check whether the type node has 'typeof()' in it.  The expression in 'typeof()'
+// is analyzed as the other expressions.
+struct typeof_finder : boost::static_visitor<bool> {
+    template<class T>
+    bool operator()(boost::optional<T> const& o) const
+    {
+        return o && (*this)(*o);
+    }
+
+    template<class T>
+    bool operator()(std::vector<T> const& v) const
+    {
+        for (auto const& t : v) {
+            if ((*this)(t)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool operator()(node::any_type const& t) const
+    {
+        return boost::apply_visitor(*this, t);
+    }
+
+    bool operator()(node::primary_type const& t) const
+    {
+        return (*this)(t->template_params);
+    }
+
+    bool operator()(node::array_type const& t) const
+    {
+        return (*this)(t->elem_type);
+    }
+
+    bool operator()(node::dict_type const& t) const
+    {
+        return (*this)(t->key_type) || (*this)(t->value_type);
+    }
+
+    bool operator()(node::pointer_type const& t) const
+    {
+        return (*this)(t->pointee_type);
+    }
+
+    bool operator()(node::typeof_type const&) const
+    {
+        return true;
+    }
+
+    bool operator()(node::tuple_type const& t) const
+    {
+        return (*this)(t->arg_types);
+    }
+
+    bool operator()(node::func_type const& t) const
+    {
+        return (*this)(t->arg_types) || (*this)(t->ret_type);
+    }
+
+    bool operator()(node::qualified_type const& t) const
+    {
+        return (*this)(t->type);
+    }
+};
+
 class copier {
 public:
+    // Note:
+    // Semantic analysis never modifies type nodes except the expression in 'typeof()'.
+    // So a type without 'typeof()' is shared with the source instead of being copied.
+    // It reduces the nodes copied at each instantiation of templates (e.g. types of
+    // parameters, variables and casts).
+    node::any_type copy(node::any_type const& t) const
+    {
+        if (!typeof_finder{}(t)) {
+            return t;
+        }
+
+        return helper::variant::apply_lambda(
+                [this](auto const& n)
+                    -> node::any_type
+                {
+                    return {copy(n)};
+                }, t
+            );
+    }
+
     template<class... Nodes>
     auto copy(boost::variant<Nodes...> const& v) const
     {
@@ -306,7 +393,9 @@ public:
 
     auto copy(node::lambda_expr const& le) const
     {
-        return copy_node(le, copy(le->def));
+        auto copied = copy_node(le, copy(le->def));
+        copied->receiver->location = le->receiver->location;
+        return copied;
     }
 
     auto copy(node::inu const& p) const
@@ -5,6 +5,7 @@
 #include <type_traits>
 #include <tuple>
 #include <cassert>
+#include <cstdint>
 #include <string>
 #include <iostream>
 
@@ -12,34 +13,49 @@
 #include <boost/optional.hpp>
 #include <boost/filesystem/path.hpp>
 
+#include "dachs/ast/source_files.hpp"
 #include "dachs/helper/make.hpp"
 
 namespace dachs {
 namespace ast {
 
-using path_type = std::shared_ptr<boost::filesystem::path>;
-
+// Note:
+// Location in a source file.  Only the file id and the byte offset are held
+// to keep nodes small.  Line and column are resolved with the line table of
+// the file when they are needed.  See source_files.hpp.
 struct location_type {
-    std::size_t line = 0, col = 0, length = 0;
-    path_type path = nullptr;
+    file_id_type file = source_files::no_file;
+    std::uint32_t offset = 0u, length = 0u;
+
+    std::size_t line() const
+    {
+        return source_files::line_col_of(file, offset).first;
+    }
+
+    std::size_t col() const
+    {
+        return source_files::line_col_of(file, offset).second;
+    }
 
     std::string to_string(bool const include_path = true) const
     {
+        auto const pos = source_files::line_col_of(file, offset);
         if (include_path) {
-            return "line:" + std::to_string(line)
-                + ", col:" + std::to_string(col)
+            return "line:" + std::to_string(pos.first)
+                + ", col:" + std::to_string(pos.second)
                 + ", len:" + std::to_string(length)
                 + ", " + get_path().native();
         } else {
-            return "line:" + std::to_string(line)
-                + ", col:" + std::to_string(col)
+            return "line:" + std::to_string(pos.first)
+                + ", col:" + std::to_string(pos.second)
                 + ", len:" + std::to_string(length);
         }
     }
 
     std::ostream &output_to(std::ostream &out, bool const include_path = true) const
     {
-        out << "line:" << line << ", col:" << col;
+        auto const pos = source_files::line_col_of(file, offset);
+        out << "line:" << pos.first << ", col:" << pos.second;
         if (include_path) {
             out << ", " << get_path();
         }
@@ -48,12 +64,12 @@ struct location_type {
 
     boost::filesystem::path get_path() const
     {
-        return path ? *path : boost::filesystem::path{};
+        return source_files::path_of(file);
     }
 
     bool empty() const noexcept
     {
-        return line == 0 && col == 0 && length == 0 && !path;
+        return file == source_files::no_file && offset == 0u && length == 0u;
     }
 };
 
@@ -0,0 +1,1021 @@
+#define BOOST_RESULT_OF_USE_DECLTYPE 1
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+#include <boost/optional.hpp>
+#include <boost/variant/variant.hpp>
+
+#include "dachs/ast/ast.hpp"
+#include "dachs/ast/ast_serializer.hpp"
+#include "dachs/helper/variant.hpp"
+#include "dachs/helper/util.hpp"
+#include "dachs/helper/make.hpp"
+
+namespace dachs {
+namespace ast {
+namespace detail {
+
+using std::size_t;
+
+// Note:
+// Bump this when the layout of any node below is changed.
+// Data serialized with other versions is rejected on deserialization.
+constexpr std::uint64_t format_version = 2u;
+
+// Note:
+// Integers are encoded as LEB128 variable-length integers.  Most of the
+// values in AST (sizes of vectors, lines, columns, variant indices) are small
+// and fit in one byte.
+class serializer {
+    std::string &out;
+
+    void write_uint(std::uint64_t u)
+    {
+        while (u >= 0x80u) {
+            out.push_back(static_cast<char>((u & 0x7fu) | 0x80u));
+            u >>= 7;
+        }
+        out.push_back(static_cast<char>(u));
+    }
+
+    template<class SourceNode>
+    void write_location(SourceNode const& node)
+    {
+        auto const& l = node->location;
+        write_uint(l.offset);
+        write_uint(l.length);
+        write(l.file != source_files::no_file);
+    }
+
+public:
+
+    explicit serializer(std::string &o) noexcept
+        : out(o)
+    {}
+
+    void write_header()
+    {
+        write_uint(format_version);
+    }
+
+    void write(bool const b)
+    {
+        out.push_back(b ? '\1' : '\0');
+    }
+
+    void write(char const c)
+    {
+        out.push_back(c);
+    }
+
+    void write(int const i)
+    {
+        // Note: Zigzag encoding to keep small negative values short
+        auto const i64 = static_cast<std::int64_t>(i);
+        write_uint((static_cast<std::uint64_t>(i64) << 1) ^ static_cast<std::uint64_t>(i64 >> 63));
+    }
+
+    void write(unsigned int const u)
+    {
+        write_uint(u);
+    }
+
+    void write(double const d)
+    {
+        char buf[sizeof(double)];
+        std::memcpy(buf, &d, sizeof(double));
+        out.append(buf, sizeof(double));
+    }
+
+    void write(std::string const& s)
+    {
+        write_uint(s.size());
+        out += s;
+    }
+
+    template<class Enum, class = helper::enable_if<std::is_enum<Enum>::value>>
+    void write(Enum const e)
+    {
+        write_uint(static_cast<std::uint64_t>(e));
+    }
+
+    template<class... Nodes>
+    void write(boost::variant<Nodes...> const& v)
+    {
+        write_uint(v.which());
+        helper::variant::apply_lambda([this](auto const& n){ write(n); }, v);
+    }
+
+    template<class T>
+    void write(boost::optional<T> const& o)
+    {
+        write(static_cast<bool>(o));
+        if (o) {
+            write(*o);
+        }
+    }
+
+    template<class T>
+    void write(std::vector<T> const& v)
+    {
+        write_uint(v.size());
+        for (auto const& e : v) {
+            write(e);
+        }
+    }
+
+    template<class T, class U>
+    void write(std::pair<T, U> const& p)
+    {
+        write(p.first);
+        write(p.second);
+    }
+
+    void write(node::primary_literal const& pl)
+    {
+        write_location(pl);
+        write(pl->value);
+    }
+
+    void write(node::symbol_literal const& sl)
+    {
+        write_location(sl);
+        write(sl->value);
+    }
+
+    void write(node::array_literal const& al)
+    {
+        write_location(al);
+        write(al->element_exprs);
+    }
+
+    void write(node::tuple_literal const& tl)
+    {
+        write_location(tl);
+        write(tl->element_exprs);
+    }
+
+    void write(node::string_literal const& sl)
+    {
+        write_location(sl);
+        write(sl->value);
+    }
+
+    void write(node::dict_literal const& dl)
+    {
+        write_location(dl);
+        write(dl->value);
+    }
+
+    void write(node::lambda_expr const& le)
+    {
+        write_location(le);
+        write(le->def);
+        write_location(le->receiver);
+    }
+
+    void write(node::var_ref const& vr)
+    {
+        write_location(vr);
+        write(vr->name);
+    }
+
+    void write(node::parameter const& p)
+    {
+        write_location(p);
+        write(p->is_var);
+        write(p->name);
+        write(p->param_type);
+        write(p->is_receiver);
+    }
+
+    void write(node::func_invocation const& fc)
+    {
+        write_location(fc);
+        write(fc->child);
+        write(fc->args);
+        write(fc->is_ufcs);
+    }
+
+    void write(node::object_construct const& oc)
+    {
+        write_location(oc);
+        write(oc->obj_type);
+        write(oc->args);
+    }
+
+    void write(node::index_access const& ia)
+    {
+        write_location(ia);
+        write(ia->child);
+        write(ia->index_expr);
+        write(ia->is_assign);
+    }
+
+    void write(node::ufcs_invocation const& ui)
+    {
+        write_location(ui);
+        write(ui->child);
+        write(ui->member_name);
+        write(ui->is_assign);
+    }
+
+    void write(node::cast_expr const& ce)
+    {
+        write_location(ce);
+        write(ce->child);
+        write(ce->cast_type);
+    }
+
+    void write(node::unary_expr const& ue)
+    {
+        write_location(ue);
+        write(ue->op);
+        write(ue->expr);
+    }
+
+    void write(node::binary_expr const& be)
+    {
+        write_location(be);
+        write(be->lhs);
+        write(be->op);
+        write(be->rhs);
+    }
+
+    void write(node::block_expr const& be)
+    {
+        write_location(be);
+        write(be->stmts);
+        write(be->last_expr);
+    }
+
+    void write(node::if_expr const& ie)
+    {
+        write_location(ie);
+        write(ie->kind);
+        write(ie->block_list);
+        write(ie->else_block);
+    }
+
+    void write(node::switch_expr const& se)
+    {
+        write_location(se);
+        write(se->target_expr);
+        write(se->when_blocks);
+        write(se->else_block);
+    }
+
+    void write(node::typed_expr const& te)
+    {
+        write_location(te);
+        write(te->child_expr);
+        write(te->specified_type);
+    }
+
+    void write(node::primary_type const& pt)
+    {
+        write_location(pt);
+        write(pt->name);
+        write(pt->template_params);
+    }
+
+    void write(node::tuple_type const& tt)
+    {
+        write_location(tt);
+        write(tt->arg_types);
+    }
+
+    void write(node::func_type const& ft)
+    {
+        write_location(ft);
+        write(ft->arg_types);
+        write(ft->ret_type);
+        write(ft->parens_missing);
+    }
+
+    void write(node::array_type const& at)
+    {
+        write_location(at);
+        write(at->elem_type);
+    }
+
+    void write(node::dict_type const& dt)
+    {
+        write_location(dt);
+        write(dt->key_type);
+        write(dt->value_type);
+    }
+
+    void write(node::pointer_type const& pt)
+    {
+        write_location(pt);
+        write(pt->pointee_type);
+    }
+
+    void write(node::typeof_type const& tt)
+    {
+        write_location(tt);
+        write(tt->expr);
+    }
+
+    void write(node::qualified_type const& qt)
+    {
+        write_location(qt);
+        write(qt->qualifier);
+        write(qt->type);
+    }
+
+    void write(node::assignment_stmt const& as)
+    {
+        write_location(as);
+        write(as->assignees);
+        write(as->op);
+        write(as->rhs_exprs);
+        write(as->rhs_tuple_expansion);
+    }
+
+    void write(node::variable_decl const& vd)
+    {
+        write_location(vd);
+        write(vd->is_var);
+        write(vd->name);
+        write(vd->maybe_type);
+        write(vd->accessibility);
+    }
+
+    void write(node::initialize_stmt const& is)
+    {
+        write_location(is);
+        write(is->var_decls);
+        write(is->maybe_rhs_exprs);
+    }
+
+    void write(node::if_stmt const& is)
+    {
+        write_location(is);
+        write(is->kind);
+        write(is->clauses);
+        write(is->maybe_else_clause);
+    }
+
+    void write(node::return_stmt const& rs)
+    {
+        write_location(rs);
+        write(rs->ret_exprs);
+    }
+
+    void write(node::switch_stmt const& ss)
+    {
+        write_location(ss);
+        write(ss->target_expr);
+        write(ss->when_stmts_list);
+        write(ss->maybe_else_stmts);
+    }
+
+    void write(node::for_stmt const& fs)
+    {
+        write_location(fs);
+        write(fs->iter_vars);
+        write(fs->range_expr);
+        write(fs->body_stmts);
+    }
+
+    void write(node::while_stmt const& ws)
+    {
+        write_location(ws);
+        write(ws->condition);
+        write(ws->body_stmts);
+    }
+
+    void write(node::postfix_if_stmt const& pif)
+    {
+        write_location(pif);
+        write(pif->body);
+        write(pif->kind);
+        write(pif->condition);
+    }
+
+    void write(node::statement_block const& sb)
+    {
+        write_location(sb);
+        write(sb->value);
+    }
+
+    void write(node::function_definition const& fd)
+    {
+        write_location(fd);
+        write(fd->kind);
+        write(fd->name);
+        write(fd->params);
+        write(fd->return_type);
+        write(fd->body);
+        write(fd->ensure_body);
+        write(fd->accessibility);
+    }
+
+    void write(node::class_definition const& cd)
+    {
+        write_location(cd);
+        write(cd->name);
+        write(cd->instance_vars);
+        write(cd->member_funcs);
+    }
+
+    void write(node::import const& i)
+    {
+        write_location(i);
+        write(i->path);
+    }
+
+    void write(node::inu const& p)
+    {
+        write_location(p);
+        write(p->functions);
+        write(p->global_constants);
+        write(p->classes);
+        write(p->imports);
+    }
+};
+
+struct malformed_data final : public std::runtime_error {
+    malformed_data()
+        : std::runtime_error("Malformed serialized AST")
+    {}
+};
+
+class deserializer {
+    char const* current;
+    char const* const last;
+    file_id_type const file;
+
+    std::uint64_t read_uint()
+    {
+        std::uint64_t result = 0u;
+        for (unsigned int shift = 0u; shift < 64u; shift += 7u) {
+            if (current == last) {
+                throw malformed_data{};
+            }
+            auto const byte = static_cast<unsigned char>(*current++);
+            result |= static_cast<std::uint64_t>(byte & 0x7fu) << shift;
+            if ((byte & 0x80u) == 0u) {
+                return result;
+            }
+        }
+        throw malformed_data{};
+    }
+
+    std::uint32_t read_uint32()
+    {
+        auto const u = read_uint();
+        if (u > 0xffffffffu) {
+            throw malformed_data{};
+        }
+        return static_cast<std::uint32_t>(u);
+    }
+
+    size_t read_size()
+    {
+        auto const size = read_uint();
+
+        // Note:
+        // Every element consumes at least one byte.  This rejects broken
+        // sizes before reserving huge memory.
+        if (size > static_cast<std::uint64_t>(last - current)) {
+            throw malformed_data{};
+        }
+
+        return static_cast<size_t>(size);
+    }
+
+    location_type read_location()
+    {
+        location_type l;
+        l.offset = read_uint32();
+        l.length = read_uint32();
+        if (get<bool>()) {
+            l.file = file;
+        }
+        return l;
+    }
+
+    template<class Node, class... Args>
+    auto make_node(location_type const& location, Args &&... args)
+    {
+        auto node = make<Node>(std::forward<Args>(args)...);
+        node->location = location;
+        return node;
+    }
+
+    template<class T>
+    T get()
+    {
+        T t;
+        read(t);
+        return t;
+    }
+
+    template<class Alternative, class Variant>
+    void read_alternative(Variant &v)
+    {
+        v = get<Alternative>();
+    }
+
+public:
+
+    deserializer(std::string const& data, file_id_type const f) noexcept
+        : current(data.data()), last(data.data() + data.size()), file(f)
+    {}
+
+    bool read_header()
+    {
+        return read_uint() == format_version;
+    }
+
+    bool consumed_all() const noexcept
+    {
+        return current == last;
+    }
+
+    void read(bool &b)
+    {
+        if (current == last) {
+            throw malformed_data{};
+        }
+        b = *current++ != '\0';
+    }
+
+    void read(char &c)
+    {
+        if (current == last) {
+            throw malformed_data{};
+        }
+        c = *current++;
+    }
+
+    void read(int &i)
+    {
+        auto const u = read_uint();
+        i = static_cast<int>(static_cast<std::int64_t>(u >> 1) ^ -static_cast<std::int64_t>(u & 1u));
+    }
+
+    void read(unsigned int &u)
+    {
+        u = static_cast<unsigned int>(read_uint());
+    }
+
+    void read(double &d)
+    {
+        if (static_cast<size_t>(last - current) < sizeof(double)) {
+            throw malformed_data{};
+        }
+        std::memcpy(&d, current, sizeof(double));
+        current += sizeof(double);
+    }
+
+    void read(std::string &s)
+    {
+        auto const size = read_size();
+        s.assign(current, size);
+        current += size;
+    }
+
+    template<class Enum, class = helper::enable_if<std::is_enum<Enum>::value>>
+    void read(Enum &e)
+    {
+        e = static_cast<Enum>(read_uint());
+    }
+
+    template<class... Nodes>
+    void read(boost::variant<Nodes...> &v)
+    {
+        using variant_type = boost::variant<Nodes...>;
+        using reader_type = void (deserializer::*)(variant_type &);
+
+        static reader_type const readers[] = {&deserializer::read_alternative<Nodes, variant_type>...};
+
+        auto const which = read_uint();
+        if (which >= sizeof...(Nodes)) {
+            throw malformed_data{};
+        }
+
+        (this->*readers[which])(v);
+    }
+
+    template<class T>
+    void read(boost::optional<T> &o)
+    {
+        if (get<bool>()) {
+            o = get<T>();
+        } else {
+            o = boost::none;
+        }
+    }
+
+    template<class T>
+    void read(std::vector<T> &v)
+    {
+        auto const size = read_size();
+        v.clear();
+        v.reserve(size);
+        for (size_t i = 0u; i < size; ++i) {
+            v.push_back(get<T>());
+        }
+    }
+
+    template<class T, class U>
+    void read(std::pair<T, U> &p)
+    {
+        read(p.first);
+        read(p.second);
+    }
+
+    void read(node::primary_literal &pl)
+    {
+        auto const location = read_location();
+        auto const value = get<decltype(pl->value)>();
+        pl = make_node<node::primary_literal>(location, value);
+    }
+
+    void read(node::symbol_literal &sl)
+    {
+        auto const location = read_location();
+        auto const value = get<std::string>();
+        sl = make_node<node::symbol_literal>(location, value);
+    }
+
+    void read(node::array_literal &al)
+    {
+        auto const location = read_location();
+        auto const elems = get<std::vector<node::any_expr>>();
+        al = make_node<node::array_literal>(location, elems);
+    }
+
+    void read(node::tuple_literal &tl)
+    {
+        auto const location = read_location();
+        auto const elems = get<std::vector<node::any_expr>>();
+        tl = make_node<node::tuple_literal>(location, elems);
+    }
+
+    void read(node::string_literal &sl)
+    {
+        auto location = read_location();
+        auto value = get<std::string>();
+        sl = make_node<node::string_literal>(location, std::move(value));
+    }
+
+    void read(node::dict_literal &dl)
+    {
+        auto const location = read_location();
+        auto const value = get<node_type::dict_literal::value_type>();
+        dl = make_node<node::dict_literal>(location, value);
+    }
+
+    void read(node::lambda_expr &le)
+    {
+        auto const location = read_location();
+        auto const def = get<node::function_definition>();
+        le = make_node<node::lambda_expr>(location, def);
+        le->receiver->location = read_location();
+    }
+
+    void read(node::var_ref &vr)
+    {
+        auto const location = read_location();
+        auto const name = get<std::string>();
+        vr = make_node<node::var_ref>(location, name);
+    }
+
+    void read(node::parameter &p)
+    {
+        auto const location = read_location();
+        auto const is_var = get<bool>();
+        auto const name = get<std::string>();
+        auto const param_type = get<boost::optional<node::any_type>>();
+        auto const is_receiver = get<bool>();
+        p = make_node<node::parameter>(location, is_var, name, param_type, is_receiver);
+    }
+
+    void read(node::func_invocation &fc)
+    {
+        auto const location = read_location();
+        auto const child = get<node::any_expr>();
+        auto const args = get<std::vector<node::any_expr>>();
+        auto const is_ufcs = get<bool>();
+        fc = make_node<node::func_invocation>(location, child, args, is_ufcs);
+    }
+
+    void read(node::object_construct &oc)
+    {
+        auto const location = read_location();
+        auto const obj_type = get<node::any_type>();
+        auto const args = get<std::vector<node::any_expr>>();
+        oc = make_node<node::object_construct>(location, obj_type, args);
+    }
+
+    void read(node::index_access &ia)
+    {
+        auto const location = read_location();
+        auto const child = get<node::any_expr>();
+        auto const index_expr = get<node::any_expr>();
+        auto const is_assign = get<bool>();
+        ia = make_node<node::index_access>(location, child, index_expr, is_assign);
+    }
+
+    void read(node::ufcs_invocation &ui)
+    {
+        auto const location = read_location();
+        auto const child = get<node::any_expr>();
+        auto const member_name = get<std::string>();
+        auto const is_assign = get<bool>();
+        ui = make_node<node::ufcs_invocation>(location, child, member_name, is_assign);
+    }
+
+    void read(node::cast_expr &ce)
+    {
+        auto const location = read_location();
+        auto const child = get<node::any_expr>();
+        auto const cast_type = get<node::any_type>();
+        ce = make_node<node::cast_expr>(location, child, cast_type);
+    }
+
+    void read(node::unary_expr &ue)
+    {
+        auto const location = read_location();
+        auto const op = get<std::string>();
+        auto const expr = get<node::any_expr>();
+        ue = make_node<node::unary_expr>(location, op, expr);
+    }
+
+    void read(node::binary_expr &be)
+    {
+        auto const location = read_location();
+        auto const lhs = get<node::any_expr>();
+        auto const op = get<std::string>();
+        auto const rhs = get<node::any_expr>();
+        be = make_node<node::binary_expr>(location, lhs, op, rhs);
+    }
+
+    void read(node::block_expr &be)
+    {
+        auto const location = read_location();
+        auto const stmts = get<node_type::block_expr::block_type>();
+        auto const last_expr = get<node::any_expr>();
+        be = make_node<node::block_expr>(location, stmts, last_expr);
+    }
+
+    void read(node::if_expr &ie)
+    {
+        auto const location = read_location();
+        auto const kind = get<symbol::if_kind>();
+        auto const block_list = get<std::vector<node_type::if_expr::block_type>>();
+        auto const else_block = get<node::block_expr>();
+        ie = make_node<node::if_expr>(location, kind, block_list, else_block);
+    }
+
+    void read(node::switch_expr &se)
+    {
+        auto const location = read_location();
+        auto const target_expr = get<node::any_expr>();
+        auto const when_blocks = get<std::vector<node_type::switch_expr::when_type>>();
+        auto const else_block = get<node::block_expr>();
+        se = make_node<node::switch_expr>(location, target_expr, when_blocks, else_block);
+    }
+
+    void read(node::typed_expr &te)
+    {
+        auto const location = read_location();
+        auto const child_expr = get<node::any_expr>();
+        auto const specified_type = get<node::any_type>();
+        te = make_node<node::typed_expr>(location, child_expr, specified_type);
+    }
+
+    void read(node::primary_type &pt)
+    {
+        auto const location = read_location();
+        auto const name = get<std::string>();
+        auto const template_params = get<std::vector<node::any_type>>();
+        pt = make_node<node::primary_type>(location, name, template_params);
+    }
+
+    void read(node::tuple_type &tt)
+    {
+        auto const location = read_location();
+        auto const arg_types = get<std::vector<node::any_type>>();
+        tt = make_node<node::tuple_type>(location, arg_types);
+    }
+
+    void read(node::func_type &ft)
+    {
+        auto const location = read_location();
+        auto const arg_types = get<std::vector<node::any_type>>();
+        auto const ret_type = get<boost::optional<node::any_type>>();
+        auto const parens_missing = get<bool>();
+        ft = make_node<node::func_type>(location, arg_types, ret_type, parens_missing);
+    }
+
+    void read(node::array_type &at)
+    {
+        auto const location = read_location();
+        auto const elem_type = get<boost::optional<node::any_type>>();
+        at = make_node<node::array_type>(location, elem_type);
+    }
+
+    void read(node::dict_type &dt)
+    {
+        auto const location = read_location();
+        auto const key_type = get<node::any_type>();
+        auto const value_type = get<node::any_type>();
+        dt = make_node<node::dict_type>(location, key_type, value_type);
+    }
+
+    void read(node::pointer_type &pt)
+    {
+        auto const location = read_location();
+        auto const pointee_type = get<boost::optional<node::any_type>>();
+        pt = make_node<node::pointer_type>(location, pointee_type);
+    }
+
+    void read(node::typeof_type &tt)
+    {
+        auto const location = read_location();
+        auto const expr = get<node::any_expr>();
+        tt = make_node<node::typeof_type>(location, expr);
+    }
+
+    void read(node::qualified_type &qt)
+    {
+        auto const location = read_location();
+        auto const qualifier = get<symbol::qualifier>();
+        auto const type = get<node::any_type>();
+        qt = make_node<node::qualified_type>(location, qualifier, type);
+    }
+
+    void read(node::assignment_stmt &as)
+    {
+        auto const location = read_location();
+        auto const assignees = get<std::vector<node::any_expr>>();
+        auto const op = get<std::string>();
+        auto const rhs_exprs = get<std::vector<node::any_expr>>();
+        auto const rhs_tuple_expansion = get<bool>();
+        as = make_node<node::assignment_stmt>(location, assignees, op, rhs_exprs, rhs_tuple_expansion);
+    }
+
+    void read(node::variable_decl &vd)
+    {
+        auto const location = read_location();
+        auto const is_var = get<bool>();
+        auto const name = get<std::string>();
+        auto const maybe_type = get<boost::optional<node::any_type>>();
+        auto const accessibility = get<boost::optional<bool>>();
+        vd = make_node<node::variable_decl>(location, is_var, name, maybe_type, accessibility);
+    }
+
+    void read(node::initialize_stmt &is)
+    {
+        auto const location = read_location();
+        auto const var_decls = get<std::vector<node::variable_decl>>();
+        auto const maybe_rhs_exprs = get<boost::optional<std::vector<node::any_expr>>>();
+        is = make_node<node::initialize_stmt>(location, var_decls, maybe_rhs_exprs);
+    }
+
+    void read(node::if_stmt &is)
+    {
+        auto const location = read_location();
+        auto const kind = get<symbol::if_kind>();
+        auto const clauses = get<std::vector<node_type::if_stmt::clause_type>>();
+        auto const maybe_else_clause = get<boost::optional<node::statement_block>>();
+        is = make_node<node::if_stmt>(location, kind, clauses, maybe_else_clause);
+    }
+
+    void read(node::return_stmt &rs)
+    {
+        auto const location = read_location();
+        auto const ret_exprs = get<std::vector<node::any_expr>>();
+        rs = make_node<node::return_stmt>(location, ret_exprs);
+    }
+
+    void read(node::switch_stmt &ss)
+    {
+        auto const location = read_location();
+        auto const target_expr = get<node::any_expr>();
+        auto const when_stmts_list = get<std::vector<node_type::switch_stmt::when_type>>();
+        auto const maybe_else_stmts = get<boost::optional<node::statement_block>>();
+        ss = make_node<node::switch_stmt>(location, target_expr, when_stmts_list, maybe_else_stmts);
+    }
+
+    void read(node::for_stmt &fs)
+    {
+        auto const location = read_location();
+        auto const iter_vars = get<std::vector<node::parameter>>();
+        auto const range_expr = get<node::any_expr>();
+        auto const body_stmts = get<node::statement_block>();
+        fs = make_node<node::for_stmt>(location, iter_vars, range_expr, body_stmts);
+    }
+
+    void read(node::while_stmt &ws)
+    {
+        auto const location = read_location();
+        auto const condition = get<node::any_expr>();
+        auto const body_stmts = get<node::statement_block>();
+        ws = make_node<node::while_stmt>(location, condition, body_stmts);
+    }
+
+    void read(node::postfix_if_stmt &pif)
+    {
+        auto const location = read_location();
+        auto const body = get<node_type::postfix_if_stmt::body_type>();
+        auto const kind = get<symbol::if_kind>();
+        auto const condition = get<node::any_expr>();
+        pif = make_node<node::postfix_if_stmt>(location, body, kind, condition);
+    }
+
+    void read(node::statement_block &sb)
+    {
+        auto const location = read_location();
+        auto const value = get<node_type::statement_block::block_type>();
+        sb = make_node<node::statement_block>(location, value);
+    }
+
+    void read(node::function_definition &fd)
+    {
+        auto const location = read_location();
+        auto const kind = get<symbol::func_kind>();
+        auto const name = get<std::string>();
+        auto const params = get<std::vector<node::parameter>>();
+        auto const return_type = get<boost::optional<node::any_type>>();
+        auto const body = get<node::statement_block>();
+        auto const ensure_body = get<boost::optional<node::statement_block>>();
+        auto const accessibility = get<boost::optional<bool>>();
+        fd = make_node<node::function_definition>(location, kind, name, params, return_type, body, ensure_body, accessibility);
+    }
+
+    void read(node::class_definition &cd)
+    {
+        auto const location = read_location();
+        auto const name = get<std::string>();
+        auto const instance_vars = get<std::vector<node::variable_decl>>();
+        auto const member_funcs = get<std::vector<node::function_definition>>();
+        cd = make_node<node::class_definition>(location, name, instance_vars, member_funcs);
+    }
+
+    void read(node::import &i)
+    {
+        auto const location = read_location();
+        auto const path = get<std::string>();
+        i = make_node<node::import>(location, path);
+    }
+
+    void read(node::inu &p)
+    {
+        auto const location = read_location();
+        auto const functions = get<std::vector<node::function_definition>>();
+        auto const global_constants = get<std::vector<node::initialize_stmt>>();
+        auto const classes = get<std::vector<node::class_definition>>();
+        auto const imports = get<std::vector<node::import>>();
+        p = make_node<node::inu>(location, functions, global_constants, classes, imports);
+    }
+};
+
+} // namespace detail
+
+std::string serialize_ast(node::inu const& root)
+{
+    std::string data;
+    detail::serializer s{data};
+    s.write_header();
+    s.write(root);
+    return data;
+}
+
+boost::optional<node::inu> deserialize_ast(std::string const& data, file_id_type const file)
+{
+    detail::deserializer d{data, file};
+
+    try {
+        if (!d.read_header()) {
+            return boost::none;
+        }
+
+        node::inu root;
+        d.read(root);
+
+        if (!d.consumed_all()) {
+            return boost::none;
+        }
+
+        return root;
+    } catch (detail::malformed_data const&) {
+        return boost::none;
+    }
+}
+
+} // namespace ast
+} // namespace dachs
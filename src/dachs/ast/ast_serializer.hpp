@@ -0,0 +1,29 @@
+#if !defined DACHS_AST_AST_SERIALIZER_HPP_INCLUDED
+#define      DACHS_AST_AST_SERIALIZER_HPP_INCLUDED
+
+#include <string>
+
+#include <boost/optional.hpp>
+
+#include "dachs/ast/ast_fwd.hpp"
+
+namespace dachs {
+namespace ast {
+
+// Note:
+// Serialize the syntactic part of AST into compact binary data.
+// Semantic information (scopes, symbols and types) is not included because
+// it is per-program and is constructed again by semantic analysis.
+// All locations in one serialized AST are assumed to be in the same source
+// file.  It is not stored in the data and given on deserialization.
+std::string serialize_ast(node::inu const& root);
+
+// Note:
+// Return boost::none when the data is broken or was serialized with
+// another version of the format.
+boost::optional<node::inu> deserialize_ast(std::string const& data, file_id_type const file);
+
+} // namespace ast
+} // namespace dachs
+
+#endif    // DACHS_AST_AST_SERIALIZER_HPP_INCLUDED
@@ -0,0 +1,136 @@
+#if !defined DACHS_AST_NODE_ARENA_HPP_INCLUDED
+#define      DACHS_AST_NODE_ARENA_HPP_INCLUDED
+
+#include <memory>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+#include "dachs/helper/make.hpp"
+
+namespace dachs {
+namespace ast {
+
+// Note:
+// Monotonic memory arena for AST nodes.  Nodes of one parse are allocated in
+// large chunks, one heap allocation per chunk instead of one per node.  Memory
+// of each node is never released on its own.  All chunks are released at once
+// when the arena is destroyed.
+// This class is not thread-safe.  One arena must be used by one parse.
+class node_arena final {
+    static constexpr std::size_t chunk_size = 64u * 1024u;
+
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char *next = nullptr;
+    std::size_t rest = 0u;
+
+    static std::size_t padding_for(char const* const p, std::size_t const align) noexcept
+    {
+        return (align - reinterpret_cast<std::uintptr_t>(p) % align) % align;
+    }
+
+public:
+
+    node_arena() = default;
+    node_arena(node_arena const&) = delete;
+    node_arena &operator=(node_arena const&) = delete;
+
+    void *allocate(std::size_t const size, std::size_t const align)
+    {
+        // Note:
+        // A large object gets its own chunk not to waste the rest of the current one.
+        if (size + align > chunk_size / 4u) {
+            chunks.emplace_back(new char[size + align]);
+            auto *const p = chunks.back().get();
+            return p + padding_for(p, align);
+        }
+
+        auto padding = padding_for(next, align);
+        if (!next || padding + size > rest) {
+            chunks.emplace_back(new char[chunk_size]);
+            next = chunks.back().get();
+            rest = chunk_size;
+            padding = padding_for(next, align);
+        }
+
+        auto *const p = next + padding;
+        next = p + size;
+        rest -= padding + size;
+        return p;
+    }
+
+    std::size_t num_chunks() const noexcept
+    {
+        return chunks.size();
+    }
+};
+
+// Note:
+// Allocator passed to std::allocate_shared().  Each node shares the ownership
+// of the arena through the allocator in its control block.  So the arena
+// lives until the last node allocated from it is destroyed, even after the
+// ast::ast is gone (e.g. nodes referred from scopes).
+template<class T>
+class node_allocator {
+    template<class U>
+    friend class node_allocator;
+
+    std::shared_ptr<node_arena> arena;
+
+public:
+
+    using value_type = T;
+
+    explicit node_allocator(std::shared_ptr<node_arena> const& a) noexcept
+        : arena(a)
+    {}
+
+    template<class U>
+    node_allocator(node_allocator<U> const& other) noexcept
+        : arena(other.arena)
+    {}
+
+    T *allocate(std::size_t const n)
+    {
+        return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *const, std::size_t const) noexcept
+    {
+        // Note:
+        // Memory is released with the arena.
+    }
+
+    template<class U>
+    bool operator==(node_allocator<U> const& rhs) const noexcept
+    {
+        return arena == rhs.arena;
+    }
+
+    template<class U>
+    bool operator!=(node_allocator<U> const& rhs) const noexcept
+    {
+        return arena != rhs.arena;
+    }
+};
+
+// Note:
+// Equivalent to helper::make<>() when 'arena' is null.
+template<class Ptr, class... Args>
+inline Ptr make_in(std::shared_ptr<node_arena> const& arena, Args &&... args)
+{
+    static_assert(helper::is_shared_ptr<Ptr>::value, "make_in<>(): Ptr is not shared_ptr.");
+    using element_type = typename Ptr::element_type;
+
+    if (!arena) {
+        return std::make_shared<element_type>(std::forward<Args>(args)...);
+    }
+
+    return std::allocate_shared<element_type>(node_allocator<element_type>{arena}, std::forward<Args>(args)...);
+}
+
+} // namespace ast
+} // namespace dachs
+
+#endif    // DACHS_AST_NODE_ARENA_HPP_INCLUDED
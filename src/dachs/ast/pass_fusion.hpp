@@ -0,0 +1,153 @@
+#if !defined DACHS_AST_PASS_FUSION_HPP_INCLUDED
+#define      DACHS_AST_PASS_FUSION_HPP_INCLUDED
+
+#include <array>
+#include <tuple>
+#include <utility>
+#include <initializer_list>
+#include <cstddef>
+
+#include "dachs/ast/ast_walker.hpp"
+
+namespace dachs {
+namespace ast {
+
+// Note:
+// Framework to fuse passes over AST into one walk.
+// A pass doesn't walk AST by itself.  It has callbacks which are called by a walk
+// shared with other passes.
+//   - enter(node) : Called before the children of the node are visited.  When it
+//                   returns false, the pass doesn't see the children of the node.
+//                   Other passes still see them.
+//   - leave(node) : Called after the children of the node are visited.  It is called
+//                   if and only if enter() was called for the node.
+// A pass must have catch-all templates of both callbacks for the nodes it doesn't care.
+// Callbacks of passes are called in the order of registration.
+//
+// fused_passes<> is a visitor for ast::walker.  It walks AST once and dispatches each
+// node to all registered passes.  The walk doesn't descend into the children of a node
+// when no pass wants to see them.
+template<class... Passes>
+class fused_passes {
+    std::tuple<Passes &...> passes;
+
+    // Note:
+    // 0 means that the pass is active.  Otherwise, it is the depth of the node where
+    // the pass stopped to see the children.
+    std::array<std::size_t, sizeof...(Passes)> stopped_at;
+    std::size_t depth = 0u;
+
+    template<std::size_t I, class Node>
+    void enter_pass(Node &node, bool &descends)
+    {
+        if (stopped_at[I] != 0u) {
+            return;
+        }
+
+        if (std::get<I>(passes).enter(node)) {
+            descends = true;
+        } else {
+            stopped_at[I] = depth;
+        }
+    }
+
+    template<std::size_t I, class Node>
+    void leave_pass(Node &node)
+    {
+        if (stopped_at[I] == 0u) {
+            std::get<I>(passes).leave(node);
+        } else if (stopped_at[I] == depth) {
+            std::get<I>(passes).leave(node);
+            stopped_at[I] = 0u;
+        }
+    }
+
+    template<class Node, std::size_t... I>
+    bool enter_all(Node &node, std::index_sequence<I...>)
+    {
+        bool descends = false;
+        (void) std::initializer_list<int>{(enter_pass<I>(node, descends), 0)...};
+        return descends;
+    }
+
+    template<class Node, std::size_t... I>
+    void leave_all(Node &node, std::index_sequence<I...>)
+    {
+        (void) std::initializer_list<int>{(leave_pass<I>(node), 0)...};
+    }
+
+public:
+
+    explicit fused_passes(Passes &... ps) noexcept
+        : passes(ps...)
+    {
+        stopped_at.fill(0u);
+    }
+
+    // Note:
+    // @return : true if some pass wants to see the children of the node
+    template<class Node>
+    bool enter(Node &node)
+    {
+        ++depth;
+        return enter_all(node, std::index_sequence_for<Passes...>{});
+    }
+
+    template<class Node>
+    void leave(Node &node)
+    {
+        leave_all(node, std::index_sequence_for<Passes...>{});
+        --depth;
+    }
+
+    template<class Node, class Walker>
+    void visit(Node &node, Walker const& w)
+    {
+        if (enter(node)) {
+            w();
+        }
+        leave(node);
+    }
+};
+
+template<class... Passes>
+inline auto fuse_passes(Passes &... ps) noexcept
+{
+    return fused_passes<Passes...>{ps...};
+}
+
+// Note:
+// Registers passes to the walk of another visitor (e.g. symbol analyzer).  The visitor
+// controls the walk and the passes only observe it.  enter() of the passes is called
+// before the visitor visits the node and leave() is called after that.  So a pass can
+// see the results of the visitor in leave().
+template<class Visitor, class Passes>
+class observed_visitor {
+    Visitor &visitor;
+    Passes &passes;
+
+public:
+
+    observed_visitor(Visitor &v, Passes &ps) noexcept
+        : visitor(v), passes(ps)
+    {}
+
+    template<class Node, class Walker>
+    void visit(Node &node, Walker const& w)
+    {
+        passes.enter(node);
+        visitor.visit(node, w);
+        passes.leave(node);
+    }
+};
+
+template<class Visitor, class Passes>
+inline auto observe(Visitor &v, Passes &ps) noexcept
+{
+    return observed_visitor<Visitor, Passes>{v, ps};
+}
+
+} // namespace ast
+} // namespace dachs
+
+#endif    // DACHS_AST_PASS_FUSION_HPP_INCLUDED
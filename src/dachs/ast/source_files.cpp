@@ -0,0 +1,295 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+#include <iterator>
+
+#include "dachs/ast/source_files.hpp"
+#include "dachs/helper/source_buffer.hpp"
+
+namespace dachs {
+namespace ast {
+namespace source_files {
+
+namespace detail {
+
+// Note:
+// Column of 'offset' in the line starting at 'line_start'.
+std::size_t column_of(char const* const code, std::size_t const line_start, std::size_t const offset)
+{
+    std::size_t col = 1u;
+    for (auto i = line_start; i < offset; ++i) {
+        if (code[i] == '\t') {
+            col += 4u - (col - 1u) % 4u;
+        } else {
+            ++col;
+        }
+    }
+    return col;
+}
+
+struct source_file {
+    boost::filesystem::path path;
+    std::shared_ptr<helper::source_buffer const> code;
+
+    // Note:
+    // Offsets where lines start and their line numbers.  A line starts after
+    // each '\r' or '\n' but "\r\n" is counted as one line break.  It is the same
+    // as boost::spirit::line_pos_iterator and get_column().
+    std::vector<std::uint32_t> line_starts;
+    std::vector<std::uint32_t> line_numbers;
+
+    bool loaded = false;
+
+    void load(std::shared_ptr<helper::source_buffer const> const& c)
+    {
+        code = c;
+        line_starts = {0u};
+        line_numbers = {1u};
+
+        std::uint32_t line = 1u;
+        char prev = '\0';
+        auto const data = code->data();
+        for (std::size_t i = 0u; i < code->size(); ++i) {
+            auto const c = data[i];
+            if ((c == '\r' && prev != '\n') || (c == '\n' && prev != '\r')) {
+                ++line;
+            }
+            if (c == '\r' || c == '\n') {
+                line_starts.push_back(static_cast<std::uint32_t>(i + 1u));
+                line_numbers.push_back(line);
+            }
+            prev = c;
+        }
+
+        loaded = true;
+    }
+
+    std::pair<std::size_t, std::size_t> line_col_of(std::uint32_t const offset) const
+    {
+        auto const next_line = std::upper_bound(std::begin(line_starts), std::end(line_starts), offset);
+        auto const idx = static_cast<std::size_t>(std::distance(std::begin(line_starts), next_line)) - 1u;
+
+        auto const last = std::min<std::size_t>(offset, code->size());
+        return {line_numbers[idx], column_of(code->data(), line_starts[idx], last)};
+    }
+};
+
+class registry final {
+    std::mutex mutex;
+    file_id_type last_id = no_file;
+    std::unordered_map<file_id_type, std::shared_ptr<source_file>> files;
+    std::unordered_map<std::string, std::vector<file_id_type>> ids_of_path;
+
+    file_id_type push(std::shared_ptr<source_file> && file)
+    {
+        auto const id = ++last_id;
+        ids_of_path[file->path.string()].push_back(id);
+        files.emplace(id, std::move(file));
+        return id;
+    }
+
+    std::shared_ptr<source_file> latest(boost::filesystem::path const& path, file_id_type &id) const
+    {
+        auto const found = ids_of_path.find(path.string());
+        if (found == std::end(ids_of_path)) {
+            return nullptr;
+        }
+        id = found->second.back();
+        return files.at(id);
+    }
+
+    std::shared_ptr<source_file> find(file_id_type const id) const
+    {
+        auto const found = files.find(id);
+        return found == std::end(files) ? nullptr : found->second;
+    }
+
+public:
+
+    // Note:
+    // 'Buffer' is std::string or helper::source_buffer.  The code is copied only
+    // when a new entry is registered for std::string.
+    template<class Buffer, class Equal, class Share>
+    file_id_type add(boost::filesystem::path const& path, Buffer const& code, Equal const& equal, Share const& share)
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            file_id_type id = no_file;
+            auto const f = latest(path, id);
+            if (f && f->loaded && equal(*f->code, code)) {
+                return id;
+            }
+        }
+
+        // Note:
+        // Build the line table outside the lock.
+        auto file = std::make_shared<source_file>();
+        file->path = path;
+        file->load(share(code));
+
+        std::lock_guard<std::mutex> lock{mutex};
+        return push(std::move(file));
+    }
+
+    file_id_type add(boost::filesystem::path const& path)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        file_id_type id = no_file;
+        if (latest(path, id)) {
+            return id;
+        }
+
+        auto file = std::make_shared<source_file>();
+        file->path = path;
+        return push(std::move(file));
+    }
+
+    void release(boost::filesystem::path const& path)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto const found = ids_of_path.find(path.string());
+        if (found == std::end(ids_of_path)) {
+            return;
+        }
+
+        for (auto const id : found->second) {
+            files.erase(id);
+        }
+        ids_of_path.erase(found);
+    }
+
+    std::shared_ptr<source_file const> get(file_id_type const id)
+    {
+        if (id == no_file) {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        return find(id);
+    }
+
+    std::shared_ptr<source_file const> get_loaded(file_id_type const id)
+    {
+        if (id == no_file) {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        auto const f = find(id);
+        if (!f) {
+            return nullptr;
+        }
+
+        if (!f->loaded) {
+            // Note:
+            // The entry may be kept for a long time.  Don't map the file.
+            auto const code = helper::source_buffer::read(f->path.string());
+            f->load(code ? code : helper::source_buffer::from_string(""));
+        }
+        return f;
+    }
+};
+
+registry &get_registry()
+{
+    static registry r;
+    return r;
+}
+
+} // namespace detail
+
+file_id_type add(boost::filesystem::path const& path, std::string const& code)
+{
+    return detail::get_registry().add(
+            path,
+            code,
+            [](helper::source_buffer const& registered, std::string const& c){ return registered.equals(c); },
+            [](std::string const& c){ return helper::source_buffer::from_string(c); }
+        );
+}
+
+file_id_type add(boost::filesystem::path const& path, std::shared_ptr<helper::source_buffer const> const& code)
+{
+    return detail::get_registry().add(
+            path,
+            *code,
+            [](helper::source_buffer const& registered, helper::source_buffer const& c)
+            {
+                if (&registered == &c) {
+                    return true;
+                }
+
+                // Note:
+                // A mapping reflects the current content of the file.  When the file was
+                // rewritten in place, comparing it with a new buffer of the file compares
+                // the new content with itself.  So mapped code is compared by the identity
+                // (inode and modification time) of the file.
+                if (registered.is_mapped() || c.is_mapped()) {
+                    return registered.identity() == c.identity();
+                }
+
+                return registered.size() == c.size() && std::equal(c.begin(), c.end(), registered.begin());
+            },
+            [&code](helper::source_buffer const&){ return code; }
+        );
+}
+
+file_id_type add(boost::filesystem::path const& path)
+{
+    return detail::get_registry().add(path);
+}
+
+void release(boost::filesystem::path const& path)
+{
+    detail::get_registry().release(path);
+}
+
+boost::filesystem::path path_of(file_id_type const id)
+{
+    auto const file = detail::get_registry().get(id);
+    return file ? file->path : boost::filesystem::path{};
+}
+
+std::pair<std::size_t, std::size_t> line_col_of(file_id_type const id, std::uint32_t const offset)
+{
+    auto const file = detail::get_registry().get_loaded(id);
+    if (!file) {
+        return {0u, 0u};
+    }
+    return file->line_col_of(offset);
+}
+
+std::pair<std::size_t, std::size_t> line_col_in(char const* const code, std::size_t const offset)
+{
+    // Note:
+    // Count line breaks in the same way as source_file::load().
+    std::size_t line = 1u;
+    std::size_t line_start = 0u;
+    char prev = '\0';
+    for (std::size_t i = 0u; i < offset; ++i) {
+        auto const c = code[i];
+        if ((c == '\r' && prev != '\n') || (c == '\n' && prev != '\r')) {
+            ++line;
+        }
+        if (c == '\r' || c == '\n') {
+            line_start = i + 1u;
+        }
+        prev = c;
+    }
+
+    return {line, detail::column_of(code, line_start, offset)};
+}
+
+std::pair<std::size_t, std::size_t> line_col_in(std::string const& code, std::size_t const offset)
+{
+    return line_col_in(code.data(), std::min(offset, code.size()));
+}
+
+} // namespace source_files
+} // namespace ast
+} // namespace dachs
@@ -0,0 +1,72 @@
+#if !defined DACHS_AST_SOURCE_FILES_HPP_INCLUDED
+#define      DACHS_AST_SOURCE_FILES_HPP_INCLUDED
+
+#include <string>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <boost/filesystem/path.hpp>
+
+#include "dachs/helper/source_buffer.hpp"
+
+namespace dachs {
+namespace ast {
+
+using file_id_type = std::uint32_t;
+
+// Note:
+// Process-wide table of parsed source files.  Source locations hold only the
+// file id and the byte offset.  Lines and columns are resolved with the line
+// table of the file only when they are needed (e.g. printing diagnostics).
+// Ids are never reused.  A location remains valid until its file is released
+// with release().  Functions are thread-safe.
+namespace source_files {
+
+// Note:
+// Represents 'no file'.  Line and column of a location in it are always 0.
+constexpr file_id_type const no_file = 0u;
+
+// Note:
+// Register the code parsed from the file and build its line table.
+// The same id is returned while the same code is registered for the path.
+// The code is copied.  Use the overload taking a buffer to share it.
+file_id_type add(boost::filesystem::path const& path, std::string const& code);
+
+// Note:
+// Register the buffer without copying.  It is kept alive until the entry is released.
+// A mapped buffer is regarded as the same code as the registered one only when the
+// file has the same inode and modification time.
+file_id_type add(boost::filesystem::path const& path, std::shared_ptr<helper::source_buffer const> const& code);
+
+// Note:
+// Register the file without its code (e.g. a module restored from the cache).
+// The code is read from the file when its line table is needed at first.
+file_id_type add(boost::filesystem::path const& path);
+
+// Note:
+// Forget all entries registered for the path and free their code and line tables.
+// A long-running process (e.g. the compile server) calls this for the files of
+// a request after the request.  Locations in released entries are treated as
+// locations in 'no_file'.
+void release(boost::filesystem::path const& path);
+
+boost::filesystem::path path_of(file_id_type const id);
+
+// Note:
+// Return 1-based line and column.  Tabs are expanded to 4 columns.
+std::pair<std::size_t, std::size_t> line_col_of(file_id_type const id, std::uint32_t const offset);
+
+// Note:
+// Compute line and column in the code directly without registering it.
+// 'offset' must not exceed the size of the code.
+std::pair<std::size_t, std::size_t> line_col_in(char const* const code, std::size_t const offset);
+std::pair<std::size_t, std::size_t> line_col_in(std::string const& code, std::size_t const offset);
+
+} // namespace source_files
+
+} // namespace ast
+} // namespace dachs
+
+#endif    // DACHS_AST_SOURCE_FILES_HPP_INCLUDED
@@ -9,6 +9,8 @@
 #include <initializer_list>
 #include <cstdint>
 
+#include <boost/optional.hpp>
+
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Value.h>
 #include <llvm/IR/Constants.h>
@@ -24,6 +26,7 @@
 #include "dachs/codegen/llvmir/gc_alloc_emitter.hpp"
 #include "dachs/codegen/llvmir/ir_builder_helper.hpp"
 #include "dachs/exception.hpp"
+#include "dachs/helper/identifier.hpp"
 
 namespace dachs {
 namespace codegen {
@@ -424,45 +427,96 @@ public:
             );
     }
 
-    llvm::Function *emit(std::string const& name, std::vector<type::type> const& arg_types)
+    enum class builtin_func_kind {
+        print,
+        read_cycle_counter,
+        address_of,
+        get_char,
+        fatal,
+        is_null,
+        realloc,
+        free,
+        gen_symbol,
+        enable_gc,
+        disable_gc,
+        gc_disabled,
+    };
+
+    // Note:
+    // Built-in function names are interned at the first call.  So looking up
+    // a name hashes its id and never compares characters.
+    static boost::optional<builtin_func_kind> builtin_func_kind_of(helper::identifier const& name)
+    {
+        using kind = builtin_func_kind;
+        static std::unordered_map<helper::identifier, kind> const kinds = {
+            {"print", kind::print},
+            {"println", kind::print},
+            {"__builtin_read_cycle_counter", kind::read_cycle_counter},
+            {"__builtin_address_of", kind::address_of},
+            {"__builtin_getchar", kind::get_char},
+            {"fatal", kind::fatal},
+            {"__builtin_null?", kind::is_null},
+            {"__builtin_realloc", kind::realloc},
+            {"__builtin_free", kind::free},
+            {"__builtin_gen_symbol", kind::gen_symbol},
+            {"__builtin_enable_gc", kind::enable_gc},
+            {"__builtin_disable_gc", kind::disable_gc},
+            {"__builtin_gc_disabled?", kind::gc_disabled},
+        };
+
+        auto const found = kinds.find(name);
+        if (found == std::end(kinds)) {
+            return boost::none;
+        }
+        return found->second;
+    }
+
+    llvm::Function *emit(helper::identifier const& name, std::vector<type::type> const& arg_types)
     {
-        if (name == "print" || name == "println") {
+        auto const kind = builtin_func_kind_of(name);
+        if (!kind) {
+            return nullptr;
+        }
+
+        switch (*kind) {
+        case builtin_func_kind::print:
             assert(arg_types.size() == 1);
             if (auto const b = type::get<type::builtin_type>(arg_types[0])) {
                 return emit_print_func(name, *b);
             } else if (auto const p = type::get<type::pointer_type>(arg_types[0])) {
                 return emit_print_func(name, *p);
             }
-        } else if (name == "__builtin_read_cycle_counter") {
+            return nullptr;
+        case builtin_func_kind::read_cycle_counter:
             return emit_read_cycle_counter_func();
-        } else if (name == "__builtin_address_of") {
+        case builtin_func_kind::address_of:
             return emit_address_of_func(arg_types[0]);
-        } else if (name == "__builtin_getchar") {
+        case builtin_func_kind::get_char:
             assert(arg_types.empty());
             return emit_getchar_func();
-        } else if (name == "fatal") {
+        case builtin_func_kind::fatal:
             if (arg_types.empty()) {
                 return emit_fatal_func();
             } else {
                 return emit_fatal_func(arg_types[0]);
             }
-        } else if (name == "__builtin_null?") {
+        case builtin_func_kind::is_null:
             return emit_is_null_func(arg_types[0]);
-        } else if (name == "__builtin_realloc") {
+        case builtin_func_kind::realloc:
             return emit_realloc_func(arg_types[0], arg_types[1]);
-        } else if (name == "__builtin_free") {
+        case builtin_func_kind::free:
             return emit_free_func(arg_types[0]);
-        } else if (name == "__builtin_gen_symbol") {
+        case builtin_func_kind::gen_symbol:
             return emit_gen_symbol_func();
-        } else if (name == "__builtin_enable_gc") {
+        case builtin_func_kind::enable_gc:
             return emit_enable_gc_func();
-        } else if (name == "__builtin_disable_gc") {
+        case builtin_func_kind::disable_gc:
             return emit_disable_gc_func();
-        } else if (name == "__builtin_gc_disabled?") {
+        case builtin_func_kind::gc_disabled:
             return emit_gc_disabled_func();
-        } // else ...
-
-        return nullptr;
+        default:
+            return nullptr;
+        }
     }
 };
 
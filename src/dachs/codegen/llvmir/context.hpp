@@ -1,6 +1,8 @@
 #if !defined DACHS_CODEGEN_LLVMIR_CONTEXT_HPP_INCLUDED
 #define      DACHS_CODEGEN_LLVMIR_CONTEXT_HPP_INCLUDED
 
+#include <memory>
+
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/Support/Host.h>
@@ -44,6 +46,7 @@ public:
 class context final : private context_base {
 
     std::string tmp_buffer;
+    std::unique_ptr<llvm::LLVMContext> owned_llvm_context;
 
 public:
 
@@ -74,14 +77,23 @@ public:
     {}
 
     context()
+        : context(nullptr)
+    {}
+
+    // Note:
+    // When 'owned' is not null, this context owns the LLVM context and all modules
+    // created in it.  An LLVMContext must not be shared among threads.  So each
+    // thread emitting LLVM IR concurrently needs its own context created by this.
+    explicit context(std::unique_ptr<llvm::LLVMContext> && owned)
         : context_base()
         , tmp_buffer()
+        , owned_llvm_context(std::move(owned))
         , triple(llvm::sys::getDefaultTargetTriple())
         , target(llvm::TargetRegistry::lookupTarget(triple.getTriple(), tmp_buffer))
         , options()
         , target_machine(target->createTargetMachine(triple.getTriple(), ""/*cpu name*/, ""/*feature*/, options))
         , data_layout(target_machine->getDataLayout())
-        , llvm_context(llvm::getGlobalContext())
+        , llvm_context(owned_llvm_context ? *owned_llvm_context : llvm::getGlobalContext())
         , builder(llvm_context)
     {
         if (!target) {
@@ -97,6 +109,26 @@ public:
         assert(data_layout);
     }
 
+    // Note:
+    // Create a context which owns a new LLVM context and shares the target
+    // (e.g. the target machine) with 'base'.  Creating a target machine is not
+    // cheap and it is never freed.  So long-lived users (e.g. the compile server)
+    // create the target once and share it.  'base' must outlive this context.
+    context(context const& base, std::unique_ptr<llvm::LLVMContext> && owned)
+        : context_base()
+        , tmp_buffer()
+        , owned_llvm_context(std::move(owned))
+        , triple(base.triple)
+        , target(base.target)
+        , options(base.options)
+        , target_machine(base.target_machine)
+        , data_layout(base.data_layout)
+        , llvm_context(*owned_llvm_context)
+        , builder(llvm_context)
+    {
+        assert(owned_llvm_context);
+    }
+
     context(context const&) = delete;
     context &operator=(context const&) = delete;
 };
@@ -1,7 +1,12 @@
 #include <vector>
 #include <string>
+#include <memory>
+#include <utility>
+#include <unordered_set>
+#include <unordered_map>
 #include <cstdlib>
 #include <cstdio>
+#include <cstdint>
 
 #include <boost/format.hpp>
 #include <boost/algorithm/string/join.hpp>
@@ -14,23 +19,205 @@
 #include <llvm/Transforms/IPO/PassManagerBuilder.h>
 #include <llvm/Support/ToolOutputFile.h>
 #include <llvm/Support/FormattedStream.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/DynamicLibrary.h>
+#include <llvm/Support/Program.h>
+#include <llvm/ExecutionEngine/ExecutionEngine.h>
+#include <llvm/ExecutionEngine/MCJIT.h>
+#include <llvm/ExecutionEngine/SectionMemoryManager.h>
 #if (LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR >= 5)
 # include <llvm/Support/FileSystem.h>
 #endif
 
+#include "dachs/runtime.hpp"
 #include "dachs/codegen/llvmir/executable_generator.hpp"
 #include "dachs/exception.hpp"
+#include "dachs/helper/util.hpp"
+#include "dachs/helper/parallel.hpp"
+
+// Note:
+// Functions of Boehm GC called by emitted code.  They are declared here
+// because gc.h is not in the include paths of the compiler.
+extern "C" {
+    void *GC_malloc(std::size_t);
+    void *GC_realloc(void *, std::size_t);
+    void GC_free(void *);
+    void GC_init();
+    void GC_enable();
+    void GC_disable();
+    int GC_is_disabled();
+    void GC_add_roots(void *, void *);
+    void GC_remove_roots(void *, void *);
+}
 
 namespace dachs {
 namespace codegen {
 namespace llvmir {
 
+namespace detail {
+
+std::uint64_t runtime_symbol_address(std::string const& name)
+{
+#define DACHS_RUNTIME_SYMBOL(s) {#s, reinterpret_cast<std::uint64_t>(&s)}
+    static std::unordered_map<std::string, std::uint64_t> const symbols = {
+        DACHS_RUNTIME_SYMBOL(__dachs_gen_symbol__),
+        DACHS_RUNTIME_SYMBOL(__dachs_println_float__),
+        DACHS_RUNTIME_SYMBOL(__dachs_println_int__),
+        DACHS_RUNTIME_SYMBOL(__dachs_println_uint__),
+        DACHS_RUNTIME_SYMBOL(__dachs_println_char__),
+        DACHS_RUNTIME_SYMBOL(__dachs_println_string__),
+        DACHS_RUNTIME_SYMBOL(__dachs_println_symbol__),
+        DACHS_RUNTIME_SYMBOL(__dachs_println_bool__),
+        DACHS_RUNTIME_SYMBOL(__dachs_print_float__),
+        DACHS_RUNTIME_SYMBOL(__dachs_print_int__),
+        DACHS_RUNTIME_SYMBOL(__dachs_print_uint__),
+        DACHS_RUNTIME_SYMBOL(__dachs_print_char__),
+        DACHS_RUNTIME_SYMBOL(__dachs_print_string__),
+        DACHS_RUNTIME_SYMBOL(__dachs_print_symbol__),
+        DACHS_RUNTIME_SYMBOL(__dachs_print_bool__),
+        DACHS_RUNTIME_SYMBOL(__dachs_printf__),
+        DACHS_RUNTIME_SYMBOL(__dachs_getchar__),
+        DACHS_RUNTIME_SYMBOL(__dachs_fatal__),
+        DACHS_RUNTIME_SYMBOL(__dachs_fatal_reason__),
+        DACHS_RUNTIME_SYMBOL(GC_malloc),
+        DACHS_RUNTIME_SYMBOL(GC_realloc),
+        DACHS_RUNTIME_SYMBOL(GC_free),
+        DACHS_RUNTIME_SYMBOL(GC_init),
+        DACHS_RUNTIME_SYMBOL(GC_enable),
+        DACHS_RUNTIME_SYMBOL(GC_disable),
+        DACHS_RUNTIME_SYMBOL(GC_is_disabled),
+    };
+#undef DACHS_RUNTIME_SYMBOL
+
+    auto const found = symbols.find(name);
+    return found == std::end(symbols) ? 0u : found->second;
+}
+
+// Note:
+// Memory manager for MCJIT which resolves the runtime symbols to the functions
+// linked into the compiler.  Other symbols (e.g. libc) are looked up in the process.
+class runtime_memory_manager final : public llvm::SectionMemoryManager {
+    std::vector<std::pair<std::uint8_t *, std::uint8_t *>> gc_roots;
+
+public:
+
+    runtime_memory_manager() = default;
+    runtime_memory_manager(runtime_memory_manager const&) = delete;
+    runtime_memory_manager &operator=(runtime_memory_manager const&) = delete;
+
+    ~runtime_memory_manager()
+    {
+        for (auto const& r : gc_roots) {
+            GC_remove_roots(r.first, r.second);
+        }
+    }
+
+    std::uint64_t getSymbolAddress(std::string const& name) override
+    {
+        if (auto const address = runtime_symbol_address(name)) {
+            return address;
+        }
+
+        // Note:
+        // On Darwin, C symbols are prefixed with '_'.
+        if (!name.empty() && name.front() == '_') {
+            if (auto const address = runtime_symbol_address(name.substr(1))) {
+                return address;
+            }
+        }
+
+        return llvm::SectionMemoryManager::getSymbolAddress(name);
+    }
+
+    // Note:
+    // GC scans only the stack and the data segments of the process.  Writable
+    // data sections of JIT-compiled code may hold pointers to GC-allocated
+    // objects, so they must be registered as roots.
+    std::uint8_t *allocateDataSection(
+            std::uintptr_t const size,
+            unsigned int const alignment,
+            unsigned int const section_id,
+            llvm::StringRef section_name,
+            bool const is_read_only) override
+    {
+        auto *const section = llvm::SectionMemoryManager::allocateDataSection(size, alignment, section_id, section_name, is_read_only);
+        if (section && !is_read_only && size > 0u) {
+            GC_add_roots(section, section + size);
+            gc_roots.emplace_back(section, section + size);
+        }
+        return section;
+    }
+};
+
+std::vector<std::string> get_linker_args(llvm::Triple const& triple, std::vector<std::string> const& obj_names, std::string const& executable_name, std::vector<std::string> const& libdirs)
+{
+    std::vector<std::string> args;
+
+    if (triple.getOS() == llvm::Triple::Darwin) {
+        args = {"ld", "-macosx_version_min", "10.9.0"};
+        args.insert(std::end(args), std::begin(obj_names), std::end(obj_names));
+        args.insert(std::end(args), {"-o", executable_name, "-lSystem"});
+    } else {
+        // Note:
+        // Link with the C++ compiler driver because it knows startup files and
+        // libraries of the platform.
+        args = {DACHS_CXX_COMPILER};
+        args.insert(std::end(args), std::begin(obj_names), std::end(obj_names));
+        args.insert(std::end(args), {"-o", executable_name});
+    }
+
+    args.insert(std::end(args), {"-ldachs-runtime", "-lgc", "-L", "/usr/lib", "-L", "/usr/local/lib", "-L", DACHS_INSTALL_PREFIX "/lib", "-L", DACHS_LIBGC_PATH});
+
+    for (auto const& lib : libdirs) {
+        args.insert(std::end(args), {"-L", lib});
+    }
+
+    return args;
+}
+
+// Note:
+// The linker is spawned directly without a shell.  Arguments are passed as
+// they are, so paths containing spaces or quotes need no escape.
+void run_linker(std::vector<std::string> const& args)
+{
+    assert(!args.empty());
+
+    auto const program = llvm::sys::FindProgramByName(args[0]);
+    if (program.empty()) {
+        throw code_generation_error{"LLVM IR generator", boost::format("Linker '%1%' is not found") % args[0]};
+    }
+
+    std::vector<char const*> argv;
+    argv.reserve(args.size() + 1u);
+    for (auto const& a : args) {
+        argv.push_back(a.c_str());
+    }
+    argv.push_back(nullptr);
+
+    std::string error;
+    bool failed = false;
+    int const status = llvm::sys::ExecuteAndWait(program, argv.data(), nullptr/*env*/, nullptr/*redirects*/, 0u, 0u, &error, &failed);
+
+    if (failed || status < 0) {
+        throw code_generation_error{"LLVM IR generator", boost::format("Failed to execute linker: %1%. Command was: %2%") % error % boost::algorithm::join(args, " ")};
+    }
+
+    if (status != 0) {
+        throw code_generation_error{"LLVM IR generator", boost::format("Linker command exited with status %1%. Command was: %2%") % status % boost::algorithm::join(args, " ")};
+    }
+}
+
+} // namespace detail
+
 class binary_generator final {
 
+    using object_code = llvm::SmallVector<char, 0>;
+
     std::vector<llvm::Module *> modules;
     context &ctx;
     opt_level opt;
-    llvm::PassManagerBuilder pm_builder;
+    unsigned int jobs;
 
     std::string get_base_name_from_module(llvm::Module const& module) const
     {
@@ -62,7 +249,55 @@ class binary_generator final {
 #endif
     }
 
-    void run_func_passes(llvm::Module &module)
+    // Note:
+    // PassManagerBuilder can't be shared among modules because it passes the
+    // ownership of its inliner pass to the first populated pass manager.
+    // So the builder is set up for each module.
+    void setup_pass_manager_builder(llvm::PassManagerBuilder &pm_builder) const
+    {
+        switch (opt) {
+        case opt_level::release:
+            pm_builder.OptLevel = 3u;
+            break;
+        case opt_level::debug:
+            pm_builder.OptLevel = 0u;
+            break;
+        case opt_level::none:
+        default:
+            pm_builder.OptLevel = 2u;
+            break;
+        }
+        pm_builder.SizeLevel = 0u;
+        pm_builder.LibraryInfo = new llvm::TargetLibraryInfo(ctx.triple);
+
+        switch (opt) {
+        case opt_level::release:
+#if (LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR <= 4)
+            // Note:
+            // 225 is a threshold used for -O3
+            pm_builder.Inliner = llvm::createFunctionInliningPass(275);
+            break;
+#endif
+
+        case opt_level::none:
+#if (LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR <= 4)
+            // Note:
+            // 225 is a threshold used for -O2
+            pm_builder.Inliner = llvm::createFunctionInliningPass(225);
+#elif (LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR <= 5)
+            pm_builder.Inliner = llvm::createFunctionInliningPass(pm_builder.OptLevel, pm_builder.SizeLevel);
+#else
+# error LLVM: Not supported version.
+#endif
+
+            break;
+        case opt_level::debug:
+        default:
+            break;
+        }
+    }
+
+    void run_func_passes(llvm::Module &module, llvm::PassManagerBuilder &pm_builder) const
     {
         llvm::FunctionPassManager pm{&module};
 
@@ -77,17 +312,17 @@ class binary_generator final {
         }
     }
 
-    bool run_module_passes(llvm::Module &module, llvm::formatted_raw_ostream &os)
+    bool run_module_passes(llvm::Module &module, llvm::formatted_raw_ostream &os, llvm::TargetMachine &target_machine, llvm::PassManagerBuilder &pm_builder) const
     {
-        ctx.target_machine->setOptLevel(get_target_machine_opt_level());
+        target_machine.setOptLevel(get_target_machine_opt_level());
 
         llvm::PassManager pm;
         pm_builder.populateModulePassManager(pm);
 
-        ctx.target_machine->addAnalysisPasses(pm);
+        target_machine.addAnalysisPasses(pm);
         add_data_layout(pm);
 
-        if (ctx.target_machine->addPassesToEmitFile(pm, os, llvm::TargetMachine::CGFT_ObjectFile)) {
+        if (target_machine.addPassesToEmitFile(pm, os, llvm::TargetMachine::CGFT_ObjectFile)) {
             return false;
         }
 
@@ -96,28 +331,92 @@ class binary_generator final {
         return true;
     }
 
-    template<class String>
-    std::string generate_object(llvm::Module &module, String const parent_dir_path)
+    void optimize_module(llvm::Module &module, llvm::TargetMachine &target_machine) const
     {
-        run_func_passes(module);
+        llvm::PassManagerBuilder pm_builder;
+        setup_pass_manager_builder(pm_builder);
+
+        run_func_passes(module, pm_builder);
 
-        auto const obj_name = parent_dir_path + get_base_name_from_module(module) + ".o";
+        llvm::PassManager pm;
+        pm_builder.populateModulePassManager(pm);
+
+        target_machine.addAnalysisPasses(pm);
+        add_data_layout(pm);
+
+        pm.run(module);
+    }
 
-        std::string buffer;
+    object_code emit_object(llvm::Module &module, llvm::TargetMachine &target_machine) const
+    {
+        llvm::PassManagerBuilder pm_builder;
+        setup_pass_manager_builder(pm_builder);
+
+        run_func_passes(module, pm_builder);
+
+        object_code code;
+        {
+            // Note:
+            // Streams must be flushed to the buffer before it is returned.
+            // They are flushed on destruction.
+            llvm::raw_svector_ostream os{code};
+            llvm::formatted_raw_ostream formatted_os{os};
+            if (!run_module_passes(module, formatted_os, target_machine, pm_builder)) {
+                throw code_generation_error{"LLVM IR generator", boost::format("Failed to emit object code for module '%1%'") % module.getModuleIdentifier()};
+            }
+        }
+
+        return code;
+    }
+
+    void write_object(object_code const& code, std::string const& obj_name) const
+    {
+        std::string error;
 #if (LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR <= 4)
-        llvm::tool_output_file out{obj_name.c_str(), buffer, llvm::sys::fs::F_None | llvm::sys::fs::F_Binary};
+        llvm::tool_output_file out{obj_name.c_str(), error, llvm::sys::fs::F_None | llvm::sys::fs::F_Binary};
 #elif (LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR <= 5)
-        llvm::tool_output_file out{obj_name.c_str(), buffer, llvm::sys::fs::F_None};
+        llvm::tool_output_file out{obj_name.c_str(), error, llvm::sys::fs::F_None};
 #else
 # error LLVM: Not supported version.
 #endif
+        if (!error.empty()) {
+            throw code_generation_error{"LLVM IR generator", boost::format("Failed to create an object file '%1%': %2%") % obj_name % error};
+        }
+
+        out.os().write(code.data(), code.size());
+        out.os().flush();
+        if (out.os().has_error()) {
+            out.os().clear_error();
+            throw code_generation_error{"LLVM IR generator", boost::format("Failed to write an object file '%1%'") % obj_name};
+        }
+
         out.keep(); // Do not delete object file
-        llvm::formatted_raw_ostream formatted_os{out.os()};
-        if (!run_module_passes(module, formatted_os)) {
-            throw code_generation_error{"LLVM IR generator", boost::format("Failed to create an object file '%1%': %2%") % obj_name % buffer};
+    }
+
+    template<class String>
+    std::vector<std::string> write_objects(std::vector<object_code> const& codes, String const& parent_dir_path) const
+    {
+        assert(codes.size() == modules.size());
+
+        std::vector<std::string> obj_names;
+        obj_names.reserve(codes.size());
+
+        for (auto const i : helper::indices(codes.size())) {
+            obj_names.push_back(parent_dir_path + get_base_name_from_module(*modules[i]) + ".o");
         }
 
-        return obj_name;
+        return write_objects_to(codes, std::move(obj_names));
+    }
+
+    std::vector<std::string> write_objects_to(std::vector<object_code> const& codes, std::vector<std::string> obj_names) const
+    {
+        assert(codes.size() == obj_names.size());
+
+        for (auto const i : helper::indices(codes.size())) {
+            write_object(codes[i], obj_names[i]);
+        }
+
+        return obj_names;
     }
 
     llvm::CodeGenOpt::Level get_target_machine_opt_level() const
@@ -133,88 +432,89 @@ class binary_generator final {
         }
     }
 
-public:
-
-    binary_generator(decltype(modules) const& ms, context &c, opt_level const o = opt_level::none)
-        : modules(ms), ctx(c), opt(o), pm_builder()
+    // Note:
+    // Passes can run concurrently only on modules which belong to different LLVM contexts.
+    // Modules emitted in one context (e.g. compiled with --jobs=1) are processed sequentially.
+    bool can_generate_in_parallel() const
     {
-        assert(!ms.empty());
+        if (jobs <= 1u || modules.size() <= 1u) {
+            return false;
+        }
 
-        switch (opt) {
-        case opt_level::release:
-            pm_builder.OptLevel = 3u;
-            break;
-        case opt_level::debug:
-            pm_builder.OptLevel = 0u;
-            break;
-        case opt_level::none:
-        default:
-            pm_builder.OptLevel = 2u;
-            break;
+        std::unordered_set<llvm::LLVMContext const*> llvm_contexts;
+        for (auto const m : modules) {
+            if (!llvm_contexts.insert(&m->getContext()).second) {
+                return false;
+            }
         }
-        pm_builder.SizeLevel = 0u;
-        pm_builder.LibraryInfo = new llvm::TargetLibraryInfo(ctx.triple);
 
-        switch (opt) {
-        case opt_level::release:
-#if (LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR <= 4)
-            // Note:
-            // 225 is a threshold used for -O3
-            pm_builder.Inliner = llvm::createFunctionInliningPass(275);
-            break;
-#endif
+        return true;
+    }
 
-        case opt_level::none:
-#if (LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR <= 4)
-            // Note:
-            // 225 is a threshold used for -O2
-            pm_builder.Inliner = llvm::createFunctionInliningPass(225);
-#elif (LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR <= 5)
-            pm_builder.Inliner = llvm::createFunctionInliningPass(pm_builder.OptLevel, pm_builder.SizeLevel);
-#else
-# error LLVM: Not supported version.
-#endif
+public:
 
-            break;
-        case opt_level::debug:
-        default:
-            break;
+    binary_generator(decltype(modules) const& ms, context &c, opt_level const o = opt_level::none, unsigned int const j = 1u)
+        : modules(ms), ctx(c), opt(o), jobs(j)
+    {
+        assert(!ms.empty());
+    }
+
+    std::vector<object_code> emit_objects()
+    {
+        std::vector<object_code> codes(modules.size());
+
+        if (!can_generate_in_parallel()) {
+            for (auto const i : helper::indices(modules.size())) {
+                assert(modules[i]);
+                codes[i] = emit_object(*modules[i], *ctx.target_machine);
+            }
+            return codes;
         }
+
+        helper::parallel_for_each_index(
+                modules.size(),
+                jobs,
+                [&](std::size_t const i)
+                {
+                    assert(modules[i]);
+
+                    // Note:
+                    // TargetMachine is not thread safe.  Each task creates its own one.
+                    std::unique_ptr<llvm::TargetMachine> const target_machine{
+                        ctx.target->createTargetMachine(ctx.triple.getTriple(), ""/*cpu name*/, ""/*feature*/, ctx.options)
+                    };
+                    if (!target_machine) {
+                        throw code_generation_error{"LLVM IR generator", boost::format("Failed to get a target machine for %1%") % ctx.triple.getTriple()};
+                    }
+
+                    codes[i] = emit_object(*modules[i], *target_machine);
+                }
+            );
+
+        return codes;
     }
 
     template<class String>
     std::vector<std::string> generate_objects(String const parent_dir_path)
     {
-        std::vector<std::string> obj_names;
-        for (auto const m : modules) {
-            assert(m);
-            obj_names.push_back(generate_object(*m, parent_dir_path));
-        }
-        return obj_names;
+        return write_objects(emit_objects(), parent_dir_path);
+    }
+
+    std::vector<std::string> generate_objects_to(std::vector<std::string> const& obj_names)
+    {
+        return write_objects_to(emit_objects(), obj_names);
     }
 
     template<class String>
     std::string generate_executable(std::vector<std::string> const& libdirs, String const parent_dir_path)
     {
-        // TODO: Temporary
-        auto const obj_names = generate_objects(parent_dir_path);
-        auto const os_type = ctx.triple.getOS();
-        auto const objs_string
-            = boost::algorithm::join(obj_names, " ");
+        // Note:
+        // Object code is emitted to memory first.  The external linker can't read
+        // it from memory, so objects are written out just before linking.
+        auto const obj_names = write_objects(emit_objects(), parent_dir_path);
         auto const executable_name = parent_dir_path + get_base_name_from_module(*modules[0]);
-        auto command
-            = os_type == llvm::Triple::Darwin
-                ? "ld -macosx_version_min 10.9.0 \"" + objs_string + "\" -o \"" + executable_name + "\" -lSystem -ldachs-runtime -lgc -L /usr/lib -L /usr/local/lib -L " DACHS_INSTALL_PREFIX "/lib -L '" DACHS_LIBGC_PATH "'"
-                : (DACHS_CXX_COMPILER " ") + objs_string + " -o " + executable_name + " -ldachs-runtime -lgc -L /usr/lib -L /usr/local/lib -L " DACHS_INSTALL_PREFIX "/lib -L '" DACHS_LIBGC_PATH "'"; // Fallback...
 
-        for (auto const& lib : libdirs) {
-            command += " -L \"" + lib + '"';
-        }
-
-        int const cmd_result = std::system(command.c_str());
-        if (WEXITSTATUS(cmd_result) != 0) {
-            throw code_generation_error{"LLVM IR generator", boost::format("Linker command exited with status %1%. Command was: %2%") % WEXITSTATUS(cmd_result) % command};
-        }
+        detail::run_linker(detail::get_linker_args(ctx.triple, obj_names, executable_name, libdirs));
 
         std::vector<std::string> failed_objs;
         for (auto const& o : obj_names) {
@@ -230,6 +530,57 @@ public:
 
         return executable_name;
     }
+
+    int execute(std::vector<std::string> const& args)
+    {
+        llvm::Function *entry_point = nullptr;
+        for (auto const m : modules) {
+            assert(m);
+            optimize_module(*m, *ctx.target_machine);
+
+            auto *const f = m->getFunction("main");
+            if (f && !f->isDeclaration()) {
+                entry_point = f;
+            }
+        }
+
+        if (!entry_point) {
+            throw code_generation_error{"LLVM JIT", "Entry point 'main' is not found."};
+        }
+
+        // Note:
+        // Make symbols in this process (e.g. libc functions) visible to the JIT.
+        llvm::sys::DynamicLibrary::LoadLibraryPermanently(nullptr);
+
+        std::string error;
+        llvm::EngineBuilder builder{modules[0]};
+        builder.setErrorStr(&error)
+               .setEngineKind(llvm::EngineKind::JIT)
+               .setUseMCJIT(true)
+               .setMCJITMemoryManager(new detail::runtime_memory_manager{})
+               .setOptLevel(get_target_machine_opt_level())
+               .setTargetOptions(ctx.options);
+
+        std::unique_ptr<llvm::ExecutionEngine> const engine{builder.create()};
+        if (!engine) {
+            throw code_generation_error{"LLVM JIT", boost::format("Failed to create an execution engine: %1%") % error};
+        }
+
+        for (auto const i : helper::indices(1u, modules.size())) {
+            engine->addModule(modules[i]);
+        }
+
+        engine->finalizeObject();
+
+        std::vector<std::string> argv = {modules[0]->getModuleIdentifier()};
+        argv.insert(std::end(argv), std::begin(args), std::end(args));
+
+        engine->runStaticConstructorsDestructors(false);
+        auto const status = engine->runFunctionAsMain(entry_point, argv, nullptr);
+        engine->runStaticConstructorsDestructors(true);
+
+        return status;
+    }
 };
 
 std::string generate_executable(
@@ -237,22 +588,55 @@ std::string generate_executable(
         std::vector<std::string> const& libdirs,
         context &ctx,
         opt_level const opt,
-        std::string parent)
+        std::string parent,
+        unsigned int const jobs)
 {
-    binary_generator generator{modules, ctx, opt};
+    binary_generator generator{modules, ctx, opt, jobs};
     return generator.generate_executable(libdirs, std::move(parent));
 }
 
+std::string link_executable(
+        std::vector<std::string> const& objects,
+        std::string const& executable_name,
+        std::vector<std::string> const& libdirs,
+        context &ctx)
+{
+    detail::run_linker(detail::get_linker_args(ctx.triple, objects, executable_name, libdirs));
+    return executable_name;
+}
+
 std::vector<std::string> generate_objects(
         std::vector<llvm::Module *> const& modules,
         context &ctx,
         opt_level const opt,
-        std::string parent)
+        std::string parent,
+        unsigned int const jobs)
 {
-    binary_generator generator{modules, ctx, opt};
+    binary_generator generator{modules, ctx, opt, jobs};
     return generator.generate_objects(std::move(parent));
 }
 
+std::vector<std::string> generate_objects(
+        std::vector<llvm::Module *> const& modules,
+        context &ctx,
+        opt_level const opt,
+        std::vector<std::string> const& object_names,
+        unsigned int const jobs)
+{
+    binary_generator generator{modules, ctx, opt, jobs};
+    return generator.generate_objects_to(object_names);
+}
+
+int execute_modules(
+        std::vector<llvm::Module *> const& modules,
+        std::vector<std::string> const& args,
+        context &ctx,
+        opt_level const opt)
+{
+    binary_generator generator{modules, ctx, opt};
+    return generator.execute(args);
+}
+
 } // namespace llvmir
 } // namespace codegen
 } // namespace dachs
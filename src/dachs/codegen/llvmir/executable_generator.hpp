@@ -20,14 +20,47 @@ std::string generate_executable(
         std::vector<std::string> const& libdirs,
         context &ctx,
         opt_level const opt = opt_level::none,
-        std::string parent = ""
+        std::string parent = "",
+        unsigned int const jobs = 1u
+    );
+
+// Note:
+// Link the object files into the executable.  The object files are not removed.
+std::string link_executable(
+        std::vector<std::string> const& objects,
+        std::string const& executable_name,
+        std::vector<std::string> const& libdirs,
+        context &ctx
     );
 
 std::vector<std::string> generate_objects(
         std::vector<llvm::Module *> const& modules,
         context &ctx,
         opt_level opt = opt_level::none,
-        std::string parent = ""
+        std::string parent = "",
+        unsigned int const jobs = 1u
+    );
+
+// Note:
+// Write the object of modules[i] to object_names[i] instead of naming it after the module.
+std::vector<std::string> generate_objects(
+        std::vector<llvm::Module *> const& modules,
+        context &ctx,
+        opt_level opt,
+        std::vector<std::string> const& object_names,
+        unsigned int const jobs = 1u
+    );
+
+// Note:
+// Execute the modules in this process with MCJIT instead of generating an
+// executable.  Symbols of the runtime library and GC are resolved to the ones
+// linked into the compiler.  The execution engine takes the ownership of the
+// modules and they are deleted on return.  Returns the exit status of the program.
+int execute_modules(
+        std::vector<llvm::Module *> const& modules,
+        std::vector<std::string> const& args,
+        context &ctx,
+        opt_level const opt = opt_level::none
     );
 
 } // namespace llvmir
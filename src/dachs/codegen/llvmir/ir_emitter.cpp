@@ -105,7 +105,7 @@ class llvm_ir_emitter {
         }
     }
 
-    val lookup_var(std::string const& name) const
+    val lookup_var(helper::identifier const& name) const
     {
         auto const result
             = boost::find_if(
@@ -314,7 +314,7 @@ class llvm_ir_emitter {
             auto arg_itr = func_ir->arg_begin();
             auto param_itr = std::begin(scope->params);
             for (; param_itr != std::end(scope->params); ++arg_itr, ++param_itr) {
-                arg_itr->setName((*param_itr)->name);
+                arg_itr->setName((*param_itr)->name.str());
                 register_var(*param_itr, arg_itr);
             }
         }
@@ -330,7 +330,7 @@ class llvm_ir_emitter {
             for (auto const& instantiated_func_def : def->instantiated) {
                 emit_func_def_prototype(instantiated_func_def);
             }
-        } else {
+        } else if (semantics_ctx.is_reachable(scope)) {
             emit_func_prototype(def, scope);
         }
     }
@@ -952,7 +952,7 @@ public:
             auto const inst
                 = check(
                     param,
-                    alloc_helper.alloc_and_deep_copy(param_val, param_sym->type, param->name),
+                    alloc_helper.alloc_and_deep_copy(param_val, param_sym->type, param->name.str()),
                     "allocation for variable parameter"
                 );
 
@@ -1016,6 +1016,12 @@ public:
             return;
         }
 
+        // Note:
+        // Functions unreachable from 'main' are not emitted.  Their bodies may not be checked.
+        if (!semantics_ctx.is_reachable(scope)) {
+            return;
+        }
+
         // Note: Already checked the scope is not empty
         auto const maybe_prototype_ir = lookup_func(scope);
         assert(maybe_prototype_ir);
@@ -1589,11 +1595,10 @@ public:
 
     val emit_lambda_capture_access(type::generic_func_type const& lambda, ast::node::ufcs_invocation const& ufcs)
     {
-        auto const& indexed_by_introduced = semantics_ctx.lambda_captures.at(lambda).get<semantics::tags::introduced>();
-        auto const capture = indexed_by_introduced.find(ufcs);
+        auto const capture = semantics_ctx.lambda_captures.at(lambda).find_by_introduced(ufcs);
         auto *const child_val = emit(ufcs->child);
 
-        if (capture == boost::end(indexed_by_introduced)) {
+        if (!capture) {
             // Note:
             // If the capture map exists but no capture is found,
             // it is non-captured lambda.
@@ -1769,14 +1774,14 @@ public:
 
                     if (sym->immutable) {
                         register_var(sym, the_value);
-                        the_value->setName(sym->name);
+                        the_value->setName(sym->name.str());
                     } else {
                         if (auto const copier = semantics_ctx.copier_of(sym->type)) {
                             val const copied = emit_copier_call(param, the_value, *copier);
-                            copied->setName(sym->name);
+                            copied->setName(sym->name.str());
                             register_var(sym, copied);
                         } else {
-                            auto *const allocated = alloc_helper.alloc_and_deep_copy(the_value, sym->type, sym->name);
+                            auto *const allocated = alloc_helper.alloc_and_deep_copy(the_value, sym->type, sym->name.str());
                             assert(allocated);
                             register_var(sym, allocated);
                         }
@@ -1870,7 +1875,7 @@ public:
         auto const sym = param->param_symbol;
         auto *const allocated =
             param->is_var && semantics_ctx.copier_of(param->type)
-                ? alloc_helper.create_alloca(param->type, false /*zero init?*/, param->name)
+                ? alloc_helper.create_alloca(param->type, false /*zero init?*/, param->name.str())
                 : nullptr;
 
         // Note:
@@ -1898,7 +1903,7 @@ public:
                     ? ctx.builder.CreateInBoundsGEP(
                             range_val,
                             loaded_counter_val,
-                            param->name
+                            param->name.str()
                         )
                     : check(
                             for_,
@@ -1906,7 +1911,7 @@ public:
                                 emit_non_builtin_callee(for_, for_->index_callee_scope.lock()),
                                 range_val,
                                 loaded_counter_val,
-                                param->name
+                                param->name.str()
                             ),
                             "index access call for 'for' statement"
                         )
@@ -1918,14 +1923,14 @@ public:
                 auto *const copied = emit_copier_call(
                             param, elem_ptr_val, *copier
                         );
-                copied->setName(param->name);
+                copied->setName(param->name.str());
                 register_var(s, copied);
             } else if (allocated) {
                 alloc_helper.create_deep_copy(elem_ptr_val, allocated, s->type);
                 register_var(s, allocated);
             } else {
                 register_var(s, elem_ptr_val);
-                elem_ptr_val->setName(param->name);
+                elem_ptr_val->setName(param->name.str());
             }
         }
 
@@ -2006,17 +2011,17 @@ public:
 
                     auto *const dest_val = load_aggregate_elem(ptr_to_instance_var, type);
                     assert(dest_val);
-                    dest_val->setName(decl->name);
+                    dest_val->setName(decl->name.str());
 
                     alloc_helper.create_deep_copy(value, dest_val, type);
 
                 } else if (decl->is_var) {
                     if (auto const copier = semantics_ctx.copier_of(type)) {
                         val const copied = emit_copier_call(decl, value, *copier);
-                        copied->setName(decl->name);
+                        copied->setName(decl->name.str());
                         register_var(std::move(sym), copied);
                     } else {
-                        auto *const allocated = alloc_helper.alloc_and_deep_copy(value, type, sym->name);
+                        auto *const allocated = alloc_helper.alloc_and_deep_copy(value, type, sym->name.str());
                         assert(allocated);
                         register_var(std::move(sym), allocated);
                     }
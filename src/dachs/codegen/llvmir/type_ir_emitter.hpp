@@ -176,7 +176,7 @@ public:
         auto const& captures = itr->second;
         std::vector<llvm::Type *> capture_types;
         capture_types.reserve(captures.size());
-        for (auto const& capture : captures.get<semantics::tags::offset>()) {
+        for (auto const& capture : captures) {
             capture_types.push_back(emit(capture.introduced->type));
         }
 
@@ -0,0 +1,236 @@
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <exception>
+#include <regex>
+#include <cstdio>
+
+#include <boost/optional.hpp>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/scope_exit.hpp>
+
+#include "dachs/compile_server.hpp"
+#include "dachs/exception.hpp"
+#include "dachs/ast/source_files.hpp"
+
+namespace dachs {
+
+namespace detail {
+
+namespace pt = boost::property_tree;
+
+std::vector<std::string> get_strings(pt::ptree const& request, char const* const key)
+{
+    std::vector<std::string> result;
+
+    auto const child = request.get_child_optional(key);
+    if (!child) {
+        return result;
+    }
+
+    for (auto const& elem : *child) {
+        result.push_back(elem.second.data());
+    }
+
+    return result;
+}
+
+// Note:
+// Redirect STDERR to the buffer while a request is processed.
+// std::ostringstream is not synchronized.  Nothing may write to STDERR in
+// other threads while the buffer is installed.
+class diagnostics_capture final {
+    std::ostringstream buffer;
+    std::streambuf *const saved;
+
+public:
+
+    diagnostics_capture()
+        : buffer(), saved(std::cerr.rdbuf(buffer.rdbuf()))
+    {}
+
+    ~diagnostics_capture()
+    {
+        std::cerr.rdbuf(saved);
+    }
+
+    diagnostics_capture(diagnostics_capture const&) = delete;
+    diagnostics_capture &operator=(diagnostics_capture const&) = delete;
+
+    std::string str() const
+    {
+        return buffer.str();
+    }
+};
+
+std::string process(compiler const& c, pt::ptree const& request)
+{
+    auto const command = request.get<std::string>("command", "");
+    auto const files = get_strings(request, "files");
+    auto const importdirs = get_strings(request, "importdirs");
+
+    if (files.empty()) {
+        throw std::runtime_error{"No input file is specified"};
+    }
+
+    // Note:
+    // The sources of the request are registered to ast::source_files while they are
+    // compiled.  Release them after the request so that the registry doesn't grow
+    // with every request and mapped sources are unmapped before the files are edited.
+    // Imported modules are kept with the parsed modules.  They are not mapped.
+    BOOST_SCOPE_EXIT_ALL(&files) {
+        for (auto const& f : files) {
+            ast::source_files::release(boost::filesystem::absolute(f));
+        }
+    };
+
+    if (command == "compile") {
+        auto output_dir = request.get<std::string>("output_dir", "");
+        if (!output_dir.empty() && output_dir.back() != '/') {
+            output_dir += '/';
+        }
+        return c.compile(files, get_strings(request, "libdirs"), importdirs, output_dir);
+    } else if (command == "check-syntax") {
+        c.check_syntax(files);
+        return "";
+    }
+
+    std::ostringstream out;
+    if (command == "dump-ast") {
+        c.dump_asts(out, files);
+    } else if (command == "dump-sym-table") {
+        c.dump_scope_trees(out, files, importdirs);
+    } else if (command == "emit-llvm") {
+        c.dump_llvm_irs(out, files, importdirs);
+    } else {
+        throw std::runtime_error{"Unknown command: '" + command + "'"};
+    }
+
+    return out.str();
+}
+
+// Note:
+// write_json() can't output null.  So the response is written by hand.
+std::string json_string(std::string const& s)
+{
+    std::string result = "\"";
+    for (auto const c : s) {
+        switch (c) {
+        case '"':  result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        case '\b': result += "\\b"; break;
+        case '\f': result += "\\f"; break;
+        case '\n': result += "\\n"; break;
+        case '\r': result += "\\r"; break;
+        case '\t': result += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20u) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+                result += escaped;
+            } else {
+                result += c;
+            }
+            break;
+        }
+    }
+    return result + '"';
+}
+
+// Note:
+// Extract the id from a request which can't be parsed as JSON, so that the client
+// can still match the response.  Returns the id as a JSON string.
+boost::optional<std::string> find_raw_id(std::string const& request_json)
+{
+    static std::regex const id_pattern{R"re("id"\s*:\s*"((?:[^"\\\x00-\x1f]|\\["\\/bfnrt]|\\u[0-9a-fA-F]{4})*)")re"};
+
+    std::smatch matched;
+    if (!std::regex_search(request_json, matched, id_pattern)) {
+        return boost::none;
+    }
+
+    return '"' + matched[1].str() + '"';
+}
+
+} // namespace detail
+
+std::string compile_server::handle(std::string const& request_json) const
+{
+    namespace pt = boost::property_tree;
+
+    // Note:
+    // The id is null when it can't be extracted from the request.
+    boost::optional<std::string> id = boost::none;
+    std::string status = "ok";
+    std::string output;
+    std::string diagnostics;
+
+    try {
+        pt::ptree request;
+        std::istringstream input{request_json};
+        pt::read_json(input, request);
+
+        if (auto const given = request.get_optional<std::string>("id")) {
+            id = detail::json_string(*given);
+        }
+
+        detail::diagnostics_capture capture;
+        try {
+            output = detail::process(c, request);
+        }
+        catch (parse_error const& e) {
+            status = "parse-error";
+            std::cerr << e.what() << std::endl;
+        }
+        catch (semantic_check_error const& e) {
+            status = "semantic-error";
+            std::cerr << e.what() << std::endl;
+        }
+        catch (code_generation_error const& e) {
+            status = "code-generation-error";
+            std::cerr << e.what() << std::endl;
+        }
+        catch (not_implemented_error const& e) {
+            status = "not-implemented-error";
+            std::cerr << e.what() << std::endl;
+        }
+        catch (std::exception const& e) {
+            status = "error";
+            std::cerr << e.what() << std::endl;
+        }
+        diagnostics = capture.str();
+    }
+    catch (pt::json_parser_error const& e) {
+        id = detail::find_raw_id(request_json);
+        status = "invalid-request";
+        diagnostics = e.what();
+    }
+
+    return "{\"id\":" + (id ? *id : "null")
+        + ",\"status\":" + detail::json_string(status)
+        + ",\"output\":" + detail::json_string(output)
+        + ",\"diagnostics\":" + detail::json_string(diagnostics)
+        + "}\n";
+}
+
+int compile_server::serve(std::istream &in, std::ostream &out) const
+{
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+
+        // Note:
+        // write_json() terminates the response with a newline.
+        out << handle(line) << std::flush;
+    }
+
+    return 0;
+}
+
+} // namespace dachs
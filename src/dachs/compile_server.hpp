@@ -0,0 +1,49 @@
+#if !defined DACHS_COMPILE_SERVER_HPP_INCLUDED
+#define      DACHS_COMPILE_SERVER_HPP_INCLUDED
+
+#include <string>
+#include <iostream>
+
+#include "dachs/compiler.hpp"
+
+namespace dachs {
+
+// Note:
+// Compile server for editors and build systems.
+// It reads requests from the input stream and writes responses to the output
+// stream.  Each request and response is a JSON object in one line.
+//
+//   Request:  {"id": "1", "command": "compile", "files": ["main.dcs"],
+//              "libdirs": [], "importdirs": [], "output_dir": ""}
+//   Response: {"id": "1", "status": "ok", "output": "main", "diagnostics": ""}
+//
+// "command" is one of "compile", "check-syntax", "dump-ast", "dump-sym-table"
+// and "emit-llvm".  "status" is "ok" or the kind of the error (e.g. "parse-error").
+// "output" is the path of the executable for "compile" and the dump for the
+// others.  Messages which the compiler outputs to STDERR are in "diagnostics".
+// A request which can't be parsed gets the "invalid-request" status.  Its "id" is
+// extracted from the raw request if possible.  "id" is null when the request has no id.
+//
+// One compiler serves all requests.  So the parser grammar, the parsed imported
+// modules (e.g. the standard library) and the LLVM target are kept alive
+// among requests.  The compiler must compile in one thread (jobs == 1) because
+// STDERR is redirected to the diagnostics of the current request.
+class compile_server final {
+    compiler const& c;
+
+public:
+
+    explicit compile_server(compiler const& c)
+        : c(c)
+    {}
+
+    std::string handle(std::string const& request) const;
+
+    // Note:
+    // Serve until the input reaches EOF.  Returns the exit status.
+    int serve(std::istream &in, std::ostream &out) const;
+};
+
+} // namespace dachs
+
+#endif    // DACHS_COMPILE_SERVER_HPP_INCLUDED
@@ -3,12 +3,22 @@
 #include <sstream>
 #include <vector>
 #include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
 
 #include <boost/optional.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/system/error_code.hpp>
 
+#include <llvm/IR/LLVMContext.h>
 #include <llvm/Support/raw_ostream.h>
+#if (LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR <= 4)
+# include <llvm/Support/Threading.h>
+#endif
 
 #include "dachs/compiler.hpp"
+#include "dachs/incremental.hpp"
 #include "dachs/ast/ast.hpp"
 #include "dachs/ast/stringize_ast.hpp"
 #include "dachs/parser/importer.hpp"
@@ -18,133 +28,288 @@
 #include "dachs/codegen/llvmir/executable_generator.hpp"
 #include "dachs/codegen/llvmir/context.hpp"
 #include "dachs/helper/util.hpp"
+#include "dachs/helper/source_buffer.hpp"
 #include "dachs/helper/colorizer.hpp"
+#include "dachs/helper/parallel.hpp"
 
 namespace dachs {
 
-compiler::compiler(bool const colorful, bool const d, codegen::opt_level const o)
-    : debug(d), opt(o)
+compiler::compiler(bool const colorful, bool const d, codegen::opt_level const o, unsigned int const j, bool const i, syntax::front_end const f)
+    : parser(syntax::node_allocation::arena, f), debug(d), opt(o), jobs(j == 0u ? 1u : j), incremental(i), syntax_front_end(f)
 {
     helper::colorizer::enabled = colorful;
 }
 
-std::string compiler::read(std::string const& file) const
+compiler::~compiler() = default;
+
+std::unique_ptr<codegen::llvmir::context> compiler::new_context() const
+{
+    if (!target_context) {
+        target_context = std::make_unique<codegen::llvmir::context>();
+    }
+
+    return std::make_unique<codegen::llvmir::context>(*target_context, std::make_unique<llvm::LLVMContext>());
+}
+
+std::shared_ptr<helper::source_buffer const> compiler::read(std::string const& file) const
 {
-    auto const maybe_code = dachs::helper::read_file<std::string>(file);
-    if (!maybe_code) {
+    auto code = helper::source_buffer::open(file);
+    if (!code) {
         throw std::runtime_error{"File cannot be opened: " + file};
     }
-    return *maybe_code;
+    return code;
 }
 
-std::string compiler::compile(compiler::files_type const& files, std::vector<std::string> const& libdirs, files_type const& importdirs, std::string parent) const
+llvm::Module &compiler::emit_module(std::string const& f, files_type const& importdirs, syntax::parser const& p, codegen::llvmir::context &context, unsigned int const checking_jobs, dependencies_type *const dependencies) const
 {
-    std::vector<llvm::Module *> modules;
-    codegen::llvmir::context context;
+    // Note:
+    // Files may be compiled in some threads.  Guard the debug output not to mix them.
+    static std::mutex debug_output_mutex;
 
-    for (auto const& f : files) {
-        auto const code = read(f);
-        if (debug) {
-            std::cerr << "file: " << f << '\n';
-        }
+    auto ast = p.parse(read(f), f);
+    if (debug) {
+        std::lock_guard<std::mutex> lock{debug_output_mutex};
+        std::cerr << "file: " << f << '\n'
+                  << ast::stringize_ast(ast) << "\n\n";
+    }
 
-        auto ast = parser.parse(code, f);
-        if (debug) {
-            std::cerr << ast::stringize_ast(ast) << "\n\n";
-        }
+    syntax::importer importer{importdirs, f, imported_modules, syntax_front_end};
+    auto ctx = semantics::analyze_semantics(ast, importer, checking_jobs);
+    if (dependencies) {
+        dependencies->files = importer.already_imported;
+        dependencies->imports = importer.resolved_imports;
+    }
+    if (debug) {
+        std::lock_guard<std::mutex> lock{debug_output_mutex};
+        std::cerr << "=========Scope Tree=========\n\n"
+                  <<  scope::stringize_scope_tree(ctx.scopes) << "\n\n";
+    }
 
-        syntax::importer importer{importdirs, f};
-        auto ctx = semantics::analyze_semantics(ast, importer);
-        if (debug) {
-            std::cerr << "=========Scope Tree=========\n\n"
-                      <<  scope::stringize_scope_tree(ctx.scopes) << "\n\n";
+    auto &module = codegen::llvmir::emit_llvm_ir(ast, ctx, context);
+    if (debug) {
+        std::lock_guard<std::mutex> lock{debug_output_mutex};
+        std::cerr << "=========LLVM IR=========\n\n";
+        module.dump();
+    }
 
-        }
+    return module;
+}
+
+std::vector<llvm::Module *> compiler::emit_modules(compiler::files_type const& files, files_type const& importdirs, compiler::contexts_type &contexts, std::vector<dependencies_type> *const dependencies) const
+{
+    std::vector<llvm::Module *> modules(files.size(), nullptr);
 
-        auto &module = codegen::llvmir::emit_llvm_ir(ast, ctx, context);
-        if (debug) {
-            std::cerr << "=========LLVM IR=========\n\n";
-            module.dump();
+    if (dependencies) {
+        dependencies->assign(files.size(), {});
+    }
+
+    auto const dependencies_of
+        = [dependencies](std::size_t const i)
+        {
+            return dependencies ? &(*dependencies)[i] : nullptr;
+        };
+
+    if (jobs <= 1u || files.size() <= 1u) {
+        contexts.push_back(new_context());
+        for (auto const i : helper::indices(files.size())) {
+            modules[i] = &emit_module(files[i], importdirs, parser, *contexts.back(), jobs, dependencies_of(i));
         }
+        return modules;
+    }
 
-        modules.push_back(&module);
+#if (LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR <= 4)
+    llvm::llvm_start_multithreaded();
+#endif
+
+    // Note:
+    // An LLVMContext can't be shared among threads.  So each file gets its own
+    // context (and its own LLVMContext) and a worker emits the module into it.
+    // The contexts must outlive the modules because they own them.
+    contexts.reserve(files.size());
+    while (contexts.size() < files.size()) {
+        contexts.push_back(new_context());
     }
 
-    return codegen::llvmir::generate_executable(modules, libdirs, context, opt, std::move(parent));
+    // Note:
+    // A grammar can't be shared among threads, so each worker has its own parser and
+    // reuses it for all files it parses.  The first worker reuses the compiler's parser.
+    std::vector<std::unique_ptr<syntax::parser>> worker_parsers(helper::num_parallel_workers(files.size(), jobs));
+
+    helper::parallel_for_each_index_on_workers(
+            files.size(),
+            jobs,
+            [&](std::size_t const worker, std::size_t const i)
+            {
+                auto &p = worker_parsers[worker];
+                if (worker != 0u && !p) {
+                    p = std::make_unique<syntax::parser>(syntax::node_allocation::arena, syntax_front_end);
+                }
+
+                // Note:
+                // Files are already processed in parallel.  Function bodies in each file are
+                // checked sequentially not to run threads in threads.
+                modules[i] = &emit_module(files[i], importdirs, worker == 0u ? parser : *p, *contexts[i], 1u, dependencies_of(i));
+            }
+        );
+
+    return modules;
 }
 
-std::vector<std::string> compiler::compile_to_objects(compiler::files_type const& files, files_type const& importdirs, std::string parent) const
+std::string compiler::compile_incrementally(compiler::files_type const& files, std::vector<std::string> const& libdirs, files_type const& importdirs, std::string const& parent) const
 {
-    std::vector<llvm::Module *> modules;
-    codegen::llvmir::context context;
+    // Note:
+    // Options which change the generated object code must be in the fingerprint.
+    std::string options = "opt:" + std::to_string(static_cast<int>(opt));
+    for (auto const& d : importdirs) {
+        options += "\nlibdir:" + d;
+    }
+
+    incremental::object_cache cache{parent + ".dachs-build", options, importdirs};
 
+    boost::system::error_code err;
+    boost::filesystem::create_directories(cache.dir(), err);
+    if (err) {
+        throw std::runtime_error{"Failed to create directory for incremental build: " + cache.dir().string()};
+    }
+
+    files_type dirty_files;
     for (auto const& f : files) {
-        auto const code = read(f);
-        auto ast = parser.parse(code, f);
-        syntax::importer importer{importdirs, f};
-        auto semantics = semantics::analyze_semantics(ast, importer);
-        auto &module = codegen::llvmir::emit_llvm_ir(ast, semantics, context);
-        if (debug) {
-            std::cerr << "file: " << f << '\n'
-                      << ast::stringize_ast(ast)
-                            + "\n\n=========Scope Tree=========\n\n"
-                            + scope::stringize_scope_tree(semantics.scopes)
-                    << "\n\n=========LLVM IR=========\n\n";
-            module.dump();
+        if (!cache.find(f)) {
+            dirty_files.push_back(f);
+        }
+    }
+
+    contexts_type contexts;
+    if (!dirty_files.empty()) {
+        std::vector<dependencies_type> dependencies;
+        auto const modules = emit_modules(dirty_files, importdirs, contexts, &dependencies);
+
+        std::vector<std::string> dirty_objects;
+        dirty_objects.reserve(dirty_files.size());
+        for (auto const& f : dirty_files) {
+            dirty_objects.push_back(cache.object_path_of(f).string());
+        }
+        codegen::llvmir::generate_objects(modules, *contexts.front(), opt, dirty_objects, jobs);
+
+        for (auto const i : helper::indices(dirty_files.size())) {
+            cache.store(dirty_files[i], dependencies[i]);
         }
-        modules.push_back(&module);
+    } else {
+        // Note:
+        // All objects are up to date.  The context is only needed for the target information.
+        contexts.push_back(new_context());
     }
 
-    return codegen::llvmir::generate_objects(modules, context, opt, parent);
+    std::vector<std::string> objects;
+    objects.reserve(files.size());
+    for (auto const& f : files) {
+        objects.push_back(cache.object_path_of(f).string());
+    }
+
+    auto const executable_name = parent + boost::filesystem::path{files.front()}.stem().string();
+    return codegen::llvmir::link_executable(objects, executable_name, libdirs, *contexts.front());
 }
 
-std::string compiler::report_ast(std::string const& file, std::string const& code) const
+std::string compiler::compile(compiler::files_type const& files, std::vector<std::string> const& libdirs, files_type const& importdirs, std::string parent) const
+{
+    if (incremental) {
+        return compile_incrementally(files, libdirs, importdirs, parent);
+    }
+
+    contexts_type contexts;
+    auto const modules = emit_modules(files, importdirs, contexts);
+    return codegen::llvmir::generate_executable(modules, libdirs, *contexts.front(), opt, std::move(parent), jobs);
+}
+
+int compiler::run(compiler::files_type const& files, files_type const& importdirs, std::vector<std::string> const& args) const
+{
+    contexts_type contexts;
+    auto const modules = emit_modules(files, importdirs, contexts);
+    return codegen::llvmir::execute_modules(modules, args, *contexts.front(), opt);
+}
+
+std::vector<std::string> compiler::compile_to_objects(compiler::files_type const& files, files_type const& importdirs, std::string parent) const
+{
+    contexts_type contexts;
+    auto const modules = emit_modules(files, importdirs, contexts);
+    return codegen::llvmir::generate_objects(modules, *contexts.front(), opt, parent, jobs);
+}
+
+std::string compiler::report_ast(std::string const& file, std::shared_ptr<helper::source_buffer const> const& code) const
 {
     return ast::stringize_ast(parser.parse(code, file));
 }
 
-std::string compiler::report_scope_tree(std::string const& file, std::string const& code, files_type const& importdirs) const
+std::string compiler::report_scope_tree(std::string const& file, std::shared_ptr<helper::source_buffer const> const& code, files_type const& importdirs) const
 {
     auto ast = parser.parse(code, file);
-    syntax::importer importer{importdirs, file};
+    syntax::importer importer{importdirs, file, imported_modules, syntax_front_end};
     auto ctx = semantics::analyze_semantics(ast, importer);
     return scope::stringize_scope_tree(ctx.scopes);
 }
 
-std::string compiler::report_llvm_ir(std::string const& file, std::string const& code, files_type const& importdirs) const
+std::string compiler::report_llvm_ir(std::string const& file, std::shared_ptr<helper::source_buffer const> const& code, files_type const& importdirs) const
 {
     auto ast = parser.parse(code, file);
-    syntax::importer importer{importdirs, file};
+    syntax::importer importer{importdirs, file, imported_modules, syntax_front_end};
     auto ctx = semantics::analyze_semantics(ast, importer);
 
     std::string result;
     llvm::raw_string_ostream raw_os{result};
 
-    codegen::llvmir::context context;
-    codegen::llvmir::emit_llvm_ir(ast, ctx, context).print(raw_os, nullptr);
-    return result;
+    auto const context = new_context();
+    codegen::llvmir::emit_llvm_ir(ast, ctx, *context).print(raw_os, nullptr);
+    return raw_os.str();
 }
 
 bool compiler::check_syntax(std::vector<std::string> const& files) const
 {
-    boost::optional<parse_error> failed;
+    // Note:
+    // Files are checked by a pool of workers with the check-only grammar.  A grammar
+    // can't be shared among threads, so each worker has its own parser.  The first
+    // worker reuses the compiler's parser, whose grammar may already be built.
+    //
+    // The errors of a file are buffered and printed at once as soon as the file is
+    // checked, so outputs of files running in parallel are never mixed.  All files
+    // are checked even if some of them fail.  After all files are checked, a parse
+    // error summarizing the failures is thrown.  Other errors (e.g. a file can't be
+    // opened) are not printed here and the first one is thrown instead.
+    std::vector<std::unique_ptr<syntax::parser>> worker_parsers(helper::num_parallel_workers(files.size(), jobs));
+    std::mutex output_mutex;
+    std::atomic<std::size_t> num_failed_files{0u};
 
-    for (auto const& f : files) {
-        try {
-            // Note:
-            // Do not import in terms of performance
-            parser.parse(read(f), f);
-        }
-        catch (parse_error const& e) {
-            failed = e;
-        }
-    }
+    helper::parallel_for_each_index_on_workers(
+            files.size(),
+            jobs,
+            [&](std::size_t const worker, std::size_t const i)
+            {
+                auto const& f = files[i];
+                auto &p = worker_parsers[worker];
+                if (worker != 0u && !p) {
+                    p = std::make_unique<syntax::parser>(syntax::node_allocation::heap, syntax_front_end);
+                }
+
+                std::ostringstream diagnostics;
+                try {
+                    // Note:
+                    // Do not import in terms of performance
+                    (worker == 0u ? parser : *p).check_syntax(*read(f), diagnostics);
+                }
+                catch (parse_error const& e) {
+                    ++num_failed_files;
+                    std::lock_guard<std::mutex> lock{output_mutex};
+                    std::cerr << "file: " << f << '\n'
+                              << diagnostics.str()
+                              << e.what() << std::endl;
+                }
+            }
+        );
 
-    if (failed) {
-        throw *failed;
+    if (num_failed_files > 0u) {
+        throw parse_error{num_failed_files.load()};
     }
 
-    return static_cast<bool>(!failed);
+    return true;
 }
 
 void compiler::dump_asts(std::ostream &out, compiler::files_type const& files) const
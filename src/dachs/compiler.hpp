@@ -2,27 +2,90 @@
 #define      DACHS_COMPILER_HPP_INCLUDED
 
 #include <string>
+#include <vector>
+#include <memory>
 #include <iostream>
+#include <set>
+
+#include <boost/filesystem/path.hpp>
 
 #include "dachs/ast/ast_fwd.hpp"
 #include "dachs/parser/parser.hpp"
+#include "dachs/helper/source_buffer.hpp"
+#include "dachs/parser/module_pool.hpp"
+#include "dachs/incremental.hpp"
 #include "dachs/semantics/scope.hpp"
 #include "dachs/codegen/opt_level.hpp"
 
+namespace llvm {
+class Module;
+} // namespace llvm
+
 namespace dachs {
 
+namespace codegen {
+namespace llvmir {
+class context;
+} // namespace llvmir
+} // namespace codegen
+
 class compiler final {
     syntax::parser parser;
+
+    // Note:
+    // Imported modules are parsed once per compiler and shared by all files.
+    mutable syntax::module_pool imported_modules;
+
     bool debug;
     codegen::opt_level opt;
+    unsigned int jobs;
+    bool incremental;
+    syntax::front_end syntax_front_end;
+
+    // Note:
+    // The LLVM target is created once per compiler.  Each compilation gets its
+    // own LLVM context sharing it, so modules are freed after the compilation.
+    mutable std::unique_ptr<codegen::llvmir::context> target_context;
 
     using files_type = std::vector<std::string>;
+    using contexts_type = std::vector<std::unique_ptr<codegen::llvmir::context>>;
+    using dependencies_type = incremental::dependencies;
 
-    std::string read(std::string const& file) const;
+    std::shared_ptr<helper::source_buffer const> read(std::string const& file) const;
+
+    std::unique_ptr<codegen::llvmir::context> new_context() const;
+
+    llvm::Module &emit_module(
+            std::string const& file,
+            files_type const& importdirs,
+            syntax::parser const& p,
+            codegen::llvmir::context &ctx,
+            unsigned int const checking_jobs,
+            dependencies_type *const dependencies = nullptr
+        ) const;
+
+    std::vector<llvm::Module *> emit_modules(
+            files_type const& files,
+            files_type const& importdirs,
+            contexts_type &contexts,
+            std::vector<dependencies_type> *const dependencies = nullptr
+        ) const;
+
+    std::string compile_incrementally(
+            files_type const& files,
+            files_type const& libdirs,
+            files_type const& importdirs,
+            std::string const& parent
+        ) const;
 
 public:
 
-    compiler(bool const colorful, bool const debug, codegen::opt_level const opt = codegen::opt_level::none);
+    // Note:
+    // When 'incremental' is true, compile() keeps object files in the
+    // directory '.dachs-build' and reuses them for unchanged source files.
+    // 'front_end' selects the parser used for source files and imported modules.
+    compiler(bool const colorful, bool const debug, codegen::opt_level const opt = codegen::opt_level::none, unsigned int const jobs = 1u, bool const incremental = false, syntax::front_end const front_end = syntax::front_end::spirit);
+    ~compiler();
 
     std::string compile(
             files_type const& files,
@@ -31,15 +94,23 @@ public:
             std::string parent = ""
         ) const;
 
+    // Note:
+    // Run the program in this process with JIT and return its exit status.
+    int run(
+            files_type const& files,
+            files_type const& importdirs,
+            std::vector<std::string> const& args
+        ) const;
+
     std::vector<std::string> compile_to_objects(
             files_type const& files,
             files_type const& importdirs,
             std::string parent = ""
         ) const;
 
-    std::string report_ast(std::string const& file, std::string const& code) const;
-    std::string report_scope_tree(std::string const& file, std::string const& code, files_type const& importdirs) const;
-    std::string report_llvm_ir(std::string const& file, std::string const& code, files_type const& importdirs) const;
+    std::string report_ast(std::string const& file, std::shared_ptr<helper::source_buffer const> const& code) const;
+    std::string report_scope_tree(std::string const& file, std::shared_ptr<helper::source_buffer const> const& code, files_type const& importdirs) const;
+    std::string report_llvm_ir(std::string const& file, std::shared_ptr<helper::source_buffer const> const& code, files_type const& importdirs) const;
     bool check_syntax(std::vector<std::string> const& files) const;
 
     void dump_asts(std::ostream &out, files_type const& files) const;
@@ -65,13 +65,19 @@ struct parse_error final : public std::runtime_error {
         , location(loc)
     {}
 
+    // Note:
+    // Used when the error is not in any registered file.  'location' is empty.
     parse_error(std::size_t const line, std::size_t const col) noexcept
         : std::runtime_error((boost::format("Parse error generated at line:%1%, col:%2%") % line % col).str())
         , location()
-    {
-        location.line = line;
-        location.col = col;
-    }
+    {}
+
+    // Note:
+    // Summary of parse errors in some files.  The error of each file is already reported.
+    explicit parse_error(std::size_t const num_files) noexcept
+        : std::runtime_error((boost::format("Parse error(s) generated in %1% file(s)") % num_files).str())
+        , location()
+    {}
 };
 
 struct semantic_check_error final : public std::runtime_error {
@@ -0,0 +1,357 @@
+#if !defined DACHS_HELPER_IDENTIFIER_HPP_INCLUDED
+#define      DACHS_HELPER_IDENTIFIER_HPP_INCLUDED
+
+#include <array>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <functional>
+#include <ostream>
+#include <cstddef>
+
+namespace dachs {
+namespace helper {
+
+namespace detail {
+
+struct identifier_info {
+    std::size_t hash;
+    bool interned;
+};
+
+// Note:
+// Process-wide table of interned strings.  An entry is never removed, so the
+// address of an entry is stable while the process lives.  Elements of
+// std::unordered_map are not moved by rehashing.
+// The table is split into shards by the hash of a string and each shard has its
+// own lock, so parsers and analyzers running in parallel rarely wait for each other.
+// In addition, each thread caches the entries it has looked up and finds them
+// without any lock.
+// Only names which appear in sources should be interned.  Names which are unique
+// to one compilation (e.g. unused parameters and lambdas) would stay in the table
+// forever in server mode.  Use identifier::unique() for them.
+class identifier_table final {
+public:
+    using entry_type = std::unordered_map<std::string, identifier_info>::value_type;
+
+private:
+    static constexpr std::size_t num_shards = 64u;
+
+    struct shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, identifier_info> entries;
+    };
+
+    std::array<shard, num_shards> shards;
+
+    entry_type const* intern_to_shard(std::string const& s, std::size_t const hash)
+    {
+        auto &target = shards[hash % num_shards];
+        std::lock_guard<std::mutex> lock{target.mutex};
+        auto const found = target.entries.find(s);
+        if (found != std::end(target.entries)) {
+            return &*found;
+        }
+        return &*target.entries.emplace(s, identifier_info{hash, true}).first;
+    }
+
+public:
+    entry_type const* intern(std::string const& s)
+    {
+        thread_local std::unordered_map<std::string, entry_type const*> cache;
+
+        auto const cached = cache.find(s);
+        if (cached != std::end(cache)) {
+            return cached->second;
+        }
+
+        auto const e = intern_to_shard(s, std::hash<std::string>{}(s));
+        cache.emplace(s, e);
+        return e;
+    }
+
+    static identifier_table &get()
+    {
+        static identifier_table t;
+        return t;
+    }
+
+    static entry_type const* empty()
+    {
+        static entry_type const* const e = get().intern("");
+        return e;
+    }
+};
+
+} // namespace detail
+
+// Note:
+// Interned string for names (variables, functions, classes and types).
+// Equal strings are interned to the same entry.  So comparing interned
+// identifiers is done with their entries and never looks at the characters.
+// The hash of the characters is computed once when the string is interned.
+// Strings are interned when they are parsed, so following passes (scopes,
+// semantic analysis and code generation) compare names as pointers.
+//
+// An identifier made by unique() is not interned.  It owns its characters and
+// is released with its last copy.  It is compared with other identifiers by
+// characters.
+//
+// It behaves as a read-only std::string for the code which needs the characters
+// (e.g. concatenation, prefix checks and printing).  Comparison with a raw string
+// compares characters and doesn't intern it.  Construct an identifier (or keep a
+// static one) to compare by entry.
+class identifier final {
+    using entry_type = detail::identifier_table::entry_type;
+    entry_type const* entry;
+    std::shared_ptr<entry_type const> owned;
+
+    explicit identifier(std::shared_ptr<entry_type const> &&e) noexcept
+        : entry(e.get()), owned(std::move(e))
+    {}
+
+    static bool equals(entry_type const* const l, entry_type const* const r) noexcept
+    {
+        if (l == r) {
+            return true;
+        }
+        if (l->second.interned && r->second.interned) {
+            return false;
+        }
+        return l->second.hash == r->second.hash && l->first == r->first;
+    }
+
+public:
+    using value_type = char;
+    using size_type = std::string::size_type;
+    using iterator = std::string::const_iterator;
+    using const_iterator = std::string::const_iterator;
+
+    identifier() noexcept
+        : entry(detail::identifier_table::empty())
+    {}
+
+    identifier(std::string const& s)
+        : entry(detail::identifier_table::get().intern(s))
+    {}
+
+    identifier(char const* const s)
+        : entry(detail::identifier_table::get().intern(std::string{s}))
+    {}
+
+    // Note:
+    // Make an identifier which is not interned.
+    static identifier unique(std::string const& s)
+    {
+        return identifier{
+            std::make_shared<entry_type const>(s, detail::identifier_info{std::hash<std::string>{}(s), false})
+        };
+    }
+
+    identifier(identifier const&) = default;
+    identifier &operator=(identifier const&) = default;
+    identifier(identifier &&) noexcept = default;
+    identifier &operator=(identifier &&) noexcept = default;
+
+    std::string const& str() const noexcept
+    {
+        return entry->first;
+    }
+
+    operator std::string const&() const noexcept
+    {
+        return entry->first;
+    }
+
+    // Note:
+    // Hash of the characters.  Equal strings have the same id.
+    std::size_t id() const noexcept
+    {
+        return entry->second.hash;
+    }
+
+    bool is_interned() const noexcept
+    {
+        return entry->second.interned;
+    }
+
+    char const* c_str() const noexcept
+    {
+        return entry->first.c_str();
+    }
+
+    size_type size() const noexcept
+    {
+        return entry->first.size();
+    }
+
+    size_type length() const noexcept
+    {
+        return entry->first.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return entry->first.empty();
+    }
+
+    char front() const noexcept
+    {
+        return entry->first.front();
+    }
+
+    char back() const noexcept
+    {
+        return entry->first.back();
+    }
+
+    char operator[](size_type const i) const noexcept
+    {
+        return entry->first[i];
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return entry->first.begin();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return entry->first.end();
+    }
+
+    size_type find(char const c, size_type const pos = 0u) const noexcept
+    {
+        return entry->first.find(c, pos);
+    }
+
+    size_type find(std::string const& s, size_type const pos = 0u) const noexcept
+    {
+        return entry->first.find(s, pos);
+    }
+
+    std::string substr(size_type const pos = 0u, size_type const n = std::string::npos) const
+    {
+        return entry->first.substr(pos, n);
+    }
+
+    int compare(std::string const& s) const noexcept
+    {
+        return entry->first.compare(s);
+    }
+
+    friend bool operator==(identifier const& l, identifier const& r) noexcept
+    {
+        return equals(l.entry, r.entry);
+    }
+
+    friend bool operator!=(identifier const& l, identifier const& r) noexcept
+    {
+        return !equals(l.entry, r.entry);
+    }
+
+    friend bool operator==(identifier const& l, std::string const& r) noexcept
+    {
+        return l.entry->first == r;
+    }
+
+    friend bool operator==(std::string const& l, identifier const& r) noexcept
+    {
+        return l == r.entry->first;
+    }
+
+    friend bool operator==(identifier const& l, char const* const r) noexcept
+    {
+        return l.entry->first == r;
+    }
+
+    friend bool operator==(char const* const l, identifier const& r) noexcept
+    {
+        return l == r.entry->first;
+    }
+
+    friend bool operator!=(identifier const& l, std::string const& r) noexcept
+    {
+        return !(l == r);
+    }
+
+    friend bool operator!=(std::string const& l, identifier const& r) noexcept
+    {
+        return !(l == r);
+    }
+
+    friend bool operator!=(identifier const& l, char const* const r) noexcept
+    {
+        return !(l == r);
+    }
+
+    friend bool operator!=(char const* const l, identifier const& r) noexcept
+    {
+        return !(l == r);
+    }
+
+    // Note:
+    // Order by characters (not by ids) to keep outputs deterministic.
+    friend bool operator<(identifier const& l, identifier const& r) noexcept
+    {
+        return l.entry != r.entry && l.entry->first < r.entry->first;
+    }
+
+    friend std::string operator+(identifier const& l, std::string const& r)
+    {
+        return l.entry->first + r;
+    }
+
+    friend std::string operator+(std::string const& l, identifier const& r)
+    {
+        return l + r.entry->first;
+    }
+
+    friend std::string operator+(identifier const& l, char const* const r)
+    {
+        return l.entry->first + r;
+    }
+
+    friend std::string operator+(char const* const l, identifier const& r)
+    {
+        return l + r.entry->first;
+    }
+
+    friend std::string operator+(identifier const& l, char const r)
+    {
+        return l.entry->first + r;
+    }
+
+    friend std::string operator+(char const l, identifier const& r)
+    {
+        return l + r.entry->first;
+    }
+
+    friend std::string operator+(identifier const& l, identifier const& r)
+    {
+        return l.entry->first + r.entry->first;
+    }
+
+    friend std::ostream &operator<<(std::ostream &o, identifier const& i)
+    {
+        return o << i.entry->first;
+    }
+};
+
+} // namespace helper
+} // namespace dachs
+
+namespace std {
+
+template<>
+struct hash<dachs::helper::identifier> {
+    std::size_t operator()(dachs::helper::identifier const& i) const noexcept
+    {
+        return i.id();
+    }
+};
+
+} // namespace std
+
+#endif    // DACHS_HELPER_IDENTIFIER_HPP_INCLUDED
@@ -0,0 +1,93 @@
+#if !defined DACHS_HELPER_PARALLEL_HPP_INCLUDED
+#define      DACHS_HELPER_PARALLEL_HPP_INCLUDED
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <cstddef>
+
+namespace dachs {
+namespace helper {
+
+// Note:
+// The number of threads parallel_for_each_index() runs for 'num_tasks' tasks.
+inline std::size_t num_parallel_workers(std::size_t const num_tasks, unsigned int const jobs) noexcept
+{
+    return std::min<std::size_t>(std::max(jobs, 1u), num_tasks);
+}
+
+// Note:
+// Run 'f(w, i)' for each i in [0, num_tasks) on at most 'jobs' threads.  'w' is
+// the index of the worker running the task, in [0, num_parallel_workers()).
+// Workers can keep their own state which must not be shared among threads
+// (e.g. a parser) in a vector indexed by 'w'.  When tasks run in the calling
+// thread, 'w' is always 0.
+// Indices are handed out one by one through an atomic counter, so a worker
+// which finished a small task immediately picks up the next one.
+// If some tasks throw, the exception of the task with the smallest index is
+// rethrown after all workers have finished.  So the error reported is the
+// same as the one sequential execution would report.
+template<class Func>
+void parallel_for_each_index_on_workers(std::size_t const num_tasks, unsigned int const jobs, Func const& f)
+{
+    auto const num_workers = num_parallel_workers(num_tasks, jobs);
+
+    if (num_workers <= 1u) {
+        for (std::size_t i = 0u; i < num_tasks; ++i) {
+            f(std::size_t{0u}, i);
+        }
+        return;
+    }
+
+    std::atomic<std::size_t> next_task{0u};
+    std::vector<std::exception_ptr> errors(num_tasks);
+
+    auto const worker
+        = [&](std::size_t const w)
+        {
+            for (auto i = next_task++; i < num_tasks; i = next_task++) {
+                try {
+                    f(w, i);
+                }
+                catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            }
+        };
+
+    std::vector<std::thread> workers;
+    workers.reserve(num_workers);
+    for (std::size_t w = 0u; w < num_workers; ++w) {
+        workers.emplace_back(worker, w);
+    }
+
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    for (auto const& e : errors) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+}
+
+// Note:
+// Run 'f(i)' for each i in [0, num_tasks) on at most 'jobs' threads.
+// See parallel_for_each_index_on_workers() for the details.
+template<class Func>
+void parallel_for_each_index(std::size_t const num_tasks, unsigned int const jobs, Func const& f)
+{
+    parallel_for_each_index_on_workers(
+            num_tasks,
+            jobs,
+            [&f](std::size_t, std::size_t const i){ f(i); }
+        );
+}
+
+} // namespace helper
+} // namespace dachs
+
+#endif    // DACHS_HELPER_PARALLEL_HPP_INCLUDED
@@ -0,0 +1,252 @@
+#if !defined DACHS_HELPER_SOURCE_BUFFER_HPP_INCLUDED
+#define      DACHS_HELPER_SOURCE_BUFFER_HPP_INCLUDED
+
+#include <string>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <cerrno>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <boost/noncopyable.hpp>
+
+namespace dachs {
+namespace helper {
+
+// Note:
+// Read-only code of a source file.  A regular file is mapped with mmap() and
+// parsers iterate over the mapped memory directly.  When the file can't be
+// mapped (e.g. it is empty or is a pipe), it is read at once into a buffer
+// allocated with the size of the file.
+//
+// Buffers are shared with std::shared_ptr.  ast::source_files holds the buffer
+// of each parsed file until it is released, so diagnostics can slice into the
+// code without copying it.  The file must not be truncated while it is mapped
+// (reading the mapping raises SIGBUS).  So code which is kept for a long time
+// (e.g. imported modules kept by the compile server) should be loaded with
+// read(), which never maps the file.
+class source_buffer final : boost::noncopyable {
+public:
+
+    // Note:
+    // Identifies the content of a regular file without reading it.  A mapping
+    // reflects changes of the file, so mapped buffers can't be compared by their
+    // contents to detect that the file was rewritten.
+    struct file_identity {
+        dev_t device = 0;
+        ino_t inode = 0;
+        off_t size = 0;
+        time_t mtime_sec = 0;
+        long mtime_nsec = 0;
+        bool valid = false;
+
+        file_identity() = default;
+
+        explicit file_identity(struct stat const& st) noexcept
+            : device(st.st_dev)
+            , inode(st.st_ino)
+            , size(st.st_size)
+            , mtime_sec(st.st_mtime)
+#if defined __APPLE__
+            , mtime_nsec(st.st_mtimespec.tv_nsec)
+#else
+            , mtime_nsec(st.st_mtim.tv_nsec)
+#endif
+            , valid(true)
+        {}
+
+        // Note:
+        // Invalid when the file is not a regular file or can't be stat'ed.
+        static file_identity of(std::string const& file_name) noexcept
+        {
+            struct stat st;
+            if (::stat(file_name.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+                return file_identity{};
+            }
+            return file_identity{st};
+        }
+
+        bool operator==(file_identity const& rhs) const noexcept
+        {
+            return valid && rhs.valid
+                && device == rhs.device
+                && inode == rhs.inode
+                && size == rhs.size
+                && mtime_sec == rhs.mtime_sec
+                && mtime_nsec == rhs.mtime_nsec;
+        }
+    };
+
+private:
+
+    char const* first = nullptr;
+    std::size_t length = 0u;
+    void *mapped = nullptr;
+    std::string storage;
+    file_identity identity_;
+
+    struct private_tag {};
+
+    static std::shared_ptr<source_buffer const> load(std::string const& file_name, bool const map)
+    {
+        int const fd = ::open(file_name.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return nullptr;
+        }
+
+        std::shared_ptr<source_buffer> result = nullptr;
+        std::size_t size_hint = 0u;
+        file_identity id;
+
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            id = file_identity{st};
+            size_hint = static_cast<std::size_t>(st.st_size);
+            if (map && size_hint > 0u) {
+                void *const m = ::mmap(nullptr, size_hint, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (m != MAP_FAILED) {
+                    result = std::make_shared<source_buffer>(private_tag{}, m, size_hint);
+                }
+            }
+        }
+
+        if (!result) {
+            result = read_all(fd, size_hint);
+        }
+
+        ::close(fd);
+
+        if (result) {
+            result->identity_ = id;
+        }
+        return result;
+    }
+
+    static std::shared_ptr<source_buffer> read_all(int const fd, std::size_t const size_hint)
+    {
+        std::string code(size_hint, '\0');
+        std::size_t filled = 0u;
+
+        for (;;) {
+            if (filled == code.size()) {
+                code.resize(std::max<std::size_t>(code.size() * 2u, 4096u));
+            }
+
+            auto const n = ::read(fd, &code[filled], code.size() - filled);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return nullptr;
+            }
+            if (n == 0) {
+                break;
+            }
+            filled += static_cast<std::size_t>(n);
+        }
+
+        code.resize(filled);
+        return std::make_shared<source_buffer>(private_tag{}, std::move(code));
+    }
+
+public:
+
+    using iterator = char const*;
+    using const_iterator = char const*;
+
+    // Note:
+    // Use open() or from_string() to construct.
+    source_buffer(private_tag, std::string && code) noexcept
+        : storage(std::move(code))
+    {
+        first = storage.data();
+        length = storage.size();
+    }
+
+    source_buffer(private_tag, void *const m, std::size_t const size) noexcept
+        : first(static_cast<char const*>(m)), length(size), mapped(m)
+    {}
+
+    ~source_buffer() noexcept
+    {
+        if (mapped) {
+            ::munmap(mapped, length);
+        }
+    }
+
+    // Note:
+    // Return nullptr when the file can't be opened.
+    static std::shared_ptr<source_buffer const> open(std::string const& file_name)
+    {
+        return load(file_name, true);
+    }
+
+    // Note:
+    // Same as open() but the code is always read into memory.
+    static std::shared_ptr<source_buffer const> read(std::string const& file_name)
+    {
+        return load(file_name, false);
+    }
+
+    static std::shared_ptr<source_buffer const> from_string(std::string code)
+    {
+        return std::make_shared<source_buffer const>(private_tag{}, std::move(code));
+    }
+
+    char const* data() const noexcept
+    {
+        return first;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return length;
+    }
+
+    bool is_mapped() const noexcept
+    {
+        return mapped != nullptr;
+    }
+
+    // Note:
+    // Invalid when the buffer is not loaded from a regular file.
+    file_identity const& identity() const noexcept
+    {
+        return identity_;
+    }
+
+    bool empty() const noexcept
+    {
+        return length == 0u;
+    }
+
+    iterator begin() const noexcept
+    {
+        return first;
+    }
+
+    iterator end() const noexcept
+    {
+        return first + length;
+    }
+
+    bool equals(std::string const& code) const noexcept
+    {
+        return code.size() == length && std::equal(first, first + length, code.data());
+    }
+
+    std::string str() const
+    {
+        return {first, length};
+    }
+};
+
+} // namespace helper
+} // namespace dachs
+
+#endif    // DACHS_HELPER_SOURCE_BUFFER_HPP_INCLUDED
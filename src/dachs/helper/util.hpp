@@ -29,12 +29,27 @@ inline boost::optional<String> read_file(std::string const& file_name)
 {
     typedef typename String::value_type CharT;
 
-    std::basic_ifstream<CharT> input(file_name, std::ios::in);
+    std::basic_ifstream<CharT> input(file_name, std::ios::in | std::ios::binary);
     if (!input.is_open()) {
         return boost::none;
     }
-    return String{std::istreambuf_iterator<CharT>{input},
-                  std::istreambuf_iterator<CharT>{}};
+
+    // Note:
+    // Allocate the result with the size of the file at once and read it in one
+    // call.  When the size is unknown (e.g. a pipe), read it character by character.
+    input.seekg(0, std::ios::end);
+    auto const size = input.tellg();
+    if (size < 0) {
+        input.clear();
+        return String{std::istreambuf_iterator<CharT>{input},
+                      std::istreambuf_iterator<CharT>{}};
+    }
+    input.seekg(0, std::ios::beg);
+
+    String result(static_cast<std::size_t>(size), CharT{});
+    input.read(&result[0], static_cast<std::streamsize>(result.size()));
+    result.resize(static_cast<std::size_t>(input.gcount()));
+    return result;
 }
 
 namespace detail {
@@ -0,0 +1,190 @@
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iterator>
+#include <functional>
+#include <cstddef>
+
+#include <boost/filesystem.hpp>
+#include <boost/system/error_code.hpp>
+
+#include "dachs/incremental.hpp"
+#include "dachs/parser/importer.hpp"
+#include "dachs/helper/util.hpp"
+
+namespace dachs {
+namespace incremental {
+
+namespace detail {
+
+boost::optional<std::string> hash_of_file(fs::path const& file)
+{
+    auto const contents = helper::read_file<std::string>(file.string());
+    if (!contents) {
+        return boost::none;
+    }
+
+    return std::to_string(contents->size()) + ':' + std::to_string(std::hash<std::string>{}(*contents));
+}
+
+boost::optional<fs::path> canonical_of(fs::path const& p)
+{
+    boost::system::error_code err;
+    auto canonical = fs::canonical(p, err);
+    if (err) {
+        return boost::none;
+    }
+    return canonical;
+}
+
+// Note:
+// Name of the files in the cache for the source file.  The stem is kept to make
+// the directory readable.  The hash of the path distinguishes source files which
+// have the same name in different directories.
+std::string entry_name_of(fs::path const& source)
+{
+    auto const canonical = canonical_of(source);
+    auto const path = canonical ? *canonical : fs::absolute(source);
+
+    std::ostringstream name;
+    name << source.stem().string() << '-' << std::hex << std::hash<std::string>{}(path.string());
+    return name.str();
+}
+
+// Note:
+// Imported modules are recorded with this prefix in the place of a file.
+char const* const import_prefix = "import:";
+
+} // namespace detail
+
+fs::path object_cache::object_path_of(fs::path const& source) const
+{
+    return cache_dir / (detail::entry_name_of(source) + ".o");
+}
+
+fs::path object_cache::fingerprint_path_of(fs::path const& source) const
+{
+    return cache_dir / (detail::entry_name_of(source) + ".fingerprint");
+}
+
+boost::optional<fs::path> object_cache::find(fs::path const& source) const
+{
+    auto const canonical = detail::canonical_of(source);
+    if (!canonical) {
+        return boost::none;
+    }
+
+    auto const object = object_path_of(source);
+    if (!fs::exists(object)) {
+        return boost::none;
+    }
+
+    std::ifstream input{fingerprint_path_of(source).string()};
+    if (!input.is_open()) {
+        return boost::none;
+    }
+
+    std::string const data{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+
+    // Note:
+    // The header also checks the source file in case the hashes of paths collide.
+    auto const header = "DACHS-FINGERPRINT\n" + options + '\n' + canonical->string() + '\n';
+    if (data.compare(0, header.size(), header) != 0) {
+        return boost::none;
+    }
+
+    std::istringstream deps{data.substr(header.size())};
+    std::string dep, recorded;
+    std::size_t num_deps = 0u;
+    std::string const import_prefix = detail::import_prefix;
+    while (std::getline(deps, dep) && std::getline(deps, recorded)) {
+        if (dep.compare(0, import_prefix.size(), import_prefix) == 0) {
+            // Note:
+            // 'recorded' is the file the module was resolved to.  A file added to an import
+            // directory which precedes it changes the resolution.
+            auto const found = syntax::find_import_path(dep.substr(import_prefix.size()), import_dirs, *canonical);
+            if (!found) {
+                return boost::none;
+            }
+            auto const resolved = detail::canonical_of(*found);
+            if (!resolved || resolved->string() != recorded) {
+                return boost::none;
+            }
+            continue;
+        }
+
+        auto const current = detail::hash_of_file(dep);
+        if (!current || *current != recorded) {
+            return boost::none;
+        }
+        ++num_deps;
+    }
+
+    if (num_deps == 0u) {
+        return boost::none;
+    }
+
+    return object;
+}
+
+void object_cache::store(fs::path const& source, dependencies const& dependencies) const
+{
+    auto const canonical = detail::canonical_of(source);
+    if (!canonical) {
+        return;
+    }
+
+    std::string data = "DACHS-FINGERPRINT\n" + options + '\n' + canonical->string() + '\n';
+
+    for (auto const& i : dependencies.imports) {
+        auto const resolved = detail::canonical_of(i.second);
+        if (!resolved) {
+            return;
+        }
+        data += detail::import_prefix + i.first + '\n' + resolved->string() + '\n';
+    }
+
+    auto deps = dependencies.files;
+    deps.insert(*canonical);
+
+    std::set<fs::path> recorded;
+    for (auto const& d : deps) {
+        auto const p = detail::canonical_of(d);
+        if (!p || !recorded.insert(*p).second) {
+            continue;
+        }
+
+        auto const hash = detail::hash_of_file(*p);
+        if (!hash) {
+            return;
+        }
+
+        data += p->string() + '\n' + *hash + '\n';
+    }
+
+    boost::system::error_code err;
+    auto const fingerprint = fingerprint_path_of(source);
+    auto const tmp_file = cache_dir / fs::unique_path("%%%%-%%%%-%%%%-%%%%.tmp");
+
+    {
+        std::ofstream output{tmp_file.string(), std::ios::out | std::ios::trunc};
+        if (!output.is_open()) {
+            return;
+        }
+
+        output << data;
+        if (!output) {
+            output.close();
+            fs::remove(tmp_file, err);
+            return;
+        }
+    }
+
+    fs::rename(tmp_file, fingerprint, err);
+    if (err) {
+        fs::remove(tmp_file, err);
+    }
+}
+
+} // namespace incremental
+} // namespace dachs
@@ -0,0 +1,74 @@
+#if !defined DACHS_INCREMENTAL_HPP_INCLUDED
+#define      DACHS_INCREMENTAL_HPP_INCLUDED
+
+#include <string>
+#include <set>
+#include <map>
+#include <vector>
+
+#include <boost/optional.hpp>
+#include <boost/filesystem/path.hpp>
+
+namespace dachs {
+namespace incremental {
+
+namespace fs = boost::filesystem;
+
+// Note:
+// Files read to compile a source file.  'files' are all files imported transitively.
+// 'imports' maps each imported module (e.g. "std.string") to the file it was
+// resolved to (see syntax::importer).
+struct dependencies {
+    std::set<fs::path> files;
+    std::map<std::string, fs::path> imports;
+};
+
+// Note:
+// Object files of the previous compilation kept for incremental builds.
+// Each source file has its object file and a fingerprint file in the cache
+// directory.  They are named after the hash of the canonical path of the source
+// file, so source files with the same name in different directories don't share
+// them.  The fingerprint records the contents of the source file and of all files
+// it imports transitively, the file each imported module is resolved to, and the
+// compiler options which affect the generated code.  When none of them changed
+// (e.g. no file which precedes in the import directories has been added), the
+// previous object file is reused and the source file is not compiled again.
+// The compiler binary itself is not recorded.  Remove the directory after
+// updating the compiler.
+class object_cache final {
+    fs::path cache_dir;
+    std::string options;
+    std::vector<std::string> import_dirs;
+
+    fs::path fingerprint_path_of(fs::path const& source) const;
+
+public:
+
+    object_cache(fs::path const& dir, std::string const& options, std::vector<std::string> const& import_dirs)
+        : cache_dir(dir), options(options), import_dirs(import_dirs)
+    {}
+
+    fs::path const& dir() const noexcept
+    {
+        return cache_dir;
+    }
+
+    // Note:
+    // The object file which is generated for the source file.
+    fs::path object_path_of(fs::path const& source) const;
+
+    // Note:
+    // Return the object file if it is up to date.
+    boost::optional<fs::path> find(fs::path const& source) const;
+
+    // Note:
+    // Record the fingerprint of the object file which has been generated for
+    // the source file.  Failures are ignored and the source file will be simply
+    // compiled again.
+    void store(fs::path const& source, dependencies const& deps) const;
+};
+
+} // namespace incremental
+} // namespace dachs
+
+#endif    // DACHS_INCREMENTAL_HPP_INCLUDED
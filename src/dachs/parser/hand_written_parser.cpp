@@ -0,0 +1,2763 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <unordered_map>
+#include <algorithm>
+#include <iterator>
+#include <iostream>
+#include <cstdint>
+#include <cstddef>
+
+#include <boost/format.hpp>
+#include <boost/optional.hpp>
+
+#include "dachs/ast/ast.hpp"
+#include "dachs/ast/node_arena.hpp"
+#include "dachs/parser/hand_written_parser.hpp"
+#include "dachs/parser/tokenizer.hpp"
+#include "dachs/parser/implicit_import.hpp"
+#include "dachs/exception.hpp"
+#include "dachs/helper/variant.hpp"
+#include "dachs/helper/colorizer.hpp"
+
+namespace dachs {
+namespace syntax {
+namespace hand_written {
+
+namespace detail {
+
+namespace node = ast::node;
+namespace node_type = ast::node_type;
+
+using helper::variant::apply_lambda;
+using helper::variant::get_as;
+
+// Note:
+// Each member function corresponds to the rule of the same name in the Spirit
+// grammar (parser.cpp) and must be kept in sync with it.  The conventions are:
+//
+//   - A rule takes the position by reference and returns whether it matched.
+//     It advances the position only when it matched.
+//   - Rules which set the source location in the Spirit grammar (the rules
+//     registered with qi::on_success()) set it with set_location().
+//   - 'a % b' is list(), '-a' is an optional call whose result is ignored, and
+//     'a - b' checks 'b' without consuming anything before 'a'.
+//   - '>' in the grammar (expectation) throws expectation_failure.
+//
+// typed_expr and compound_stmt are memoized at the position after blanks.  The
+// grammar tries many alternatives which begin with them (e.g. a statement is
+// tried as an initialization, a postfix if, an assignment and an expression in
+// order), so the memo makes parsing linear in practice.  A memoized node may be
+// held by several candidates.  So it must not be modified after it is memoized.
+class parser_impl final {
+
+    using iterator = tokenizer::iterator;
+
+    template<class Node>
+    struct memo_entry {
+        bool matched;
+        Node node;
+        iterator end;
+    };
+
+    struct binary_level {
+        char const* ops[5];
+        bool newline_before_op;
+    };
+
+    // Note:
+    // Binary operators from the tightest binding.  Operators in one level are
+    // tried in the order.  A newline is not permitted before '+' and '-' because
+    // they are also unary operators.
+    static constexpr binary_level const binary_levels[] = {
+        {{"*", "/", "%", nullptr}, true},
+        {{"+", "-", nullptr}, false},
+        {{"<<", ">>", nullptr}, true},
+        {{"<=", ">=", "<", ">", nullptr}, true},
+        {{"==", "!=", nullptr}, true},
+        {{"&", nullptr}, true},
+        {{"^", nullptr}, true},
+        {{"|", nullptr}, true},
+        {{"&&", nullptr}, true},
+        {{"||", nullptr}, true},
+    };
+
+    static constexpr std::size_t const logical_or_level = 9u;
+
+    tokenizer const tok;
+    std::ostream &diagnostics;
+    ast::file_id_type const file;
+    std::shared_ptr<ast::node_arena> const& arena;
+    implicit_import<false> found;
+    std::unordered_map<iterator, memo_entry<node::any_expr>> typed_expr_memo;
+    std::unordered_map<iterator, memo_entry<node::compound_stmt>> compound_stmt_memo;
+
+    template<class Node, class... Args>
+    Node make(Args &&... args) const
+    {
+        return ast::make_in<Node>(arena, std::forward<Args>(args)...);
+    }
+
+    // Note:
+    // Same as position_getter in parser.cpp.  The location begins after the blanks.
+    template<class T>
+    void set_location(std::shared_ptr<T> const& node, iterator const before, iterator const after) const
+    {
+        auto const start = tok.skipped(before);
+        node->location.file = file;
+        node->location.offset = static_cast<std::uint32_t>(start - tok.begin());
+        node->location.length = after < start ? 0u : static_cast<std::uint32_t>(after - start);
+    }
+
+    template<class... Nodes>
+    void set_location(boost::variant<Nodes...> const& node, iterator const before, iterator const after) const
+    {
+        apply_lambda([before, after, this](auto const& n){ this->set_location(n, before, after); }, node);
+    }
+
+    template<class T>
+    bool call(bool (parser_impl::*rule)(iterator &, T &), iterator &i, T &v)
+    {
+        return (this->*rule)(i, v);
+    }
+
+    template<class F, class T>
+    bool call(F const& f, iterator &i, T &v)
+    {
+        return f(i, v);
+    }
+
+    // Note:
+    // 'elem % separator'.  Elements are appended to 'out'.
+    template<class T, class Elem>
+    bool list(iterator &first, std::vector<T> &out, Elem const& elem, bool (parser_impl::*separator)(iterator &) const = &parser_impl::comma)
+    {
+        auto i = first;
+        T e;
+        if (!call(elem, i, e)) {
+            return false;
+        }
+        out.push_back(std::move(e));
+
+        for (auto save = i;; save = i) {
+            T next;
+            if (!(this->*separator)(i) || !call(elem, i, next)) {
+                first = save;
+                return true;
+            }
+            out.push_back(std::move(next));
+        }
+    }
+
+    template<class Memo, class Node, class Parser>
+    bool memoized(Memo &memo, iterator &first, Node &result, Parser const& parse)
+    {
+        auto const start = tok.skipped(first);
+
+        auto const hit = memo.find(start);
+        if (hit != std::end(memo)) {
+            auto const& e = hit->second;
+            if (!e.matched) {
+                return false;
+            }
+
+            result = e.node;
+            first = e.end;
+            return true;
+        }
+
+        auto i = start;
+        bool const matched = parse(i, result);
+        memo.emplace(
+                start,
+                typename Memo::mapped_type{
+                    matched,
+                    matched ? result : Node{},
+                    i
+                }
+            );
+
+        if (matched) {
+            first = i;
+        }
+        return matched;
+    }
+
+    bool peek_keywords(iterator const i, std::initializer_list<char const*> const keywords) const
+    {
+        return std::any_of(
+                std::begin(keywords),
+                std::end(keywords),
+                [i, this](auto const k){ return tok.peek_keyword(i, k); }
+            );
+    }
+
+public:
+
+    parser_impl(iterator const first, iterator const last, ast::file_id_type const f, std::shared_ptr<ast::node_arena> const& a, std::ostream &d)
+        : tok(first, last), diagnostics(d), file(f), arena(a), found()
+    {}
+
+    // sep = +(';' ^ eol)
+    bool sep(iterator &first) const
+    {
+        auto i = first;
+        if (!sep_token(i)) {
+            return false;
+        }
+        while (sep_token(i)) {}
+        first = i;
+        return true;
+    }
+
+    bool sep_token(iterator &i) const
+    {
+        return tok.lit(i, ';') || tok.eol(i);
+    }
+
+    // comma = (',' >> -eol) | (-eol >> ',')
+    bool comma(iterator &first) const
+    {
+        auto i = first;
+        if (tok.lit(i, ',')) {
+            tok.eol(i);
+            first = i;
+            return true;
+        }
+
+        i = first;
+        tok.eol(i);
+        if (tok.lit(i, ',')) {
+            first = i;
+            return true;
+        }
+
+        return false;
+    }
+
+    // trailing_comma = -(',' || eol)
+    void trailing_comma(iterator &i) const
+    {
+        tok.lit(i, ',');
+        tok.eol(i);
+    }
+
+    // KWD(if_kind)
+    bool if_kind(iterator &i, ast::symbol::if_kind &kind) const
+    {
+        if (tok.keyword(i, "if")) {
+            kind = ast::symbol::if_kind::if_;
+            return true;
+        }
+        if (tok.keyword(i, "unless")) {
+            kind = ast::symbol::if_kind::unless;
+            return true;
+        }
+        return false;
+    }
+
+    bool peek_if_kind(iterator i) const
+    {
+        ast::symbol::if_kind k;
+        return if_kind(i, k);
+    }
+
+    // KWD(func_kind)
+    bool func_kind(iterator &i, ast::symbol::func_kind &kind) const
+    {
+        if (tok.keyword(i, "func")) {
+            kind = ast::symbol::func_kind::func;
+            return true;
+        }
+        if (tok.keyword(i, "proc")) {
+            kind = ast::symbol::func_kind::proc;
+            return true;
+        }
+        return false;
+    }
+
+    // KWD("then") || sep
+    bool then_or_sep(iterator &i) const
+    {
+        bool const then = tok.keyword(i, "then");
+        bool const separated = sep(i);
+        return then || separated;
+    }
+
+    // Note:
+    // '-KWD(qi::matches["var"])'.  Engaged when the next character is not an identifier.
+    boost::optional<bool> var_keyword(iterator &i) const
+    {
+        auto j = i;
+        bool const matched = tok.lit(j, "var");
+        if (tok.followed_by_ident(j)) {
+            return boost::none;
+        }
+        i = j;
+        return matched;
+    }
+
+    // -(-eol >> ':' >> -eol >> qualified_type)
+    boost::optional<node::any_type> type_annotation(iterator &i)
+    {
+        auto j = i;
+        tok.eol(j);
+        if (!tok.lit(j, ':')) {
+            return boost::none;
+        }
+        tok.eol(j);
+        node::any_type t;
+        if (!qualified_type(j, t)) {
+            return boost::none;
+        }
+        i = j;
+        return t;
+    }
+
+    node::any_type expect_qualified_type(iterator &i)
+    {
+        node::any_type t;
+        if (!qualified_type(i, t)) {
+            throw expectation_failure{i, "<qualified type>"};
+        }
+        return t;
+    }
+
+    void expect_lit(iterator &i, char const* const s) const
+    {
+        if (!tok.lit(i, s)) {
+            throw expectation_failure{i, (boost::format("\"%1%\"") % s).str()};
+        }
+    }
+
+    void expect_sep(iterator &i) const
+    {
+        if (!sep(i)) {
+            throw expectation_failure{i, "<separater>"};
+        }
+    }
+
+    // Literals {{{
+
+    bool primary_literal(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        node::primary_literal lit;
+
+        bool b;
+        char c;
+        double d;
+        unsigned int u;
+        int n;
+
+        if (tok.boolean_literal(i, b)) {
+            lit = make<node::primary_literal>(b);
+        } else if (tok.character_literal(i, c)) {
+            lit = make<node::primary_literal>(c);
+        } else if (tok.float_literal(i, d)) {
+            lit = make<node::primary_literal>(d);
+        } else if (tok.uinteger_literal(i, u)) {
+            lit = make<node::primary_literal>(u);
+        } else if (tok.integer_literal(i, n)) {
+            lit = make<node::primary_literal>(n);
+        } else {
+            return false;
+        }
+
+        set_location(lit, first, i);
+        expr = std::move(lit);
+        first = i;
+        return true;
+    }
+
+    bool string_literal(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        std::string s;
+        if (!tok.string_literal(i, s)) {
+            return false;
+        }
+
+        found.string_found = true;
+        auto const lit = make<node::string_literal>(std::move(s));
+        set_location(lit, first, i);
+        expr = lit;
+        first = i;
+        return true;
+    }
+
+    bool symbol_literal(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        std::string s;
+        if (!tok.symbol_literal(i, s)) {
+            return false;
+        }
+
+        auto const lit = make<node::symbol_literal>(s);
+        set_location(lit, first, i);
+        expr = lit;
+        first = i;
+        return true;
+    }
+
+    // Note: Location is not set in the Spirit grammar.
+    bool array_literal(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        if (!tok.lit(i, '[')) {
+            return false;
+        }
+
+        std::vector<node::any_expr> elems;
+        {
+            auto j = i;
+            tok.eol(j);
+            if (list(j, elems, &parser_impl::typed_expr)) {
+                trailing_comma(j);
+                i = j;
+            } else {
+                elems.clear();
+            }
+        }
+
+        if (!tok.lit(i, ']')) {
+            return false;
+        }
+
+        found.array_found = true;
+        expr = make<node::array_literal>(elems);
+        first = i;
+        return true;
+    }
+
+    bool tuple_literal(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        if (!tok.lit(i, '(')) {
+            return false;
+        }
+
+        // Note:
+        // Elements are pushed even if the following part fails as in the Spirit grammar.
+        std::vector<node::any_expr> elems;
+        {
+            auto j = i;
+            tok.eol(j);
+            node::any_expr e;
+            if (typed_expr(j, e)) {
+                elems.push_back(e);
+                bool more = false;
+                for (;;) {
+                    auto k = j;
+                    node::any_expr next;
+                    if (!comma(k) || !typed_expr(k, next)) {
+                        break;
+                    }
+                    elems.push_back(next);
+                    j = k;
+                    more = true;
+                }
+                if (more) {
+                    trailing_comma(j);
+                    i = j;
+                }
+            }
+        }
+
+        if (!tok.lit(i, ')')) {
+            return false;
+        }
+
+        auto const lit = make<node::tuple_literal>(elems);
+        set_location(lit, first, i);
+        expr = lit;
+        first = i;
+        return true;
+    }
+
+    bool dict_literal(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        if (!tok.lit(i, '{')) {
+            return false;
+        }
+
+        auto const key_value
+            = [this](iterator &p, node_type::dict_literal::dict_elem_type &kv)
+            {
+                auto j = p;
+                if (!typed_expr(j, kv.first) || !tok.lit(j, "=>")) {
+                    return false;
+                }
+                if (!typed_expr(j, kv.second)) {
+                    throw expectation_failure{j, "<compound expression>"};
+                }
+                p = j;
+                return true;
+            };
+
+        node_type::dict_literal::value_type elems;
+        {
+            auto j = i;
+            tok.eol(j);
+            if (list(j, elems, key_value)) {
+                trailing_comma(j);
+                i = j;
+            } else {
+                elems.clear();
+            }
+        }
+
+        if (!tok.lit(i, '}')) {
+            return false;
+        }
+
+        auto const lit = make<node::dict_literal>(elems);
+        set_location(lit, first, i);
+        expr = lit;
+        first = i;
+        return true;
+    }
+
+    // }}}
+
+    // Expressions {{{
+
+    bool var_ref(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        std::string name;
+        if (!tok.called_function_name(i, name)) {
+            return false;
+        }
+
+        auto const ref = make<node::var_ref>(name);
+        set_location(ref, first, i);
+        expr = ref;
+        first = i;
+        return true;
+    }
+
+    bool var_ref_before_space(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        if (!var_ref(i, expr) || !tok.at(i, ' ') || tok.peek_keyword(i, "as")) {
+            return false;
+        }
+
+        set_location(expr, first, i);
+        first = i;
+        return true;
+    }
+
+    bool parameter(iterator &first, node::parameter &param)
+    {
+        auto i = first;
+        auto const is_var = var_keyword(i);
+
+        std::string name;
+        if (!tok.variable_name(i, name)) {
+            return false;
+        }
+
+        param = make<node::parameter>(is_var, name, type_annotation(i));
+        set_location(param, first, i);
+        first = i;
+        return true;
+    }
+
+    // Note:
+    // Arguments are pushed even if '}' is missing as in the Spirit grammar.
+    void constructor_call(iterator &first, std::vector<node::any_expr> &args)
+    {
+        auto i = first;
+        if (!tok.lit(i, '{')) {
+            return;
+        }
+
+        {
+            auto j = i;
+            tok.eol(j);
+            if (list(j, args, &parser_impl::typed_expr)) {
+                tok.eol(j);
+                i = j;
+            }
+        }
+
+        if (tok.lit(i, '}')) {
+            first = i;
+        }
+    }
+
+    bool object_construct(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        node::any_type type;
+        if (!tok.keyword(i, "new") || !qualified_type(i, type)) {
+            return false;
+        }
+
+        std::vector<node::any_expr> args;
+        constructor_call(i, args);
+
+        boost::optional<node::function_definition> maybe_do = boost::none;
+        {
+            node::function_definition d;
+            if (do_block(i, d)) {
+                maybe_do = d;
+            }
+        }
+
+        auto const construct = make<node::object_construct>(type, args, maybe_do);
+
+        // Note:
+        // Same rewrite as the Spirit grammar.
+        //      new [int]{4u} -> new array{new static_array(int){ 4u }}
+        if (auto const t = get_as<node::primary_type>(type)) {
+            if ((*t)->name == "array" && !(*t)->template_params.empty()) {
+                if (auto const a = get_as<node::array_type>((*t)->template_params[0])) {
+                    auto inner_construct = make<node::object_construct>(*a);
+                    inner_construct->args = std::move(construct->args);
+                    construct->args.clear();
+                    construct->args.push_back(std::move(inner_construct));
+                    (*t)->template_params.clear();
+                }
+            }
+        }
+
+        set_location(construct, first, i);
+        expr = construct;
+        first = i;
+        return true;
+    }
+
+    // '(' >> -(parameter % comma >> trailing_comma) >> ')' >> -(':' > qualified_type) >> -eol >> KWD("in")
+    bool parenthesized_lambda_params(iterator &first, std::vector<node::parameter> &params, std::vector<node::parameter> &result, boost::optional<node::any_type> &ret)
+    {
+        auto i = first;
+        if (!tok.lit(i, '(')) {
+            return false;
+        }
+
+        {
+            auto j = i;
+            if (list(j, params, &parser_impl::parameter)) {
+                trailing_comma(j);
+                i = j;
+            }
+        }
+
+        if (!tok.lit(i, ')')) {
+            return false;
+        }
+
+        {
+            auto j = i;
+            if (tok.lit(j, ':')) {
+                ret = expect_qualified_type(j);
+                i = j;
+            }
+        }
+
+        tok.eol(i);
+        if (!tok.keyword(i, "in")) {
+            return false;
+        }
+
+        result = params;
+        first = i;
+        return true;
+    }
+
+    // Note:
+    // 'params' and 'ret' are shared by the alternatives as the locals of the Spirit rule.
+    bool lambda_expr_oneline(iterator &first, node::function_definition &def)
+    {
+        auto i = first;
+        if (!tok.lit(i, "->")) {
+            return false;
+        }
+        tok.eol(i);
+
+        std::vector<node::parameter> params, result;
+        boost::optional<node::any_type> ret = boost::none;
+
+        if (!parenthesized_lambda_params(i, params, result, ret)) {
+            auto j = i;
+            auto const param_but_in
+                = [this](iterator &p, node::parameter &param)
+                {
+                    return !tok.peek_lit(p, "in") && parameter(p, param);
+                };
+
+            if (list(j, params, param_but_in)) {
+                trailing_comma(j);
+                if (tok.keyword(j, "in")) {
+                    result = params;
+                    i = j;
+                }
+            }
+        }
+
+        tok.eol(i);
+
+        node::any_expr expr;
+        if (!typed_expr(i, expr)) {
+            return false;
+        }
+
+        def = make<node::function_definition>(
+                result,
+                make<node::statement_block>(
+                    make<node::return_stmt>(expr)
+                ),
+                ret
+            );
+        set_location(def, first, i);
+        first = i;
+        return true;
+    }
+
+    bool lambda_expr_do_end(iterator &first, node::function_definition &def)
+    {
+        auto i = first;
+        if (!tok.lit(i, "->")) {
+            return false;
+        }
+        tok.eol(i);
+
+        std::vector<node::parameter> params;
+        boost::optional<node::any_type> ret = boost::none;
+
+        bool parenthesized = false;
+        {
+            auto j = i;
+            if (tok.lit(j, '(')) {
+                std::vector<node::parameter> ps;
+                {
+                    auto k = j;
+                    if (list(k, ps, &parser_impl::parameter)) {
+                        trailing_comma(k);
+                        j = k;
+                    } else {
+                        ps.clear();
+                    }
+                }
+
+                if (tok.lit(j, ')')) {
+                    params = std::move(ps);
+                    auto k = j;
+                    if (tok.lit(k, ':')) {
+                        ret = expect_qualified_type(k);
+                        j = k;
+                    }
+                    parenthesized = true;
+                    i = j;
+                }
+            }
+        }
+
+        if (!parenthesized) {
+            auto j = i;
+            auto const param_but_do
+                = [this](iterator &p, node::parameter &param)
+                {
+                    return !tok.peek_lit(p, "do") && parameter(p, param);
+                };
+
+            std::vector<node::parameter> ps;
+            if (list(j, ps, param_but_do)) {
+                params = std::move(ps);
+                i = j;
+            }
+        }
+
+        tok.eol(i);
+        if (!tok.keyword(i, "do")) {
+            return false;
+        }
+        tok.eol(i);
+
+        node::statement_block body;
+        stmt_block_before_end(i, body);
+        sep(i);
+        if (!tok.lit(i, "end")) {
+            return false;
+        }
+
+        def = make<node::function_definition>(params, body, ret);
+        set_location(def, first, i);
+        first = i;
+        return true;
+    }
+
+    bool lambda_expr(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        node::function_definition def;
+        if (!lambda_expr_do_end(i, def) && !lambda_expr_oneline(i, def)) {
+            return false;
+        }
+
+        auto const lambda = make<node::lambda_expr>(def);
+        set_location(lambda, first, i);
+        expr = lambda;
+        first = i;
+        return true;
+    }
+
+    bool begin_end_expr(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        if (!tok.keyword(i, "begin")) {
+            return false;
+        }
+        tok.eol(i);
+
+        node::block_expr block;
+        if (!block_expr_before_end(i, block)) {
+            return false;
+        }
+        sep(i);
+        if (!tok.lit(i, "end")) {
+            return false;
+        }
+
+        set_location(block, first, i);
+        expr = block;
+        first = i;
+        return true;
+    }
+
+    bool let_expr(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        if (!tok.keyword(i, "let")) {
+            return false;
+        }
+        tok.eol(i);
+
+        std::vector<node::initialize_stmt> inits;
+        if (!list(i, inits, &parser_impl::initialize_stmt, &parser_impl::sep)) {
+            return false;
+        }
+        tok.eol(i);
+        if (!tok.keyword(i, "in")) {
+            return false;
+        }
+        tok.eol(i);
+
+        node::any_expr last;
+        if (!typed_expr(i, last)) {
+            return false;
+        }
+
+        auto const block = make<node::block_expr>(inits, last);
+        set_location(block, first, i);
+        expr = block;
+        first = i;
+        return true;
+    }
+
+    // '(' >> -eol >> typed_expr >> -eol >> ')'
+    bool parenthesized_expr(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        if (!tok.lit(i, '(')) {
+            return false;
+        }
+        tok.eol(i);
+        if (!unmemoized_typed_expr(i, expr)) {
+            return false;
+        }
+        tok.eol(i);
+        if (!tok.lit(i, ')')) {
+            return false;
+        }
+        first = i;
+        return true;
+    }
+
+    bool primary_expr(iterator &first, node::any_expr &expr)
+    {
+        return object_construct(first, expr)
+            || lambda_expr(first, expr)
+            || begin_end_expr(first, expr)
+            || let_expr(first, expr)
+            || primary_literal(first, expr)
+            || string_literal(first, expr)
+            || array_literal(first, expr)
+            || symbol_literal(first, expr)
+            || dict_literal(first, expr)
+            || tuple_literal(first, expr)
+            || var_ref(first, expr)
+            || parenthesized_expr(first, expr);
+    }
+
+    boost::optional<node::function_definition> optional_do_block(iterator &i)
+    {
+        node::function_definition d;
+        if (do_block(i, d)) {
+            return d;
+        }
+        return boost::none;
+    }
+
+    // -('|' >> (parameter % comma) >> '|')
+    std::vector<node::parameter> block_params(iterator &i)
+    {
+        auto j = i;
+        std::vector<node::parameter> params;
+        if (tok.lit(j, '|') && list(j, params, &parser_impl::parameter) && tok.lit(j, '|')) {
+            i = j;
+            return params;
+        }
+        return {};
+    }
+
+    bool do_block(iterator &first, node::function_definition &def)
+    {
+        {
+            auto i = first;
+            if (tok.keyword(i, "do")) {
+                auto const params = block_params(i);
+                tok.eol(i);
+                node::statement_block body;
+                stmt_block_before_end(i, body);
+                sep(i);
+                if (tok.lit(i, "end")) {
+                    def = make<node::function_definition>(params, body);
+                    set_location(def, first, i);
+                    first = i;
+                    return true;
+                }
+            }
+        }
+
+        auto i = first;
+        if (!tok.lit(i, '{')) {
+            return false;
+        }
+        auto const params = block_params(i);
+        tok.eol(i);
+        node::statement_block body;
+        if (!oneline_lambda_stmt_block(i, body)) {
+            return false;
+        }
+        sep(i);
+        if (!tok.lit(i, '}')) {
+            return false;
+        }
+
+        def = make<node::function_definition>(params, body);
+        set_location(def, first, i);
+        first = i;
+        return true;
+    }
+
+    // Note:
+    // Postfixes after '.'.  'first' is after the '.' and newlines.
+    //   primary.name(...) [do-end]
+    //   primary.name ... do-end
+    //   primary.name ...
+    //   primary.name [do-end]
+    //   primary.name
+    bool member_postfix(iterator &first, node::any_expr &expr)
+    {
+        auto const typed_expr_but_do
+            = [this](iterator &p, node::any_expr &e)
+            {
+                return !tok.peek_lit(p, "do") && typed_expr(p, e);
+            };
+
+        {
+            auto i = first;
+            node::any_expr name;
+            if (var_ref(i, name) && tok.lit(i, '(')) {
+                std::vector<node::any_expr> args;
+                if (!list(i, args, &parser_impl::typed_expr)) {
+                    args.clear();
+                }
+                trailing_comma(i);
+                if (tok.lit(i, ')')) {
+                    auto const maybe_do = optional_do_block(i);
+                    expr = make<node::func_invocation>(name, expr, args, maybe_do);
+                    first = i;
+                    return true;
+                }
+            }
+        }
+
+        {
+            auto i = first;
+            node::any_expr name;
+            std::vector<node::any_expr> args;
+            node::function_definition d;
+            if (var_ref_before_space(i, name) && list(i, args, typed_expr_but_do) && do_block(i, d)) {
+                expr = make<node::func_invocation>(name, expr, args, d);
+                first = i;
+                return true;
+            }
+        }
+
+        {
+            auto i = first;
+            node::any_expr name;
+            if (var_ref_before_space(i, name) && !tok.peek_lit(i, "+") && !tok.peek_lit(i, "-")) {
+                auto const arg
+                    = [this](iterator &p, node::any_expr &e)
+                    {
+                        return !tok.peek_lit(p, "end")
+                            && !tok.peek_lit(p, "else")
+                            && !tok.peek_lit(p, "then")
+                            && !tok.peek_lit(p, "do")
+                            && typed_expr(p, e);
+                    };
+
+                std::vector<node::any_expr> args;
+                if (list(i, args, arg)) {
+                    expr = make<node::func_invocation>(name, expr, args);
+                    first = i;
+                    return true;
+                }
+            }
+        }
+
+        {
+            auto i = first;
+            node::any_expr name;
+            node::function_definition d;
+            if (!tok.peek_lit(i, "do") && var_ref(i, name) && do_block(i, d)) {
+                expr = make<node::func_invocation>(d, name, expr);
+                first = i;
+                return true;
+            }
+        }
+
+        {
+            auto i = first;
+            std::string name;
+            if (tok.called_function_name(i, name)) {
+                expr = make<node::ufcs_invocation>(expr, name, node_type::ufcs_invocation::set_location_tag{});
+                first = i;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Note:
+    // One postfix of postfix_expr.  'expr' is replaced with the new node.
+    //   primary.name ...  (see member_postfix())
+    //   primary ... do-end
+    //   primary[...]
+    //   primary(...)
+    bool postfix(iterator &first, node::any_expr &expr)
+    {
+        {
+            auto i = first;
+            tok.eol(i);
+            if (tok.lit(i, '.')) {
+                tok.eol(i);
+                if (member_postfix(i, expr)) {
+                    first = i;
+                    return true;
+                }
+            }
+        }
+
+        // Note:
+        // The space is checked just at the end of the previous element without skipping.
+        if (tok.at(first, ' ') && !tok.peek_keyword(first, "as")) {
+            auto i = first;
+            auto const typed_expr_but_do
+                = [this](iterator &p, node::any_expr &e)
+                {
+                    return !tok.peek_lit(p, "do") && typed_expr(p, e);
+                };
+
+            std::vector<node::any_expr> args;
+            node::function_definition d;
+            if (list(i, args, typed_expr_but_do) && do_block(i, d)) {
+                expr = make<node::func_invocation>(expr, args, d);
+                first = i;
+                return true;
+            }
+        }
+
+        {
+            auto i = first;
+            if (tok.lit(i, '[')) {
+                tok.eol(i);
+                node::any_expr index;
+                if (typed_expr(i, index)) {
+                    tok.eol(i);
+                    if (tok.lit(i, ']')) {
+                        expr = make<node::index_access>(expr, index);
+                        first = i;
+                        return true;
+                    }
+                }
+            }
+        }
+
+        {
+            auto i = first;
+            if (tok.lit(i, '(')) {
+                tok.eol(i);
+                std::vector<node::any_expr> args;
+                if (!list(i, args, &parser_impl::typed_expr)) {
+                    args.clear();
+                }
+                trailing_comma(i);
+                if (tok.lit(i, ')')) {
+                    auto const maybe_do = optional_do_block(i);
+                    expr = make<node::func_invocation>(expr, args, maybe_do);
+                    first = i;
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    bool postfix_expr(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        if (!primary_expr(i, expr)) {
+            return false;
+        }
+
+        while (postfix(i, expr)) {}
+
+        set_location(expr, first, i);
+        first = i;
+        return true;
+    }
+
+    bool unary_operator(iterator &i, std::string &op) const
+    {
+        for (auto const o : {"+", "-", "~", "!"}) {
+            if (tok.lit(i, o)) {
+                op = o;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool unary_expr(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        std::string op;
+        node::any_expr operand;
+        if (unary_operator(i, op) && unary_expr(i, operand)) {
+            expr = make<node::unary_expr>(op, operand);
+        } else {
+            i = first;
+            if (!postfix_expr(i, expr)) {
+                return false;
+            }
+        }
+
+        set_location(expr, first, i);
+        first = i;
+        return true;
+    }
+
+    bool cast_expr(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        if (!unary_expr(i, expr)) {
+            return false;
+        }
+
+        for (;;) {
+            auto j = i;
+            tok.eol(j);
+            if (!tok.keyword(j, "as")) {
+                break;
+            }
+            tok.eol(j);
+            expr = make<node::cast_expr>(expr, expect_qualified_type(j));
+            i = j;
+        }
+
+        set_location(expr, first, i);
+        first = i;
+        return true;
+    }
+
+    bool binary_operand(iterator &i, node::any_expr &expr, std::size_t const level)
+    {
+        return level == 0u ? cast_expr(i, expr) : binary_expr(i, expr, level - 1u);
+    }
+
+    // Note:
+    // mult_expr, additive_expr, ..., logical_or_expr.  All are left associative.
+    bool binary_expr(iterator &first, node::any_expr &expr, std::size_t const level)
+    {
+        auto i = first;
+        if (!binary_operand(i, expr, level)) {
+            return false;
+        }
+
+        auto const& l = binary_levels[level];
+        for (;;) {
+            auto j = i;
+            if (l.newline_before_op) {
+                tok.eol(j);
+            }
+
+            char const* op = nullptr;
+            for (auto o = l.ops; *o; ++o) {
+                if (tok.lit(j, *o)) {
+                    op = *o;
+                    break;
+                }
+            }
+            if (!op) {
+                break;
+            }
+
+            tok.eol(j);
+            node::any_expr rhs;
+            if (!binary_operand(j, rhs, level)) {
+                break;
+            }
+
+            expr = make<node::binary_expr>(expr, op, rhs);
+            i = j;
+        }
+
+        set_location(expr, first, i);
+        first = i;
+        return true;
+    }
+
+    bool range_expr(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        if (!binary_expr(i, expr, logical_or_level)) {
+            return false;
+        }
+
+        {
+            auto j = i;
+            tok.eol(j);
+            char const* const op
+                = tok.lit(j, "...") ? "..."
+                : tok.lit(j, "..") ? ".."
+                : nullptr;
+            if (op) {
+                tok.eol(j);
+                node::any_expr rhs;
+                if (binary_expr(j, rhs, logical_or_level)) {
+                    expr = make<node::object_construct>(std::string{op}, expr, rhs);
+                    found.range_expr_found = true;
+                    i = j;
+                }
+            }
+        }
+
+        set_location(expr, first, i);
+        first = i;
+        return true;
+    }
+
+    bool typed_expr(iterator &first, node::any_expr &expr)
+    {
+        return memoized(
+                typed_expr_memo,
+                first,
+                expr,
+                [this](iterator &i, node::any_expr &e){ return unmemoized_typed_expr(i, e); }
+            );
+    }
+
+    // Note:
+    // postfix_expr extends the location of '(expr)' to the parens.  The node of
+    // 'expr' is parsed without the memo not to modify the node shared with other
+    // candidates which failed.
+    bool unmemoized_typed_expr(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        if (!if_expr(i, expr) && !case_expr(i, expr) && !switch_expr(i, expr) && !range_expr(i, expr)) {
+            return false;
+        }
+
+        {
+            auto j = i;
+            if (tok.lit(j, ':')) {
+                tok.eol(j);
+                node::any_type t;
+                if (qualified_type(j, t)) {
+                    expr = make<node::typed_expr>(expr, t);
+                    i = j;
+                }
+            }
+        }
+
+        set_location(expr, first, i);
+        first = i;
+        return true;
+    }
+
+    // Note:
+    // '*((compound_stmt - (typed_expr >> -sep >> terminator)) >> sep)'
+    // The last expression of the block is not parsed as a statement.
+    template<class Terminator>
+    std::vector<node::compound_stmt> stmts_before_last_expr(iterator &i, Terminator const& terminated)
+    {
+        std::vector<node::compound_stmt> stmts;
+        for (;;) {
+            {
+                auto j = i;
+                node::any_expr e;
+                if (typed_expr(j, e)) {
+                    sep(j);
+                    if (terminated(j)) {
+                        break;
+                    }
+                }
+            }
+
+            auto j = i;
+            node::compound_stmt s;
+            if (!compound_stmt(j, s) || !sep(j)) {
+                break;
+            }
+            stmts.push_back(std::move(s));
+            i = j;
+        }
+        return stmts;
+    }
+
+    bool block_expr_before_end(iterator &first, node::block_expr &block)
+    {
+        auto i = first;
+        auto const stmts = stmts_before_last_expr(i, [this](iterator j){ return tok.lit(j, "end"); });
+
+        node::any_expr last;
+        if (!typed_expr(i, last)) {
+            return false;
+        }
+
+        block = make<node::block_expr>(stmts, last);
+        set_location(block, first, i);
+        first = i;
+        return true;
+    }
+
+    // Note:
+    // Block of if_expr and case_expr.  The block ends before KWD(kwd1|kwd2).
+    bool block_expr_before(iterator &first, node::block_expr &block, char const* const kwd1, char const* const kwd2)
+    {
+        auto i = first;
+        auto const stmts = stmts_before_last_expr(
+                i,
+                [kwd1, kwd2, this](iterator j)
+                {
+                    return (tok.lit(j, kwd1) || tok.lit(j, kwd2)) && !tok.followed_by_ident(j);
+                }
+            );
+
+        node::any_expr last;
+        if (peek_keywords(i, {kwd1, kwd2}) || !typed_expr(i, last)) {
+            return false;
+        }
+
+        block = make<node::block_expr>(stmts, last);
+        set_location(block, first, i);
+        first = i;
+        return true;
+    }
+
+    bool if_then_block_expr(iterator &first, node::block_expr &block)
+    {
+        return block_expr_before(first, block, "elseif", "else");
+    }
+
+    bool case_when_block_expr(iterator &first, node::block_expr &block)
+    {
+        return block_expr_before(first, block, "when", "else");
+    }
+
+    bool typed_expr_but_then(iterator &i, node::any_expr &expr)
+    {
+        return !tok.peek_keyword(i, "then") && typed_expr(i, expr);
+    }
+
+    // KWD("else") >> -sep >> block_expr_before_end >> -sep >> "end"
+    bool else_block_expr_and_end(iterator &i, node::block_expr &else_block)
+    {
+        if (!tok.keyword(i, "else")) {
+            return false;
+        }
+        sep(i);
+        if (!block_expr_before_end(i, else_block)) {
+            return false;
+        }
+        sep(i);
+        return tok.lit(i, "end");
+    }
+
+    bool if_expr(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        ast::symbol::if_kind kind;
+        node::any_expr cond;
+        node::block_expr then;
+        if (!if_kind(i, kind) || !typed_expr_but_then(i, cond) || !then_or_sep(i) || !if_then_block_expr(i, then)) {
+            return false;
+        }
+        sep(i);
+
+        std::vector<node_type::if_expr::block_type> elseifs;
+        for (;;) {
+            auto j = i;
+            node::any_expr c;
+            node::block_expr b;
+            if (!tok.keyword(j, "elseif") || !typed_expr_but_then(j, c) || !then_or_sep(j) || !if_then_block_expr(j, b)) {
+                break;
+            }
+            sep(j);
+            elseifs.emplace_back(c, b);
+            i = j;
+        }
+
+        node::block_expr else_block;
+        if (!else_block_expr_and_end(i, else_block)) {
+            return false;
+        }
+
+        auto const e = make<node::if_expr>(kind, cond, then, elseifs, else_block);
+        set_location(e, first, i);
+        expr = e;
+        first = i;
+        return true;
+    }
+
+    // KWD("when") >> (typed_expr - KWD("then")) >> (KWD("then") || sep) >> case_when_block_expr >> -sep
+    bool case_when_block(iterator &first, node::any_expr &cond, node::block_expr &block)
+    {
+        auto i = first;
+        if (!tok.keyword(i, "when") || !typed_expr_but_then(i, cond) || !then_or_sep(i) || !case_when_block_expr(i, block)) {
+            return false;
+        }
+        sep(i);
+        first = i;
+        return true;
+    }
+
+    bool case_expr(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        if (!tok.lit(i, "case") || !sep(i)) {
+            return false;
+        }
+
+        std::vector<node_type::if_expr::block_type> whens;
+        for (;;) {
+            node::any_expr cond;
+            node::block_expr block;
+            if (!case_when_block(i, cond, block)) {
+                break;
+            }
+            whens.emplace_back(cond, block);
+        }
+        if (whens.empty()) {
+            return false;
+        }
+
+        node::block_expr else_block;
+        if (!else_block_expr_and_end(i, else_block)) {
+            return false;
+        }
+
+        auto const e = make<node::if_expr>(ast::symbol::if_kind::case_, whens, else_block);
+        set_location(e, first, i);
+        expr = e;
+        first = i;
+        return true;
+    }
+
+    bool switch_expr(iterator &first, node::any_expr &expr)
+    {
+        auto i = first;
+        node::any_expr target;
+        if (!tok.lit(i, "case") || !typed_expr(i, target) || !sep(i)) {
+            return false;
+        }
+
+        std::vector<node_type::switch_expr::when_type> whens;
+        for (;;) {
+            auto j = i;
+            std::vector<node::any_expr> conds;
+            node::block_expr block;
+            if (!tok.keyword(j, "when")
+                    || !list(j, conds, &parser_impl::typed_expr_but_then)
+                    || !then_or_sep(j)
+                    || !case_when_block_expr(j, block)) {
+                break;
+            }
+            sep(j);
+            whens.emplace_back(conds, block);
+            i = j;
+        }
+        if (whens.empty()) {
+            return false;
+        }
+
+        node::block_expr else_block;
+        if (!else_block_expr_and_end(i, else_block)) {
+            return false;
+        }
+
+        auto const e = make<node::switch_expr>(target, whens, else_block);
+        set_location(e, first, i);
+        expr = e;
+        first = i;
+        return true;
+    }
+
+    // }}}
+
+    // Types {{{
+
+    // -('(' > -eol > qualified_type > -eol > ')')
+    boost::optional<node::any_type> type_param_in_parens(iterator &i)
+    {
+        auto j = i;
+        if (!tok.lit(j, '(')) {
+            return boost::none;
+        }
+        tok.eol(j);
+        auto const param = expect_qualified_type(j);
+        tok.eol(j);
+        expect_lit(j, ")");
+        i = j;
+        return param;
+    }
+
+    bool primary_type(iterator &first, node::any_type &type)
+    {
+        auto i = first;
+        if (tok.lit(i, "static_array")) {
+            type = make<node::array_type>(type_param_in_parens(i));
+        } else if (tok.lit(i, "pointer")) {
+            type = make<node::pointer_type>(type_param_in_parens(i));
+        } else {
+            std::string name;
+            if (!tok.variable_name(i, name)) {
+                return false;
+            }
+
+            std::vector<node::any_type> templates;
+            {
+                auto j = i;
+                if (tok.lit(j, '(')) {
+                    tok.eol(j);
+                    std::vector<node::any_type> params;
+                    if (list(j, params, &parser_impl::qualified_type)) {
+                        tok.eol(j);
+                        if (tok.lit(j, ')')) {
+                            templates = std::move(params);
+                            i = j;
+                        }
+                    }
+                }
+            }
+
+            if (name == "array") {
+                found.array_found = true;
+            } else if (name == "string") {
+                found.string_found = true;
+            }
+
+            type = make<node::primary_type>(name, templates);
+        }
+
+        set_location(type, first, i);
+        first = i;
+        return true;
+    }
+
+    // Note: Location is not set in the Spirit grammar.
+    bool nested_type(iterator &first, node::any_type &type)
+    {
+        {
+            auto i = first;
+            if (tok.lit(i, '(')) {
+                tok.eol(i);
+                if (qualified_type(i, type)) {
+                    tok.eol(i);
+                    if (tok.lit(i, ')')) {
+                        first = i;
+                        return true;
+                    }
+                }
+            }
+        }
+
+        return primary_type(first, type);
+    }
+
+    bool array_type(iterator &first, node::any_type &type)
+    {
+        auto i = first;
+        if (!tok.lit(i, '[')) {
+            return false;
+        }
+        tok.eol(i);
+        node::any_type elem;
+        if (!qualified_type(i, elem)) {
+            return false;
+        }
+        tok.eol(i);
+        if (!tok.lit(i, ']')) {
+            return false;
+        }
+
+        found.array_found = true;
+        type = make<node::primary_type>(
+                "array",
+                std::vector<node::any_type>{
+                    make<node::pointer_type>(elem)
+                }
+            );
+        set_location(type, first, i);
+        first = i;
+        return true;
+    }
+
+    bool dict_type(iterator &first, node::any_type &type)
+    {
+        auto i = first;
+        node::any_type key, value;
+        if (!tok.lit(i, '{')) {
+            return false;
+        }
+        tok.eol(i);
+        if (!qualified_type(i, key)) {
+            return false;
+        }
+        tok.eol(i);
+        if (!tok.lit(i, "=>")) {
+            return false;
+        }
+        tok.eol(i);
+        if (!qualified_type(i, value)) {
+            return false;
+        }
+        tok.eol(i);
+        if (!tok.lit(i, '}')) {
+            return false;
+        }
+
+        type = make<node::dict_type>(key, value);
+        set_location(type, first, i);
+        first = i;
+        return true;
+    }
+
+    bool tuple_type(iterator &first, node::any_type &type)
+    {
+        auto i = first;
+        if (!tok.lit(i, '(')) {
+            return false;
+        }
+
+        std::vector<node::any_type> elems;
+        {
+            auto j = i;
+            tok.eol(j);
+            node::any_type t;
+            if (qualified_type(j, t)) {
+                elems.push_back(t);
+                bool more = false;
+                for (;;) {
+                    auto k = j;
+                    node::any_type next;
+                    if (!comma(k) || !qualified_type(k, next)) {
+                        break;
+                    }
+                    elems.push_back(next);
+                    j = k;
+                    more = true;
+                }
+                if (more) {
+                    trailing_comma(j);
+                    i = j;
+                }
+            }
+        }
+
+        if (!tok.lit(i, ')')) {
+            return false;
+        }
+
+        type = make<node::tuple_type>(elems);
+        set_location(type, first, i);
+        first = i;
+        return true;
+    }
+
+    // '(' >> -(-eol >> qualified_type % comma >> trailing_comma) >> ')'
+    bool func_type_params(iterator &first, std::vector<node::any_type> &params)
+    {
+        auto i = first;
+        if (!tok.lit(i, '(')) {
+            return false;
+        }
+        {
+            auto j = i;
+            tok.eol(j);
+            if (list(j, params, &parser_impl::qualified_type)) {
+                trailing_comma(j);
+                i = j;
+            } else {
+                params.clear();
+            }
+        }
+        if (!tok.lit(i, ')')) {
+            return false;
+        }
+        first = i;
+        return true;
+    }
+
+    bool func_type(iterator &first, node::any_type &type)
+    {
+        auto i = first;
+        std::vector<node::any_type> params;
+
+        if (tok.lit(i, "func") && func_type_params(i, params)) {
+            auto const ret = type_annotation(i);
+            type = make<node::func_type>(params, ret);
+        } else if ((i = first, tok.lit(i, "proc")) && func_type_params(i, params)) {
+            type = make<node::func_type>(params);
+        } else if ((i = first, tok.keyword(i, "func"))) {
+            // Note:
+            // Special case for callable types template 'func'
+            type = make<node::func_type>();
+        } else {
+            return false;
+        }
+
+        set_location(type, first, i);
+        first = i;
+        return true;
+    }
+
+    bool typeof_type(iterator &first, node::any_type &type)
+    {
+        auto i = first;
+        if (!tok.lit(i, "typeof") || !tok.lit(i, '(')) {
+            return false;
+        }
+
+        node::any_expr expr;
+        if (!typed_expr(i, expr)) {
+            throw expectation_failure{i, "<compound expression>"};
+        }
+        expect_lit(i, ")");
+
+        type = make<node::typeof_type>(expr);
+        set_location(type, first, i);
+        first = i;
+        return true;
+    }
+
+    bool compound_type(iterator &first, node::any_type &type)
+    {
+        return func_type(first, type)
+            || array_type(first, type)
+            || dict_type(first, type)
+            || tuple_type(first, type)
+            || typeof_type(first, type)
+            || nested_type(first, type);
+    }
+
+    // Note:
+    // The qualifier consumes the blanks after the type even if it doesn't match.
+    // They are included in the location as in the Spirit grammar.
+    bool qualified_type(iterator &first, node::any_type &type)
+    {
+        auto i = first;
+        if (!compound_type(i, type)) {
+            return false;
+        }
+
+        if (tok.lit(i, '?')) {
+            type = make<node::qualified_type>(ast::symbol::qualifier::maybe, type);
+        }
+
+        set_location(type, first, i);
+        first = i;
+        return true;
+    }
+
+    // }}}
+
+    // Statements {{{
+
+    bool assign_operator(iterator &i, std::string &op) const
+    {
+        for (auto const o : {"=", "*=", "/=", "%=", "+=", "-=", "<<=", ">>=", "&=", "^=", "|=", "&&=", "||="}) {
+            if (tok.lit(i, o)) {
+                op = o;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool assignment_stmt(iterator &first, node::assignment_stmt &stmt)
+    {
+        auto i = first;
+        std::vector<node::any_expr> lhs, rhs;
+        std::string op;
+        if (!list(i, lhs, &parser_impl::typed_expr) || !assign_operator(i, op)) {
+            return false;
+        }
+        tok.eol(i);
+        if (!list(i, rhs, &parser_impl::typed_expr)) {
+            return false;
+        }
+
+        stmt = make<node::assignment_stmt>(lhs, op, rhs);
+        set_location(stmt, first, i);
+        first = i;
+        return true;
+    }
+
+    bool variable_decl(iterator &first, node::variable_decl &decl)
+    {
+        auto i = first;
+        auto const is_var = var_keyword(i);
+
+        std::string name;
+        if (!tok.variable_name(i, name)) {
+            return false;
+        }
+
+        decl = make<node::variable_decl>(is_var, name, type_annotation(i));
+        set_location(decl, first, i);
+        first = i;
+        return true;
+    }
+
+    bool variable_decl_without_init(iterator &first, node::variable_decl &decl)
+    {
+        auto i = first;
+        std::string name;
+        if (!tok.keyword(i, "var") || !tok.variable_name(i, name)) {
+            return false;
+        }
+        tok.eol(i);
+        if (!tok.lit(i, ':')) {
+            return false;
+        }
+        tok.eol(i);
+        node::any_type type;
+        if (!qualified_type(i, type)) {
+            return false;
+        }
+
+        decl = make<node::variable_decl>(true, name, type);
+        set_location(decl, first, i);
+        first = i;
+        return true;
+    }
+
+    bool initialize_stmt(iterator &first, node::initialize_stmt &stmt)
+    {
+        {
+            auto i = first;
+            std::vector<node::variable_decl> decls;
+            std::vector<node::any_expr> rhs;
+            if (list(i, decls, &parser_impl::variable_decl)) {
+                trailing_comma(i);
+                if (tok.lit(i, ":=")) {
+                    tok.eol(i);
+                    if (list(i, rhs, &parser_impl::typed_expr)) {
+                        stmt = make<node::initialize_stmt>(decls, rhs);
+                        set_location(stmt, first, i);
+                        first = i;
+                        return true;
+                    }
+                }
+            }
+        }
+
+        auto i = first;
+        std::vector<node::variable_decl> decls;
+        if (!list(i, decls, &parser_impl::variable_decl_without_init)) {
+            return false;
+        }
+
+        stmt = make<node::initialize_stmt>(decls);
+        set_location(stmt, first, i);
+        first = i;
+        return true;
+    }
+
+    // Note:
+    // '-((compound_stmt - KWD(excluded)...) % sep)'
+    bool statement_block_before(iterator &first, node::statement_block &block, std::initializer_list<char const*> const excluded)
+    {
+        auto i = first;
+        std::vector<node::compound_stmt> stmts;
+        auto const stmt_but_excluded
+            = [excluded, this](iterator &p, node::compound_stmt &s)
+            {
+                return !peek_keywords(p, excluded) && compound_stmt(p, s);
+            };
+
+        if (!list(i, stmts, stmt_but_excluded, &parser_impl::sep)) {
+            stmts.clear();
+        }
+
+        block = make<node::statement_block>(stmts);
+        set_location(block, first, i);
+        first = i;
+        return true;
+    }
+
+    bool stmt_block_before_end(iterator &first, node::statement_block &block)
+    {
+        return statement_block_before(first, block, {"end"});
+    }
+
+    bool if_then_stmt_block(iterator &first, node::statement_block &block)
+    {
+        return statement_block_before(first, block, {"end", "elseif", "else", "then"});
+    }
+
+    bool func_body_stmt_block(iterator &first, node::statement_block &block)
+    {
+        return statement_block_before(first, block, {"ensure", "end"});
+    }
+
+    // *((compound_stmt - KWD("end") - KWD("else") - KWD("when")) >> sep)
+    bool case_when_stmt_block(iterator &first, node::statement_block &block)
+    {
+        auto i = first;
+        std::vector<node::compound_stmt> stmts;
+        for (;;) {
+            auto j = i;
+            node::compound_stmt s;
+            if (peek_keywords(j, {"end", "else", "when"}) || !compound_stmt(j, s) || !sep(j)) {
+                break;
+            }
+            stmts.push_back(std::move(s));
+            i = j;
+        }
+
+        block = make<node::statement_block>(stmts);
+        set_location(block, first, i);
+        first = i;
+        return true;
+    }
+
+    bool oneline_lambda_stmt_block(iterator &first, node::statement_block &block)
+    {
+        auto i = first;
+        auto const stmts = stmts_before_last_expr(i, [this](iterator j){ return tok.lit(j, '}'); });
+
+        node::any_expr expr;
+        if (!typed_expr(i, expr)) {
+            return false;
+        }
+
+        block = make<node::statement_block>(stmts);
+        auto ret = make<node::return_stmt>(expr);
+        ret->location = node::location_of(expr);
+        block->value.emplace_back(std::move(ret));
+
+        set_location(block, first, i);
+        first = i;
+        return true;
+    }
+
+    // -(KWD("else") >> -sep >> stmt_block_before_end >> -sep)
+    boost::optional<node::statement_block> else_stmt_block(iterator &i)
+    {
+        auto j = i;
+        if (!tok.keyword(j, "else")) {
+            return boost::none;
+        }
+        sep(j);
+        node::statement_block block;
+        stmt_block_before_end(j, block);
+        sep(j);
+        i = j;
+        return block;
+    }
+
+    bool if_stmt(iterator &first, node::if_stmt &stmt)
+    {
+        auto i = first;
+        ast::symbol::if_kind kind;
+        node::any_expr cond;
+        node::statement_block then;
+        if (!if_kind(i, kind) || !typed_expr_but_then(i, cond) || !then_or_sep(i) || !if_then_stmt_block(i, then)) {
+            return false;
+        }
+        sep(i);
+
+        std::vector<node_type::if_stmt::clause_type> elseifs;
+        for (;;) {
+            auto j = i;
+            node::any_expr c;
+            node::statement_block b;
+            if (!tok.keyword(j, "elseif") || !typed_expr_but_then(j, c) || !then_or_sep(j) || !if_then_stmt_block(j, b)) {
+                break;
+            }
+            sep(j);
+            elseifs.emplace_back(c, b);
+            i = j;
+        }
+
+        auto const maybe_else = else_stmt_block(i);
+        if (!tok.lit(i, "end")) {
+            return false;
+        }
+
+        stmt = make<node::if_stmt>(kind, cond, then, elseifs, maybe_else);
+        set_location(stmt, first, i);
+        first = i;
+        return true;
+    }
+
+    bool return_stmt(iterator &first, node::return_stmt &stmt)
+    {
+        auto i = first;
+        if (!tok.keyword(i, "ret")) {
+            return false;
+        }
+
+        std::vector<node::any_expr> exprs;
+        if (!list(i, exprs, &parser_impl::typed_expr)) {
+            exprs.clear();
+        }
+
+        stmt = make<node::return_stmt>(exprs);
+        set_location(stmt, first, i);
+        first = i;
+        return true;
+    }
+
+    bool case_stmt(iterator &first, node::if_stmt &stmt)
+    {
+        auto i = first;
+        if (!tok.lit(i, "case") || !sep(i)) {
+            return false;
+        }
+
+        std::vector<node_type::if_stmt::clause_type> whens;
+        for (;;) {
+            auto j = i;
+            node::any_expr cond;
+            node::statement_block block;
+            if (!tok.keyword(j, "when") || !typed_expr_but_then(j, cond) || !then_or_sep(j) || !case_when_stmt_block(j, block)) {
+                break;
+            }
+            whens.emplace_back(cond, block);
+            i = j;
+        }
+        if (whens.empty()) {
+            return false;
+        }
+
+        auto const maybe_else = else_stmt_block(i);
+        if (!tok.lit(i, "end")) {
+            return false;
+        }
+
+        stmt = make<node::if_stmt>(ast::symbol::if_kind::case_, whens, maybe_else);
+        set_location(stmt, first, i);
+        first = i;
+        return true;
+    }
+
+    bool switch_stmt(iterator &first, node::switch_stmt &stmt)
+    {
+        auto i = first;
+        node::any_expr target;
+        if (!tok.keyword(i, "case") || !typed_expr(i, target) || !sep(i)) {
+            return false;
+        }
+
+        std::vector<node_type::switch_stmt::when_type> whens;
+        for (;;) {
+            auto j = i;
+            std::vector<node::any_expr> conds;
+            node::statement_block block;
+            if (!tok.keyword(j, "when")
+                    || !list(j, conds, &parser_impl::typed_expr_but_then)
+                    || !then_or_sep(j)
+                    || !case_when_stmt_block(j, block)) {
+                break;
+            }
+            whens.emplace_back(conds, block);
+            i = j;
+        }
+        if (whens.empty()) {
+            return false;
+        }
+
+        auto const maybe_else = else_stmt_block(i);
+        if (!tok.lit(i, "end")) {
+            return false;
+        }
+
+        stmt = make<node::switch_stmt>(target, whens, maybe_else);
+        set_location(stmt, first, i);
+        first = i;
+        return true;
+    }
+
+    bool for_stmt(iterator &first, node::for_stmt &stmt)
+    {
+        auto i = first;
+        if (!tok.keyword(i, "for")) {
+            return false;
+        }
+
+        auto const param_but_in
+            = [this](iterator &p, node::parameter &param)
+            {
+                return !tok.peek_keyword(p, "in") && parameter(p, param);
+            };
+
+        std::vector<node::parameter> params;
+        node::any_expr range;
+        if (!list(i, params, param_but_in) || !tok.keyword(i, "in") || !typed_expr(i, range) || !sep(i)) {
+            return false;
+        }
+
+        node::statement_block body;
+        stmt_block_before_end(i, body);
+        sep(i);
+        if (!tok.lit(i, "end")) {
+            return false;
+        }
+
+        stmt = make<node::for_stmt>(params, range, body);
+        set_location(stmt, first, i);
+        first = i;
+        return true;
+    }
+
+    bool while_stmt(iterator &first, node::while_stmt &stmt)
+    {
+        auto i = first;
+        node::any_expr cond;
+        if (!tok.keyword(i, "for") || !typed_expr(i, cond)) {
+            return false;
+        }
+
+        bool const do_ = tok.keyword(i, "do");
+        bool const separated = sep(i);
+        if (!do_ && !separated) {
+            return false;
+        }
+
+        node::statement_block body;
+        stmt_block_before_end(i, body);
+        sep(i);
+        if (!tok.lit(i, "end")) {
+            return false;
+        }
+
+        stmt = make<node::while_stmt>(cond, body);
+        set_location(stmt, first, i);
+        first = i;
+        return true;
+    }
+
+    bool postfix_if_return_stmt(iterator &first, node::return_stmt &stmt)
+    {
+        auto i = first;
+        if (!tok.keyword(i, "ret")) {
+            return false;
+        }
+
+        auto const expr_but_if
+            = [this](iterator &p, node::any_expr &e)
+            {
+                return !peek_if_kind(p) && typed_expr(p, e);
+            };
+
+        std::vector<node::any_expr> exprs;
+        if (!list(i, exprs, expr_but_if)) {
+            exprs.clear();
+        }
+
+        stmt = make<node::return_stmt>(exprs);
+        set_location(stmt, first, i);
+        first = i;
+        return true;
+    }
+
+    bool postfix_if_stmt(iterator &first, node::postfix_if_stmt &stmt)
+    {
+        auto i = first;
+        node_type::postfix_if_stmt::body_type body;
+        {
+            node::return_stmt ret;
+            node::assignment_stmt assign;
+            node::any_expr expr;
+            if (postfix_if_return_stmt(i, ret)) {
+                body = ret;
+            } else if (assignment_stmt(i, assign)) {
+                body = assign;
+            } else if (!peek_if_kind(i) && typed_expr(i, expr)) {
+                body = expr;
+            } else {
+                return false;
+            }
+        }
+
+        ast::symbol::if_kind kind;
+        node::any_expr cond;
+        if (!if_kind(i, kind) || !typed_expr(i, cond) || tok.peek_keyword(i, "then")) {
+            return false;
+        }
+
+        stmt = make<node::postfix_if_stmt>(body, kind, cond);
+        set_location(stmt, first, i);
+        first = i;
+        return true;
+    }
+
+    bool begin_stmt(iterator &first, node::statement_block &block)
+    {
+        auto i = first;
+        if (!tok.keyword(i, "begin")) {
+            return false;
+        }
+        tok.eol(i);
+        stmt_block_before_end(i, block);
+        sep(i);
+        if (!tok.keyword(i, "end")) {
+            return false;
+        }
+
+        set_location(block, first, i);
+        first = i;
+        return true;
+    }
+
+    template<class Node>
+    bool alternative(iterator &i, node::compound_stmt &stmt, bool (parser_impl::*rule)(iterator &, Node &))
+    {
+        Node n;
+        if (!(this->*rule)(i, n)) {
+            return false;
+        }
+        stmt = std::move(n);
+        return true;
+    }
+
+    bool compound_stmt(iterator &first, node::compound_stmt &stmt)
+    {
+        return memoized(
+                compound_stmt_memo,
+                first,
+                stmt,
+                [this](iterator &i, node::compound_stmt &s)
+                {
+                    return alternative(i, s, &parser_impl::if_stmt)
+                        || alternative(i, s, &parser_impl::case_stmt)
+                        || alternative(i, s, &parser_impl::switch_stmt)
+                        || alternative(i, s, &parser_impl::for_stmt)
+                        || alternative(i, s, &parser_impl::while_stmt)
+                        || alternative(i, s, &parser_impl::begin_stmt)
+                        || alternative(i, s, &parser_impl::initialize_stmt)
+                        || alternative(i, s, &parser_impl::postfix_if_stmt)
+                        || alternative(i, s, &parser_impl::return_stmt)
+                        || alternative(i, s, &parser_impl::assignment_stmt)
+                        || alternative(i, s, &parser_impl::typed_expr);
+                }
+            );
+    }
+
+    // }}}
+
+    // Definitions {{{
+
+    // ternary_operator | binary_operator | unary_operator | function_name
+    bool func_def_name(iterator &i, std::string &name) const
+    {
+        for (auto const op : {
+                    "[]=",
+                    ">>", "<<", "<=", ">=", "==", "!=", "&&", "||", "*", "/", "%", "+", "-", "<", ">", "&", "^", "|", "[]",
+                    "+", "-", "~", "!"
+                }) {
+            if (tok.lit(i, op)) {
+                name = op;
+                return true;
+            }
+        }
+        return tok.function_name(i, name);
+    }
+
+    // -(('(' >> -(-eol >> parameter % comma >> trailing_comma)) > ')')
+    std::vector<node::parameter> function_param_decls(iterator &first)
+    {
+        std::vector<node::parameter> params;
+        auto i = first;
+        if (!tok.lit(i, '(')) {
+            return params;
+        }
+
+        {
+            auto j = i;
+            tok.eol(j);
+            std::vector<node::parameter> ps;
+            if (list(j, ps, &parser_impl::parameter)) {
+                params = std::move(ps);
+                trailing_comma(j);
+                i = j;
+            }
+        }
+
+        expect_lit(i, ")");
+        first = i;
+        return params;
+    }
+
+    bool function_definition(iterator &first, node::function_definition &def)
+    {
+        auto i = first;
+        ast::symbol::func_kind kind;
+        if (!func_kind(i, kind)) {
+            return false;
+        }
+
+        std::string name;
+        if (!func_def_name(i, name)) {
+            throw expectation_failure{i, "<name of function definition>"};
+        }
+
+        auto const params = function_param_decls(i);
+
+        boost::optional<node::any_type> ret = boost::none;
+        {
+            auto j = i;
+            if (tok.lit(j, ':')) {
+                tok.eol(j);
+                ret = expect_qualified_type(j);
+                i = j;
+            }
+        }
+
+        expect_sep(i);
+        node::statement_block body;
+        func_body_stmt_block(i, body);
+        sep(i);
+
+        boost::optional<node::statement_block> ensure = boost::none;
+        {
+            auto j = i;
+            if (tok.lit(j, "ensure")) {
+                expect_sep(j);
+                node::statement_block block;
+                stmt_block_before_end(j, block);
+                sep(j);
+                ensure = block;
+                i = j;
+            }
+        }
+
+        expect_lit(i, "end");
+
+        def = make<node::function_definition>(kind, name, params, ret, body, ensure);
+        set_location(def, first, i);
+        first = i;
+        return true;
+    }
+
+    bool constant_decl(iterator &first, node::variable_decl &decl)
+    {
+        auto i = first;
+        std::string name;
+        if (!tok.variable_name(i, name)) {
+            return false;
+        }
+
+        boost::optional<node::any_type> type = boost::none;
+        {
+            auto j = i;
+            if (tok.lit(j, ':')) {
+                tok.eol(j);
+                node::any_type t;
+                if (qualified_type(j, t)) {
+                    type = t;
+                    i = j;
+                }
+            }
+        }
+
+        decl = make<node::variable_decl>(false, name, type);
+        set_location(decl, first, i);
+        first = i;
+        return true;
+    }
+
+    bool constant_definition(iterator &first, node::initialize_stmt &def)
+    {
+        auto i = first;
+        std::vector<node::variable_decl> decls;
+        std::vector<node::any_expr> rhs;
+        if (!list(i, decls, &parser_impl::constant_decl)) {
+            return false;
+        }
+        trailing_comma(i);
+        if (!tok.lit(i, ":=")) {
+            return false;
+        }
+        tok.eol(i);
+        if (!list(i, rhs, &parser_impl::typed_expr)) {
+            return false;
+        }
+
+        def = make<node::initialize_stmt>(decls, rhs);
+        set_location(def, first, i);
+        first = i;
+        return true;
+    }
+
+    // eps >> -('+' | '-')
+    bool access_specifier(iterator &i) const
+    {
+        tok.skip(i);
+        if (tok.lit(i, '+')) {
+            return true;
+        }
+        if (tok.lit(i, '-')) {
+            return false;
+        }
+        return true;
+    }
+
+    bool instance_variable_decl(iterator &first, node::variable_decl &decl, bool const is_public)
+    {
+        auto i = first;
+        std::string name;
+        if (!tok.variable_name(i, name)) {
+            return false;
+        }
+
+        boost::optional<node::any_type> type = boost::none;
+        {
+            auto j = i;
+            tok.eol(j);
+            if (tok.lit(j, ':')) {
+                tok.eol(j);
+                type = expect_qualified_type(j);
+                i = j;
+            }
+        }
+
+        decl = make<node::variable_decl>(true, name, type, is_public);
+        set_location(decl, first, i);
+        first = i;
+        return true;
+    }
+
+    bool newline_and_comma(iterator &first) const
+    {
+        auto i = first;
+        tok.eol(i);
+        if (!tok.lit(i, ',')) {
+            return false;
+        }
+        first = i;
+        return true;
+    }
+
+    bool instance_variable_decls(iterator &first, std::vector<node::variable_decl> &decls)
+    {
+        auto i = first;
+        bool const is_public = access_specifier(i);
+        auto const decl
+            = [is_public, this](iterator &p, node::variable_decl &d)
+            {
+                return instance_variable_decl(p, d, is_public);
+            };
+
+        if (!list(i, decls, decl, &parser_impl::newline_and_comma)) {
+            return false;
+        }
+        first = i;
+        return true;
+    }
+
+    bool method_definition(iterator &first, node::function_definition &def)
+    {
+        auto i = first;
+        bool const is_public = access_specifier(i);
+        if (!function_definition(i, def)) {
+            return false;
+        }
+
+        def->accessibility = is_public;
+        set_location(def, first, i);
+        first = i;
+        return true;
+    }
+
+    bool constructor(iterator &first, node::function_definition &def)
+    {
+        auto i = first;
+        if (!tok.keyword(i, "init")) {
+            return false;
+        }
+
+        auto const params = function_param_decls(i);
+        expect_sep(i);
+        node::statement_block body;
+        stmt_block_before_end(i, body);
+        sep(i);
+        expect_lit(i, "end");
+
+        def = make<node::function_definition>(node_type::function_definition::ctor_tag{}, params, body);
+        set_location(def, first, i);
+        first = i;
+        return true;
+    }
+
+    bool copier(iterator &first, node::function_definition &def)
+    {
+        auto i = first;
+        if (!tok.keyword(i, "copy")) {
+            return false;
+        }
+
+        expect_sep(i);
+        node::statement_block body;
+        func_body_stmt_block(i, body);
+        sep(i);
+        expect_lit(i, "end");
+
+        def = make<node::function_definition>(node_type::function_definition::copier_tag{}, body);
+        set_location(def, first, i);
+        first = i;
+        return true;
+    }
+
+    bool converter(iterator &first, node::function_definition &def)
+    {
+        auto i = first;
+        if (!tok.keyword(i, "cast")) {
+            return false;
+        }
+
+        auto const params = function_param_decls(i);
+        if (!tok.lit(i, ':')) {
+            throw expectation_failure{i, "\":\""};
+        }
+        tok.eol(i);
+        auto const type = expect_qualified_type(i);
+        expect_sep(i);
+        node::statement_block body;
+        func_body_stmt_block(i, body);
+        sep(i);
+        expect_lit(i, "end");
+
+        def = make<node::function_definition>(node_type::function_definition::converter_tag{}, params, type, body);
+        set_location(def, first, i);
+        first = i;
+        return true;
+    }
+
+    bool class_definition(iterator &first, node::class_definition &def)
+    {
+        auto i = first;
+        if (!tok.keyword(i, "class")) {
+            return false;
+        }
+
+        std::string name;
+        if (!tok.class_name(i, name)) {
+            throw expectation_failure{i, "<name of class>"};
+        }
+
+        std::vector<node::variable_decl> instance_vars;
+        std::vector<node::function_definition> member_funcs;
+        for (;;) {
+            auto j = i;
+            if (!sep(j)) {
+                break;
+            }
+
+            node::function_definition f;
+            std::vector<node::variable_decl> vars;
+            if (method_definition(j, f) || constructor(j, f) || copier(j, f) || converter(j, f)) {
+                member_funcs.push_back(f);
+            } else if (!tok.peek_lit(j, "end") && instance_variable_decls(j, vars)) {
+                instance_vars.insert(std::end(instance_vars), std::begin(vars), std::end(vars));
+            } else {
+                break;
+            }
+            i = j;
+        }
+
+        expect_sep(i);
+        expect_lit(i, "end");
+
+        def = make<node::class_definition>(name, instance_vars, member_funcs);
+        set_location(def, first, i);
+        first = i;
+        return true;
+    }
+
+    bool import(iterator &first, node::import &imp)
+    {
+        auto i = first;
+        if (!tok.keyword(i, "import")) {
+            return false;
+        }
+
+        std::string path;
+        if (!tok.import_path(i, path)) {
+            throw expectation_failure{i, "<list>"};
+        }
+
+        imp = make<node::import>(path);
+        set_location(imp, first, i);
+        first = i;
+        return true;
+    }
+
+    // }}}
+
+    node::inu inu(iterator &first)
+    {
+        auto i = first;
+        std::vector<node::function_definition> functions;
+        std::vector<node::initialize_stmt> constants;
+        std::vector<node::class_definition> classes;
+        std::vector<node::import> imports;
+
+        auto const toplevel_item
+            = [&](iterator &p)
+            {
+                node::function_definition f;
+                node::initialize_stmt c;
+                node::class_definition k;
+                node::import m;
+                if (converter(p, f) || function_definition(p, f)) {
+                    functions.push_back(f);
+                } else if (constant_definition(p, c)) {
+                    constants.push_back(c);
+                } else if (class_definition(p, k)) {
+                    classes.push_back(k);
+                } else if (import(p, m)) {
+                    imports.push_back(m);
+                } else {
+                    return false;
+                }
+                return true;
+            };
+
+        sep(i);
+        if (toplevel_item(i)) {
+            for (auto save = i;; save = i) {
+                if (!sep(i) || !toplevel_item(i)) {
+                    i = save;
+                    break;
+                }
+            }
+        }
+        sep(i);
+
+        if (!tok.eol(i) && !tok.eoi(i)) {
+            throw expectation_failure{i, "<alternative><eol><eoi>"};
+        }
+
+        auto const program = make<node::inu>(functions, constants, classes, imports);
+        set_location(program, first, i);
+        first = i;
+        return program;
+    }
+
+    void report(expectation_failure const& failure) const
+    {
+        helper::colorizer c;
+        auto const begin = tok.begin();
+        auto const end = tok.end();
+        auto const err = failure.where;
+        auto const pos = ast::source_files::line_col_in(begin, static_cast<std::size_t>(err - begin));
+        auto const is_newline = [](char const ch){ return ch == '\r' || ch == '\n'; };
+        auto const line_start
+            = std::find_if(
+                    std::reverse_iterator<iterator>{err},
+                    std::reverse_iterator<iterator>{begin},
+                    is_newline
+                ).base();
+
+        diagnostics << c.red("Error") + " in "
+                  << (boost::format("line:%1%, col:%2%") % pos.first % pos.second).str() << '\n'
+                  << c.bold("Expected ", false) << failure.what << c.reset()
+                  << "\n\n"
+                  << std::string{line_start, std::find_if(err, end, is_newline)} << '\n'
+                  << std::string(pos.second - 1, ' ') << c.green("^ here")
+                  << '\n' << std::endl;
+    }
+
+    node::inu parse(bool const check_only)
+    {
+        auto i = tok.begin();
+        node::inu root = nullptr;
+
+        try {
+            root = inu(i);
+            tok.skip(i);
+        }
+        catch (expectation_failure const& failure) {
+            report(failure);
+        }
+
+        // Note:
+        // As the Spirit front end, the error is reported at the beginning of the
+        // code.  The position where parsing failed was already reported above.
+        if (!root || i != tok.end()) {
+            auto const pos = ast::source_files::line_col_in(tok.begin(), 0u);
+            throw parse_error{pos.first, pos.second};
+        }
+
+        if (!check_only) {
+            found.install(root);
+        }
+
+        return root;
+    }
+};
+
+constexpr parser_impl::binary_level const parser_impl::binary_levels[];
+
+} // namespace detail
+
+ast::node::inu parse(
+        char const* const first,
+        char const* const last,
+        ast::file_id_type const file,
+        std::shared_ptr<ast::node_arena> const& arena,
+        bool const check_only,
+        std::ostream &diagnostics)
+{
+    return detail::parser_impl{first, last, file, arena, diagnostics}.parse(check_only);
+}
+
+} // namespace hand_written
+} // namespace syntax
+} // namespace dachs
@@ -0,0 +1,40 @@
+#if !defined DACHS_PARSER_HAND_WRITTEN_PARSER_HPP_INCLUDED
+#define      DACHS_PARSER_HAND_WRITTEN_PARSER_HPP_INCLUDED
+
+#include <string>
+#include <memory>
+#include <iostream>
+
+#include "dachs/ast/ast_fwd.hpp"
+#include "dachs/ast/node_arena.hpp"
+
+namespace dachs {
+namespace syntax {
+namespace hand_written {
+
+// Note:
+// Recursive descent parser written by hand.  It accepts the same language as the
+// Spirit grammar in parser.cpp and builds the same AST (including source locations),
+// but runs much faster because it doesn't go through the layers of Spirit's
+// parser combinators.  Rules are memoized at the positions where the grammar
+// backtracks heavily (statements and expressions).
+//
+// The code in [first, last) is parsed in place without copying it.
+//
+// When the code has a syntax error, the error is reported to 'diagnostics' and
+// parse_error is thrown.  Nodes are allocated from 'arena' unless it is null.
+// When 'check_only' is true, modules are not imported implicitly.
+ast::node::inu parse(
+        char const* const first,
+        char const* const last,
+        ast::file_id_type const file,
+        std::shared_ptr<ast::node_arena> const& arena,
+        bool const check_only,
+        std::ostream &diagnostics = std::cerr
+    );
+
+} // namespace hand_written
+} // namespace syntax
+} // namespace dachs
+
+#endif    // DACHS_PARSER_HAND_WRITTEN_PARSER_HPP_INCLUDED
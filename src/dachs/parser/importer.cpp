@@ -1,6 +1,7 @@
 #include <iostream>
 #include <string>
 #include <set>
+#include <map>
 
 #include <boost/format.hpp>
 #include <boost/optional.hpp>
@@ -11,9 +12,12 @@
 #include "dachs/ast/ast.hpp"
 #include "dachs/parser/importer.hpp"
 #include "dachs/parser/parser.hpp"
+#include "dachs/parser/module_cache.hpp"
+#include "dachs/parser/module_pool.hpp"
 #include "dachs/exception.hpp"
 #include "dachs/helper/colorizer.hpp"
 #include "dachs/helper/util.hpp"
+#include "dachs/helper/source_buffer.hpp"
 
 namespace dachs {
 namespace syntax {
@@ -24,15 +28,21 @@ namespace algo = boost::algorithm;
 
 using boost::adaptors::transformed;
 
-class importer_impl final {
+fs::path absolute_source_path(fs::path const& source)
+{
+    return source.has_root_directory() ? source : fs::current_path() / source;
+}
 
-    using maybe_path = boost::optional<fs::path>;
+class importer_impl final {
 
     dirs_type const& import_dirs;
     parser file_parser;
+    module_cache cache;
+    module_pool *const pool;
     helper::colorizer c;
     fs::path source_file;
     std::set<fs::path> &already_imported;
+    std::map<std::string, fs::path> &resolved_imports;
 
     template<class Node, class Message>
     [[noreturn]]
@@ -85,45 +95,13 @@ class importer_impl final {
 
     fs::path find_path(ast::node::import const& node)
     {
-        fs::path const specified_path
-            = algo::replace_all_copy(node->path, ".", "/") + ".dcs";
-
-        auto const search
-            = [&specified_path, this](auto const& name) -> maybe_path
-            {
-                auto p = fs::path{name} / specified_path;
-                if (!fs::exists(p)) {
-                    p = source_file.parent_path() / p;
-                }
-
-                if (fs::is_directory(p)) {
-                    return boost::none; // Note: Give up
-                }
-
-                if (fs::exists(p)) {
-                    return p;
-                } else {
-                    return boost::none;
-                }
-            };
-
-        // Note: Check system library
-        if (auto const found = search(DACHS_INSTALL_PREFIX "/lib/dachs")) {
+        if (auto const found = find_import_path(node->path, import_dirs, source_file)) {
+            resolved_imports[node->path] = *found;
             return *found;
         }
 
-        // Note: Check specified dir
-        for (auto const& d : import_dirs
-                | transformed([](auto const& d){ return fs::path{d}; })) {
-            if (auto const found = search(d)) {
-                return *found;
-            }
-        }
-
-        // Note: Check source's dir
-        if (auto const found = search(source_file.parent_path())) {
-            return *found;
-        }
+        fs::path const specified_path
+            = algo::replace_all_copy(node->path, ".", "/") + ".dcs";
 
         std::string notes =
                 "  Note: Import directories are below\n"
@@ -136,12 +114,62 @@ class importer_impl final {
         error(node, "  File \"" + specified_path.string() + "\" is not found in any import paths\n" + notes);
     }
 
-    ast::node::inu parse(ast::node::import const& i, fs::path const& p, std::string const& code, fs::path const& f)
+    ast::node::inu parse_source(std::shared_ptr<helper::source_buffer const> const& code, fs::path const& p, boost::optional<module_cache::entry> const& cache_entry)
+    {
+        auto ast = file_parser.parse(code, p.c_str());
+
+        // Note:
+        // Store the AST before its imports are merged into it.
+        // Imported modules are cached separately.
+        if (cache_entry) {
+            cache_entry->store(ast.root);
+        }
+
+        if (pool) {
+            pool->add(p, ast.root, code->identity());
+        }
+
+        return ast.root;
+    }
+
+    ast::node::inu parse(ast::node::import const& i, fs::path const& p, fs::path const& f)
     {
+        boost::optional<ast::node::inu> cached = boost::none;
+        boost::optional<module_cache::entry> cache_entry = boost::none;
+
+        if (pool) {
+            cached = pool->find(p);
+        }
+
+        if (!cached) {
+            // Note:
+            // Capture the identity before the cache entry is validated.  If the file is
+            // modified after that, the pool sees the new identity and parses it again.
+            auto const identity = helper::source_buffer::file_identity::of(p.string());
+            cache_entry = cache.find(p);
+            if (cache_entry) {
+                cached = cache_entry->load();
+                if (cached && pool) {
+                    pool->add(p, *cached, identity);
+                }
+            }
+        }
+
+        std::shared_ptr<helper::source_buffer const> source = nullptr;
+        if (!cached) {
+            // Note:
+            // Imported modules are kept by the module pool across compilations (e.g. by the
+            // compile server) and the file may be modified meanwhile.  Don't map it.
+            source = helper::source_buffer::read(p.string());
+            if (!source) {
+                error(i, boost::format("  Can't open file %1%") % p);
+            }
+        }
+
         try {
-            auto ast = file_parser.parse(code, p.c_str());
-            this->import(ast.root, p);
-            return ast.root;
+            auto const root = cached ? *cached : parse_source(source, p, cache_entry);
+            this->import(root, p);
+            return root;
         } catch(parse_error const& err) {
             report(i, boost::format(
                         "  Error occurred while parsing imported file %1%\n"
@@ -153,13 +181,9 @@ class importer_impl final {
 
 public:
 
-    importer_impl(dirs_type const& dirs, fs::path const& source, std::set<fs::path> &already)
-        : import_dirs(dirs), file_parser(), source_file(source), already_imported(already)
-    {
-        if (!source_file.has_root_directory()) {
-            source_file = fs::current_path() / source_file;
-        }
-    }
+    importer_impl(dirs_type const& dirs, fs::path const& source, std::set<fs::path> &already, std::map<std::string, fs::path> &resolved, module_pool *const shared, front_end const f)
+        : import_dirs(dirs), file_parser(node_allocation::arena, f), cache(), pool(shared), source_file(absolute_source_path(source)), already_imported(already), resolved_imports(resolved)
+    {}
 
     ast::node::inu const& import(ast::node::inu const& program)
     {
@@ -176,12 +200,7 @@ public:
                 continue;
             }
 
-            auto const source = helper::read_file(p.c_str());
-            if (!source) {
-                error(i, boost::format("  Can't open file %1%") % p);
-            }
-
-            merge(program, parse(i, p, *source, file));
+            merge(program, parse(i, p, file));
         }
 
         return program;
@@ -190,9 +209,51 @@ public:
 
 } // namespace detail
 
+boost::optional<fs::path> find_import_path(std::string const& module, dirs_type const& import_dirs, fs::path const& source)
+{
+    auto const source_dir = detail::absolute_source_path(source).parent_path();
+    fs::path const specified_path
+        = detail::algo::replace_all_copy(module, ".", "/") + ".dcs";
+
+    auto const search
+        = [&specified_path, &source_dir](auto const& name) -> boost::optional<fs::path>
+        {
+            auto p = fs::path{name} / specified_path;
+            if (!fs::exists(p)) {
+                p = source_dir / p;
+            }
+
+            if (fs::is_directory(p)) {
+                return boost::none; // Note: Give up
+            }
+
+            if (fs::exists(p)) {
+                return p;
+            } else {
+                return boost::none;
+            }
+        };
+
+    // Note: Check system library
+    if (auto const found = search(DACHS_INSTALL_PREFIX "/lib/dachs")) {
+        return *found;
+    }
+
+    // Note: Check specified dir
+    for (auto const& d : import_dirs
+            | detail::transformed([](auto const& d){ return fs::path{d}; })) {
+        if (auto const found = search(d)) {
+            return *found;
+        }
+    }
+
+    // Note: Check source's dir
+    return search(source_dir);
+}
+
 ast::node::inu const& importer::import(ast::node::inu const& prog)
 {
-    detail::importer_impl impl{import_dirs, source, already_imported};
+    detail::importer_impl impl{import_dirs, source, already_imported, resolved_imports, shared_modules, syntax_front_end};
     return impl.import(prog);
 }
 
@@ -2,12 +2,15 @@
 #define      DACHS_PARSER_IMPORTER_HPP_INCLUDED
 
 #include <set>
+#include <map>
 #include <vector>
 #include <string>
 
+#include <boost/optional.hpp>
 #include <boost/filesystem/path.hpp>
 
 #include "dachs/ast/ast_fwd.hpp"
+#include "dachs/parser/parser.hpp"
 
 namespace dachs {
 namespace syntax {
@@ -16,14 +19,39 @@ namespace fs = boost::filesystem;
 
 using dirs_type = std::vector<std::string>;
 
+class module_pool;
+
+// Note:
+// Find the file of the imported module (e.g. "std.string") in the system library,
+// the import directories and the directory of the source file, in this order.
+// 'source' is the file which the compilation started from.  Returns boost::none
+// when the file is not found.
+boost::optional<fs::path> find_import_path(std::string const& module, dirs_type const& import_dirs, fs::path const& source);
+
 struct importer {
     dirs_type const& import_dirs;
     fs::path source;
     std::set<fs::path> already_imported;
 
+    // Note:
+    // The file found for each imported module.  Incremental compilation checks
+    // that the modules are still resolved to the same files.
+    std::map<std::string, fs::path> resolved_imports;
+
+    module_pool *const shared_modules;
+    front_end const syntax_front_end;
+
+    template<class Source>
+    importer(dirs_type const& is, Source const& s, front_end const f = front_end::spirit)
+        : import_dirs(is), source(s), already_imported(), resolved_imports(), shared_modules(nullptr), syntax_front_end(f)
+    {}
+
+    // Note:
+    // Imported modules are looked up from and added to the pool.
+    // The pool must outlive this importer.
     template<class Source>
-    importer(dirs_type const& is, Source const& s)
-        : import_dirs(is), source(s), already_imported()
+    importer(dirs_type const& is, Source const& s, module_pool &pool, front_end const f = front_end::spirit)
+        : import_dirs(is), source(s), already_imported(), resolved_imports(), shared_modules(&pool), syntax_front_end(f)
     {}
 
     ast::node::inu const& import(ast::node::inu const&);
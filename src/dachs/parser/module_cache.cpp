@@ -0,0 +1,142 @@
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <functional>
+#include <memory>
+#include <cstdlib>
+#include <cstdint>
+
+#include <boost/filesystem.hpp>
+#include <boost/system/error_code.hpp>
+
+#include "dachs/ast/ast.hpp"
+#include "dachs/ast/ast_serializer.hpp"
+#include "dachs/parser/module_cache.hpp"
+
+namespace dachs {
+namespace syntax {
+
+namespace detail {
+
+boost::optional<fs::path> default_cache_dir()
+{
+    if (auto const dir = std::getenv("DACHS_CACHE_DIR")) {
+        if (*dir == '\0') {
+            return boost::none;
+        }
+        return fs::path{dir};
+    }
+
+    if (auto const xdg = std::getenv("XDG_CACHE_HOME")) {
+        if (*xdg != '\0') {
+            return fs::path{xdg} / "dachs" / "modules";
+        }
+    }
+
+    if (auto const home = std::getenv("HOME")) {
+        if (*home != '\0') {
+            return fs::path{home} / ".cache" / "dachs" / "modules";
+        }
+    }
+
+    return boost::none;
+}
+
+} // namespace detail
+
+boost::optional<fs::path> module_cache::default_dir = detail::default_cache_dir();
+
+boost::optional<module_cache::entry> module_cache::find(fs::path const& source) const
+{
+    if (!cache_dir) {
+        return boost::none;
+    }
+
+    boost::system::error_code err;
+
+    auto const canonical = fs::canonical(source, err);
+    if (err) {
+        return boost::none;
+    }
+
+    auto const mtime = fs::last_write_time(canonical, err);
+    if (err) {
+        return boost::none;
+    }
+
+    auto const size = fs::file_size(canonical, err);
+    if (err) {
+        return boost::none;
+    }
+
+    // Note:
+    // The header is compared with the one in the cache file as a whole.
+    // It also detects the collision of hashed file names.
+    std::string header
+        = "DACHS-MODULE-CACHE\n"
+        + canonical.string() + '\n'
+        + std::to_string(static_cast<std::int64_t>(mtime)) + '\n'
+        + std::to_string(static_cast<std::uintmax_t>(size)) + '\n';
+
+    auto const file_name = std::to_string(std::hash<std::string>{}(canonical.string())) + ".ast";
+
+    return entry{source, *cache_dir / file_name, header};
+}
+
+boost::optional<ast::node::inu> module_cache::entry::load() const
+{
+    std::ifstream input{cache_file.string(), std::ios::in | std::ios::binary};
+    if (!input.is_open()) {
+        return boost::none;
+    }
+
+    std::string const data{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+    if (data.compare(0, header.size(), header) != 0) {
+        return boost::none;
+    }
+
+    // Note:
+    // The code of the source is not read here.  It is read only when a line or
+    // a column in it is needed.
+    return ast::deserialize_ast(
+            data.substr(header.size()),
+            ast::source_files::add(fs::absolute(source))
+        );
+}
+
+void module_cache::entry::store(ast::node::inu const& root) const
+{
+    boost::system::error_code err;
+
+    fs::create_directories(cache_file.parent_path(), err);
+    if (err) {
+        return;
+    }
+
+    // Note:
+    // Write to a temporary file and rename it to the entry.  Renaming is atomic,
+    // so concurrent compilations never read a half-written entry.
+    auto const tmp_file = cache_file.parent_path() / fs::unique_path("%%%%-%%%%-%%%%-%%%%.tmp");
+
+    {
+        std::ofstream output{tmp_file.string(), std::ios::out | std::ios::binary | std::ios::trunc};
+        if (!output.is_open()) {
+            return;
+        }
+
+        output << header << ast::serialize_ast(root);
+        if (!output) {
+            output.close();
+            fs::remove(tmp_file, err);
+            return;
+        }
+    }
+
+    fs::rename(tmp_file, cache_file, err);
+    if (err) {
+        fs::remove(tmp_file, err);
+    }
+}
+
+} // namespace syntax
+} // namespace dachs
@@ -0,0 +1,73 @@
+#if !defined DACHS_PARSER_MODULE_CACHE_HPP_INCLUDED
+#define      DACHS_PARSER_MODULE_CACHE_HPP_INCLUDED
+
+#include <string>
+
+#include <boost/optional.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include "dachs/ast/ast_fwd.hpp"
+
+namespace dachs {
+namespace syntax {
+
+namespace fs = boost::filesystem;
+
+// Note:
+// On-disk cache of parsed imported modules.
+// Each entry holds the serialized AST of one source file and is keyed by
+// the path, the modification time and the size of the source file.
+// The directory is $DACHS_CACHE_DIR, $XDG_CACHE_HOME/dachs/modules or
+// $HOME/.cache/dachs/modules in this order.  Setting empty DACHS_CACHE_DIR
+// or --no-module-cache disables the cache.
+// All failures on reading or writing the cache are ignored and the module
+// is simply parsed again.
+class module_cache final {
+    boost::optional<fs::path> cache_dir;
+
+public:
+
+    class entry final {
+        fs::path source;
+        fs::path cache_file;
+        std::string header;
+
+    public:
+
+        entry(fs::path const& source, fs::path const& cache_file, std::string const& header)
+            : source(source), cache_file(cache_file), header(header)
+        {}
+
+        boost::optional<ast::node::inu> load() const;
+        void store(ast::node::inu const& root) const;
+    };
+
+    // Note:
+    // The directory of default-constructed caches.  It is initialized from the
+    // environment variables above.  Set boost::none to disable the cache.
+    // It must be set before importing starts (e.g. at the beginning of main()).
+    static boost::optional<fs::path> default_dir;
+
+    module_cache()
+        : cache_dir(default_dir)
+    {}
+
+    explicit module_cache(boost::optional<fs::path> const& dir)
+        : cache_dir(dir)
+    {}
+
+    bool enabled() const noexcept
+    {
+        return bool{cache_dir};
+    }
+
+    // Note:
+    // Should be called before reading the source file.  Otherwise the file
+    // may be modified after reading and the stale AST would be stored.
+    boost::optional<entry> find(fs::path const& source) const;
+};
+
+} // namespace syntax
+} // namespace dachs
+
+#endif    // DACHS_PARSER_MODULE_CACHE_HPP_INCLUDED
@@ -0,0 +1,77 @@
+#include <string>
+#include <utility>
+
+#include <boost/filesystem.hpp>
+#include <boost/system/error_code.hpp>
+
+#include "dachs/ast/ast.hpp"
+#include "dachs/ast/ast_copier.hpp"
+#include "dachs/parser/module_pool.hpp"
+
+namespace dachs {
+namespace syntax {
+
+namespace detail {
+
+boost::optional<std::string> canonical_path_of(fs::path const& source)
+{
+    boost::system::error_code err;
+
+    auto const canonical = fs::canonical(source, err);
+    if (err) {
+        return boost::none;
+    }
+
+    return canonical.string();
+}
+
+} // namespace detail
+
+boost::optional<ast::node::inu> module_pool::find(fs::path const& source) const
+{
+    auto const path = detail::canonical_path_of(source);
+    if (!path) {
+        return boost::none;
+    }
+
+    auto const identity = identity_type::of(*path);
+    if (!identity.valid) {
+        return boost::none;
+    }
+
+    ast::node::inu found = nullptr;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto const module = modules.find(*path);
+        if (module == std::end(modules) || !(module->second.identity == identity)) {
+            return boost::none;
+        }
+
+        found = module->second.root;
+    }
+
+    // Note:
+    // Copy outside the lock.  ASTs in the pool are immutable.
+    return ast::copy_ast(found);
+}
+
+void module_pool::add(fs::path const& source, ast::node::inu const& parsed, identity_type const& identity)
+{
+    if (!identity.valid) {
+        return;
+    }
+
+    auto const path = detail::canonical_path_of(source);
+    if (!path) {
+        return;
+    }
+
+    auto copied = ast::copy_ast(parsed);
+
+    std::lock_guard<std::mutex> lock{mutex};
+    modules[*path] = module_type{std::move(copied), identity};
+}
+
+} // namespace syntax
+} // namespace dachs
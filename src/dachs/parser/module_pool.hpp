@@ -0,0 +1,60 @@
+#if !defined DACHS_PARSER_MODULE_POOL_HPP_INCLUDED
+#define      DACHS_PARSER_MODULE_POOL_HPP_INCLUDED
+
+#include <string>
+#include <unordered_map>
+#include <mutex>
+
+#include <boost/optional.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include "dachs/ast/ast_fwd.hpp"
+#include "dachs/helper/source_buffer.hpp"
+
+namespace dachs {
+namespace syntax {
+
+namespace fs = boost::filesystem;
+
+// Note:
+// Parsed imported modules shared by all importers in one compiler run.
+// Modules are held by their canonical paths with the identities (device, inode,
+// size and nanosecond mtime) of their source files.  ASTs in the pool are never
+// modified.  Because importing merges an imported AST into the program and
+// semantic analysis decorates it, an importer always receives a deep copy.
+// This class is thread-safe.
+class module_pool final {
+    using identity_type = helper::source_buffer::file_identity;
+
+    struct module_type {
+        ast::node::inu root;
+        identity_type identity;
+    };
+
+    std::unordered_map<std::string, module_type> modules;
+    mutable std::mutex mutex;
+
+public:
+
+    module_pool() = default;
+    module_pool(module_pool const&) = delete;
+    module_pool &operator=(module_pool const&) = delete;
+
+    // Note:
+    // Return the copy of the module.  When the identity of the source file differs
+    // from the one passed to add(), the module is treated as not found.
+    boost::optional<ast::node::inu> find(fs::path const& source) const;
+
+    // Note:
+    // Add the copy of the parsed module.  The passed AST may be modified by
+    // the caller after this call.
+    // 'identity' must be captured before the source is read.  Otherwise a file
+    // modified after reading would be stored with the new identity and the stale
+    // module would be found.  Nothing is added when 'identity' is invalid.
+    void add(fs::path const& source, ast::node::inu const& parsed, identity_type const& identity);
+};
+
+} // namespace syntax
+} // namespace dachs
+
+#endif    // DACHS_PARSER_MODULE_POOL_HPP_INCLUDED
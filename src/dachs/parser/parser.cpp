@@ -7,6 +7,7 @@
 #include <exception>
 #include <vector>
 #include <algorithm>
+#include <iterator>
 #include <utility>
 #include <type_traits>
 #include <cstddef>
@@ -15,7 +16,6 @@
 #include <boost/range/iterator_range.hpp>
 #include <boost/spirit/include/qi.hpp>
 #include <boost/spirit/include/qi_as.hpp>
-#include <boost/spirit/include/support_line_pos_iterator.hpp>
 #include <boost/spirit/include/phoenix_core.hpp>
 #include <boost/spirit/include/phoenix_object.hpp>
 #include <boost/spirit/include/phoenix_operator.hpp>
@@ -25,7 +25,10 @@
 #include <boost/filesystem.hpp>
 
 #include "dachs/ast/ast.hpp"
+#include "dachs/ast/node_arena.hpp"
 #include "dachs/parser/parser.hpp"
+#include "dachs/parser/tokenizer.hpp"
+#include "dachs/parser/hand_written_parser.hpp"
 #include "dachs/parser/comment_skipper.hpp"
 #include "dachs/parser/implicit_import.hpp"
 #include "dachs/exception.hpp"
@@ -66,23 +69,21 @@ namespace detail {
 
     using helper::variant::apply_lambda;
 
-    template<class Iterator>
-    inline auto line_pos_iterator(Iterator i)
-    {
-        return boost::spirit::line_pos_iterator<Iterator>{i};
-    }
-
     template<class Node, bool DoNotAllocate>
     struct make_shared {
+        std::shared_ptr<ast::node_arena> const& arena;
+
         template<class... Args>
         std::shared_ptr<Node> operator()(Args &&... args) const
         {
-            return std::make_shared<Node>(std::forward<Args>(args)...);
+            return ast::make_in<std::shared_ptr<Node>>(arena, std::forward<Args>(args)...);
         }
     };
 
     template<class Node>
     struct make_shared<Node, true> {
+        std::shared_ptr<ast::node_arena> const& arena;
+
         template<class... Args>
         std::shared_ptr<Node> operator()(Args &&...) const
         {
@@ -101,30 +102,41 @@ namespace detail {
         detail::set_position_getter_on_success(getter, tail...);
     }
 
+    // Note:
+    // Only the offset is recorded.  Line and column are resolved lazily with the
+    // line table of the file.
     template<class T, class Iter>
-    void set_location_impl(std::shared_ptr<T> const& node, Iter const before, Iter const after, Iter const code_begin, ast::path_type const& file_path)
+    void set_location_impl(std::shared_ptr<T> const& node, Iter const before, Iter const after, Iter const code_begin, ast::file_id_type const file)
     {
-        auto const d = std::distance(before.base(), after.base());
-        node->location.line = spirit::get_line(before);
-        node->location.col = spirit::get_column(code_begin, before);
-        node->location.length = d < 0 ? 0 : d;
-        node->location.path = file_path;
+        auto const d = std::distance(before, after);
+        node->location.file = file;
+        node->location.offset = static_cast<std::uint32_t>(std::distance(code_begin, before));
+        node->location.length = d < 0 ? 0u : static_cast<std::uint32_t>(d);
     }
 
+    // Note:
+    // State which varies in each parse.  The grammar is built once and reused
+    // for many parses.  So it must not be baked into the rules at construction.
+    template<class CodeIter>
+    struct parse_state {
+        CodeIter code_begin;
+        ast::file_id_type file = ast::source_files::no_file;
+        std::shared_ptr<ast::node_arena> arena; // Note: Null when nodes are allocated on heap
+        std::ostream *diagnostics = &std::cerr;
+    };
+
     template<class CodeIter>
     struct position_getter {
-        CodeIter const code_begin;
-        ast::path_type const& file_path;
+        parse_state<CodeIter> const& state;
 
-        explicit position_getter(CodeIter const begin, ast::path_type const& p) noexcept
-            : code_begin{begin}
-            , file_path(p)
+        explicit position_getter(parse_state<CodeIter> const& s) noexcept
+            : state(s)
         {}
 
         template<class T, class Iter>
         void operator()(std::shared_ptr<T> const& node_ptr, Iter const before, Iter const after) const noexcept
         {
-            set_location_impl(node_ptr, before, after, code_begin, file_path);
+            set_location_impl(node_ptr, before, after, state.code_begin, state.file);
         }
 
         template<class Iter, class... Args>
@@ -177,13 +189,6 @@ inline auto operator"" _p(char const* s, std::size_t)
 
 // }}}
 
-template<class FloatType>
-struct strict_real_policies_disallowing_trailing_dot final
-    : qi::strict_real_policies<FloatType> {
-    static bool const allow_trailing_dot = false;
-    // static bool const allow_leading_dot = false;
-};
-
 template<class Iterator, bool CheckOnly>
 class dachs_grammar final
     : public qi::grammar<
@@ -202,12 +207,20 @@ class dachs_grammar final
     using rule = qi::rule<Iterator, Value, comment_skipper<Iterator>, Extra...>;
 
     helper::colorizer c;
-    ast::path_type file_path;
+    detail::parse_state<Iterator> state;
+
+    // Note:
+    // Make a node in semantic actions written in C++ lambdas.
+    template<class NodeType, class... Args>
+    NodeType make_node(Args &&... args) const
+    {
+        return ast::make_in<NodeType>(state.arena, std::forward<Args>(args)...);
+    }
 
     template<class NodeType, class... Holders>
     auto make_node_ptr(Holders &&... holders)
     {
-        return phx::bind(detail::make_shared<typename NodeType::element_type, CheckOnly>{}, std::forward<Holders>(holders)...);
+        return phx::bind(detail::make_shared<typename NodeType::element_type, CheckOnly>{state.arena}, std::forward<Holders>(holders)...);
     }
 
     // Note:
@@ -222,15 +235,15 @@ class dachs_grammar final
     template<class NodeType, class... Holders>
     auto make_and_assign_to_val(Holders &&... holders)
     {
-        return _val = phx::bind(detail::make_shared<typename NodeType::element_type, CheckOnly>{}, std::forward<Holders>(holders)...);
+        return _val = phx::bind(detail::make_shared<typename NodeType::element_type, CheckOnly>{state.arena}, std::forward<Holders>(holders)...);
     }
 
 public:
 
     implicit_import<CheckOnly> implicit_import_installer;
 
-    dachs_grammar(Iterator const code_begin, ast::path_type p) noexcept
-        : dachs_grammar::base_type(inu), file_path(std::move(p))
+    dachs_grammar() noexcept
+        : dachs_grammar::base_type(inu), state()
     {
 
         // XXX:
@@ -317,7 +330,7 @@ public:
                         [this](auto &val, auto && s)
                         {
                             implicit_import_installer.string_found = true;
-                            val = ast::make<ast::node::string_literal>(std::forward<decltype(s)>(s));
+                            val = make_node<ast::node::string_literal>(std::forward<decltype(s)>(s));
                         },
                         _val, _a
                     )
@@ -352,7 +365,7 @@ public:
                     {
                         implicit_import_installer.array_found = true;
 
-                        return ast::make<ast::node::array_literal>(std::forward<decltype(exprs)>(exprs));
+                        return make_node<ast::node::array_literal>(std::forward<decltype(exprs)>(exprs));
                     }
                     , as_vector(_1)
                 )
@@ -483,13 +496,13 @@ public:
                 DACHS_KWD("new") >> qualified_type >> constructor_call >> -do_block
             ) [
                 _val = phx::bind(
-                    [](auto && type, auto && args, auto && maybe_do)
+                    [this](auto && type, auto && args, auto && maybe_do)
                     {
                         if (CheckOnly) {
                             return ast::node::object_construct{nullptr};
                         }
 
-                        auto const construct = ast::make<ast::node::object_construct>(
+                        auto const construct = make_node<ast::node::object_construct>(
                                     type,
                                     std::forward<decltype(args)>(args),
                                     std::forward<decltype(maybe_do)>(maybe_do)
@@ -507,7 +520,7 @@ public:
                             if ((*t)->name == "array" && !(*t)->template_params.empty()) {
                                 if (auto const a = get_as<ast::node::array_type>((*t)->template_params[0])) {
                                     auto inner_construct
-                                        = ast::make<ast::node::object_construct>(
+                                        = make_node<ast::node::object_construct>(
                                                 *a
                                             );
                                     inner_construct->args = std::move(construct->args);
@@ -614,17 +627,17 @@ public:
                 >> typed_expr
             ) [
                 _val = phx::bind(
-                        [](auto && stmts, auto const& expr)
+                        [this](auto && stmts, auto const& expr)
                         {
                             if (CheckOnly) {
                                 return ast::node::statement_block{nullptr};
                             }
 
-                            auto block = ast::make<ast::node::statement_block>(
+                            auto block = make_node<ast::node::statement_block>(
                                         std::forward<decltype(stmts)>(stmts)
                                     );
 
-                            auto ret = ast::make<ast::node::return_stmt>(expr);
+                            auto ret = make_node<ast::node::return_stmt>(expr);
                             ret->location = ast::node::location_of(expr);
                             block->value.emplace_back(std::move(ret));
                             return block;
@@ -961,7 +974,7 @@ public:
                             implicit_import_installer.string_found = true;
                         }
 
-                        val = ast::make<ast::node::primary_type>(
+                        val = make_node<ast::node::primary_type>(
                                 std::forward<decltype(name)>(name),
                                 std::forward<decltype(templates)>(templates)
                             );
@@ -983,10 +996,10 @@ public:
                     [this](auto && param_type)
                     {
                         implicit_import_installer.array_found = true;
-                        return ast::make<ast::node::primary_type>(
+                        return make_node<ast::node::primary_type>(
                                 "array",
                                 std::vector<ast::node::any_type>{
-                                    ast::make<ast::node::pointer_type>(
+                                    make_node<ast::node::pointer_type>(
                                         std::forward<decltype(param_type)>(param_type)
                                     )
                                 }
@@ -1486,7 +1499,7 @@ public:
                 // _2   : end of string to parse
                 // _3   : position after parsing
                 phx::bind(
-                    detail::position_getter<Iterator>{code_begin, file_path}
+                    detail::position_getter<Iterator>{state}
                     , _val, _1, _3)
 
                 , inu
@@ -1575,18 +1588,23 @@ public:
             // _2 : end of string to parse
             // _3 : iterator at failed point
             // _4 : what failed?
-            std::cerr << phx::val(c.red("Error") + " in ")
+            *phx::cref(state.diagnostics) << phx::val(c.red("Error") + " in ")
                       << phx::bind([](auto const begin, auto const err_pos) {
-                              return (boost::format("line:%1%, col:%2%") % spirit::get_line(err_pos) % spirit::get_column(begin, err_pos)).str();
+                              auto const pos = ast::source_files::line_col_in(begin, static_cast<std::size_t>(err_pos - begin));
+                              return (boost::format("line:%1%, col:%2%") % pos.first % pos.second).str();
                           }, _1, _3) << '\n'
                       << c.bold("Expected ", false) << _4 << c.reset()
                       << "\n\n"
                       << phx::bind([this /*for 'c'*/](auto const begin, auto const end, auto const err_itr) {
-                              return std::string{
-                                        spirit::get_line_start(begin, err_itr),
-                                        std::find_if(err_itr, end, [](auto c){ return c == '\r' || c == '\n'; })
-                                     } + '\n'
-                                     + std::string(spirit::get_column(begin, err_itr)-1, ' ') + c.green("^ here");
+                              auto const is_newline = [](auto c){ return c == '\r' || c == '\n'; };
+                              auto const line_start = std::find_if(
+                                      std::reverse_iterator<Iterator>{err_itr},
+                                      std::reverse_iterator<Iterator>{begin},
+                                      is_newline
+                                  ).base();
+                              auto const col = ast::source_files::line_col_in(begin, static_cast<std::size_t>(err_itr - begin)).second;
+                              return std::string{line_start, std::find_if(err_itr, end, is_newline)} + '\n'
+                                     + std::string(col-1, ' ') + c.green("^ here");
                           }, _1, _2, _3)
                       << '\n' << std::endl
         );
@@ -1861,40 +1879,145 @@ private:
         }
     } func_kind;
     // }}}
+
+public:
+
+    // Note:
+    // Prepare the per-parse state.  Must be called before each parse.
+    void reset(Iterator const code_begin, ast::file_id_type const file, std::shared_ptr<ast::node_arena> && arena, std::ostream &diagnostics = std::cerr)
+    {
+        state.code_begin = code_begin;
+        state.file = file;
+        state.arena = std::move(arena);
+        state.diagnostics = &diagnostics;
+        implicit_import_installer = implicit_import<CheckOnly>{};
+    }
+};
+
+// Note:
+// Both std::string and helper::source_buffer are parsed as a range of characters.
+using code_iterator = char const*;
+
+// Note:
+// Grammars are very heavy to construct.  They are built lazily at the first parse
+// and reused in the following parses.
+class parser::grammar_holder final {
+    std::unique_ptr<dachs_grammar<code_iterator, false>> grammar;
+    std::unique_ptr<dachs_grammar<code_iterator, true>> check_only_grammar;
+
+    template<class Grammar>
+    static Grammar &get_or_build(std::unique_ptr<Grammar> &g)
+    {
+        if (!g) {
+            g = std::make_unique<Grammar>();
+        }
+        return *g;
+    }
+
+public:
+
+    comment_skipper<code_iterator> const skipper;
+
+    auto &get(std::integral_constant<bool, false>)
+    {
+        return get_or_build(grammar);
+    }
+
+    auto &get(std::integral_constant<bool, true>)
+    {
+        return get_or_build(check_only_grammar);
+    }
 };
 
 template<bool CheckOnly>
-static inline ast::node::inu parse_impl(std::string const& code, ast::path_type && path)
+static inline ast::node::inu parse_impl(parser::grammar_holder &holder, code_iterator const begin, code_iterator const end, ast::file_id_type const file, std::shared_ptr<ast::node_arena> && arena, std::ostream &diagnostics)
 {
-    auto itr = detail::line_pos_iterator(std::begin(code));
-    using iterator_type = decltype(itr);
-    auto const begin = itr;
-    auto const end = detail::line_pos_iterator(std::end(code));
-    dachs_grammar<iterator_type, CheckOnly> dachs_parser{begin, std::move(path)};
-    comment_skipper<iterator_type> skipper;
+    auto itr = begin;
+    auto &dachs_parser = holder.get(std::integral_constant<bool, CheckOnly>{});
+    dachs_parser.reset(begin, file, std::move(arena), diagnostics);
     ast::node::inu root;
 
-    if (!qi::phrase_parse(itr, end, dachs_parser, skipper, root) || itr != end) {
-        throw parse_error{spirit::get_line(itr), spirit::get_column(begin, itr)};
+    bool const succeeded = qi::phrase_parse(itr, end, dachs_parser, holder.skipper, root) && itr == end;
+
+    if (succeeded) {
+        dachs_parser.implicit_import_installer.install(root);
     }
 
-    dachs_parser.implicit_import_installer.install(root);
+    // Note:
+    // The grammar must not keep the arena after the parse.  Nodes share its ownership.
+    // Resetting also clears the flags of the implicit import installer.
+    dachs_parser.reset(begin, file, nullptr);
+
+    if (!succeeded) {
+        auto const pos = ast::source_files::line_col_in(begin, static_cast<std::size_t>(std::distance(begin, itr)));
+        throw parse_error{pos.first, pos.second};
+    }
 
     return root;
 }
 
-ast::ast parser::parse(std::string const& code, std::string const& file_name) const
+template<bool CheckOnly>
+static inline ast::node::inu parse_code(
+        parser::grammar_holder &holder,
+        front_end const f,
+        code_iterator const begin,
+        code_iterator const end,
+        ast::file_id_type const file,
+        std::shared_ptr<ast::node_arena> && arena,
+        std::ostream &diagnostics = std::cerr)
+{
+    if (f == front_end::hand_written) {
+        return hand_written::parse(begin, end, file, arena, CheckOnly, diagnostics);
+    }
+
+    return parse_impl<CheckOnly>(holder, begin, end, file, std::move(arena), diagnostics);
+}
+
+static inline fs::path absolute_path_of(std::string const& file_name)
 {
     fs::path file_path{file_name};
     if (!file_path.has_root_directory()) {
         file_path = fs::current_path() / file_path;
     }
-    return {parse_impl<false>(code, std::make_shared<fs::path>(std::move(file_path))), file_name};
+    return file_path;
+}
+
+parser::parser(node_allocation const a, front_end const f)
+    : holder(std::make_unique<grammar_holder>()), allocation(a), syntax_front_end(f)
+{}
+
+parser::~parser() = default;
+
+ast::ast parser::parse(std::string const& code, std::string const& file_name) const
+{
+    auto const file = ast::source_files::add(absolute_path_of(file_name), code);
+    auto arena = allocation == node_allocation::arena ? std::make_shared<ast::node_arena>() : nullptr;
+
+    return {
+        parse_code<false>(*holder, syntax_front_end, code.data(), code.data() + code.size(), file, std::move(arena)),
+        file_name
+    };
+}
+
+ast::ast parser::parse(std::shared_ptr<helper::source_buffer const> const& code, std::string const& file_name) const
+{
+    auto const file = ast::source_files::add(absolute_path_of(file_name), code);
+    auto arena = allocation == node_allocation::arena ? std::make_shared<ast::node_arena>() : nullptr;
+
+    return {
+        parse_code<false>(*holder, syntax_front_end, code->begin(), code->end(), file, std::move(arena)),
+        file_name
+    };
+}
+
+void parser::check_syntax(std::string const& code, std::ostream &diagnostics) const
+{
+    parse_code<true>(*holder, syntax_front_end, code.data(), code.data() + code.size(), ast::source_files::no_file, nullptr, diagnostics);
 }
 
-void parser::check_syntax(std::string const& code) const
+void parser::check_syntax(helper::source_buffer const& code, std::ostream &diagnostics) const
 {
-    parse_impl<true>(code, nullptr);
+    parse_code<true>(*holder, syntax_front_end, code.begin(), code.end(), ast::source_files::no_file, nullptr, diagnostics);
 }
 
 } // namespace syntax
@@ -4,24 +4,75 @@
 #include <string>
 #include <vector>
 #include <utility>
+#include <memory>
 #include <cstddef>
+#include <iostream>
 
 #include <boost/format.hpp>
 
 #include "dachs/ast/ast_fwd.hpp"
+#include "dachs/helper/source_buffer.hpp"
 
 namespace dachs {
 namespace syntax {
 
+// Note:
+// How AST nodes are allocated.  'heap' allocates each node with std::make_shared().
+// 'arena' allocates all nodes of one parse from an ast::node_arena.  It reduces
+// heap allocations in parsing large sources.  The nodes are still held by
+// std::shared_ptr, so the AST can be used in the same way in both modes.
+enum class node_allocation {
+    heap,
+    arena,
+};
+
+// Note:
+// Which implementation parses the code.  'spirit' is the grammar written with
+// Boost.Spirit.  'hand_written' is the recursive descent parser in
+// hand_written_parser.hpp.  They accept the same language and build the same AST.
+enum class front_end {
+    spirit,
+    hand_written,
+};
+
+// Note:
+// The grammar is built at the first parse and reused by the following parses.
+// So a parser instance must not be used in multiple threads at the same time.
 class parser final {
 public:
+    class grammar_holder;
+
+private:
+    std::unique_ptr<grammar_holder> const holder;
+    node_allocation const allocation;
+    front_end const syntax_front_end;
+
+public:
+    explicit parser(node_allocation const a = node_allocation::heap, front_end const f = front_end::spirit);
+    ~parser();
+
     ast::ast parse(
             std::string const& code,
             std::string const& file_name
         ) const;
 
+    // Note:
+    // The buffer is registered to ast::source_files without copying the code.
+    ast::ast parse(
+            std::shared_ptr<helper::source_buffer const> const& code,
+            std::string const& file_name
+        ) const;
+
+    // Note:
+    // Syntax errors are reported to 'diagnostics'.
+    void check_syntax(
+            std::string const& code,
+            std::ostream &diagnostics = std::cerr
+        ) const;
+
     void check_syntax(
-            std::string const& code
+            helper::source_buffer const& code,
+            std::ostream &diagnostics = std::cerr
         ) const;
 };
 
@@ -0,0 +1,466 @@
+#if !defined DACHS_PARSER_TOKENIZER_HPP_INCLUDED
+#define      DACHS_PARSER_TOKENIZER_HPP_INCLUDED
+
+#include <string>
+#include <utility>
+#include <cstddef>
+#include <cstring>
+
+#include <boost/spirit/include/qi.hpp>
+
+namespace dachs {
+namespace syntax {
+
+namespace qi = boost::spirit::qi;
+
+// Note:
+// Syntax of float literals.  Shared by both front ends so that they read the
+// same value from the same literal.
+template<class FloatType>
+struct strict_real_policies_disallowing_trailing_dot final
+    : qi::strict_real_policies<FloatType> {
+    static bool const allow_trailing_dot = false;
+    // static bool const allow_leading_dot = false;
+};
+
+// Note:
+// Thrown when an expectation in the grammar is not met (e.g. 'end' is missing).
+// It corresponds to qi::expectation_failure in the Spirit front end.
+struct expectation_failure {
+    char const* where;
+    std::string what;
+};
+
+// Note:
+// Scanner of the hand-written front end.  Dachs can't be tokenized in advance
+// because the meaning of characters depends on the context (e.g. a newline is a
+// separator or a continuation, and 'a -1' is a call or a subtraction).  So the
+// parser asks the tokenizer for the token it expects at a position.
+//
+// All scanning functions skip blanks and comments before the token as the skipper
+// of the Spirit front end does.  On failure, the position is left after the skipped
+// blanks as Spirit's primitive parsers do.  The parser relies on it to produce the
+// same locations as the Spirit front end.
+class tokenizer final {
+public:
+    using iterator = char const*;
+
+private:
+    iterator const first;
+    iterator const last;
+
+public:
+    tokenizer(iterator const f, iterator const l) noexcept
+        : first(f), last(l)
+    {}
+
+    static bool is_alpha(char const c) noexcept
+    {
+        return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z');
+    }
+
+    static bool is_alnum(char const c) noexcept
+    {
+        return is_alpha(c) || ('0' <= c && c <= '9');
+    }
+
+    static bool is_ident(char const c) noexcept
+    {
+        return is_alnum(c) || c == '_';
+    }
+
+    static bool is_cntrl(char const c) noexcept
+    {
+        return (0 <= c && c < ' ') || c == '\x7f';
+    }
+
+    iterator begin() const noexcept
+    {
+        return first;
+    }
+
+    iterator end() const noexcept
+    {
+        return last;
+    }
+
+    // Note:
+    // Check the character just at the position without skipping.
+    bool at(iterator const p, char const c) const noexcept
+    {
+        return p != last && *p == c;
+    }
+
+    bool followed_by_ident(iterator const p) const noexcept
+    {
+        return p != last && is_ident(*p);
+    }
+
+    // Note:
+    // Skip blanks, '# ...' line comments and '#{ ... }#' block comments.
+    void skip(iterator &p) const
+    {
+        while (p != last) {
+            if (*p == ' ' || *p == '\t') {
+                ++p;
+            } else if (*p != '#') {
+                return;
+            } else if (p + 1 != last && p[1] == '{') {
+                auto i = p + 2;
+                while (i != last) {
+                    if (*i == '\\' && i + 1 != last && i[1] == '}') {
+                        i += 2;
+                    } else if (*i == '}' && i + 1 != last && i[1] == '#') {
+                        break;
+                    } else {
+                        ++i;
+                    }
+                }
+                if (i == last) {
+                    throw expectation_failure{i, "\"}#\""};
+                }
+                p = i + 2;
+            } else {
+                while (p != last && *p != '\r' && *p != '\n') {
+                    ++p;
+                }
+            }
+        }
+    }
+
+    iterator skipped(iterator p) const
+    {
+        skip(p);
+        return p;
+    }
+
+    bool eol(iterator &p) const
+    {
+        skip(p);
+        if (p == last) {
+            return false;
+        }
+        if (*p == '\r') {
+            ++p;
+            if (p != last && *p == '\n') {
+                ++p;
+            }
+            return true;
+        }
+        if (*p == '\n') {
+            ++p;
+            return true;
+        }
+        return false;
+    }
+
+    bool eoi(iterator &p) const
+    {
+        skip(p);
+        return p == last;
+    }
+
+    bool lit(iterator &p, char const c) const
+    {
+        skip(p);
+        if (p == last || *p != c) {
+            return false;
+        }
+        ++p;
+        return true;
+    }
+
+    bool lit(iterator &p, char const* s) const
+    {
+        skip(p);
+        auto i = p;
+        for (; *s != '\0'; ++s, ++i) {
+            if (i == last || *i != *s) {
+                return false;
+            }
+        }
+        p = i;
+        return true;
+    }
+
+    // Note:
+    // The literal which is not followed by an identifier character.
+    bool keyword(iterator &p, char const* const s) const
+    {
+        auto i = p;
+        if (!lit(i, s) || followed_by_ident(i)) {
+            return false;
+        }
+        p = i;
+        return true;
+    }
+
+    // Note:
+    // Check without consuming anything.
+    bool peek_lit(iterator p, char const* const s) const
+    {
+        return lit(p, s);
+    }
+
+    bool peek_keyword(iterator p, char const* const s) const
+    {
+        return keyword(p, s);
+    }
+
+    // Note:
+    // Identifiers.  'with_at' permits '@' for instance variables.  The suffixes are
+    // '?', repeated '\'' and '!'.
+    //   called function name : @? [a-zA-Z_][a-zA-Z0-9_]* '?'? '\''* '!'?
+    //   function name        :    [a-zA-Z_][a-zA-Z0-9_]* '?'? '\''*
+    //   variable name        : @? [a-zA-Z_][a-zA-Z0-9_]* '\''*  (quotes are dropped)
+    //   class name           :    [a-zA-Z_][a-zA-Z0-9_]*
+    bool called_function_name(iterator &p, std::string &name) const
+    {
+        return identifier(p, name, true, true, true, true);
+    }
+
+    bool function_name(iterator &p, std::string &name) const
+    {
+        return identifier(p, name, false, true, true, false);
+    }
+
+    bool variable_name(iterator &p, std::string &name) const
+    {
+        return identifier(p, name, true, false, false, false);
+    }
+
+    bool class_name(iterator &p, std::string &name) const
+    {
+        skip(p);
+        auto i = p;
+        if (i == last || !(is_alpha(*i) || *i == '_')) {
+            return false;
+        }
+        while (i != last && is_ident(*i)) {
+            ++i;
+        }
+        name.assign(p, i);
+        p = i;
+        return true;
+    }
+
+    bool character_literal(iterator &p, char &value) const
+    {
+        skip(p);
+        if (!at(p, '\'')) {
+            return false;
+        }
+        auto i = p + 1;
+
+        if (i != last && !is_cntrl(*i) && *i != '\\' && *i != '\'') {
+            value = *i++;
+        } else if (at(i, '\\')) {
+            ++i;
+            if (i == last) {
+                throw expectation_failure{i, "<escape sequence>"};
+            }
+            switch (*i) {
+            case 'b':  value = '\b'; break;
+            case 'f':  value = '\f'; break;
+            case 'n':  value = '\n'; break;
+            case 'r':  value = '\r'; break;
+            case 't':  value = '\t'; break;
+            case 'v':  value = '\v'; break;
+            case 'e':  value = '\e'; break;
+            case '0':  value = '\0'; break;
+            case '\\': value = '\\'; break;
+            case '\'': value = '\''; break;
+            default:
+                throw expectation_failure{i, "<escape sequence>"};
+            }
+            ++i;
+        } else {
+            throw expectation_failure{i, "<character>"};
+        }
+
+        if (!at(i, '\'')) {
+            throw expectation_failure{i, "\"'\""};
+        }
+        p = i + 1;
+        return true;
+    }
+
+    bool string_literal(iterator &p, std::string &value) const
+    {
+        skip(p);
+        if (!at(p, '"')) {
+            return false;
+        }
+        auto i = p + 1;
+
+        while (i != last) {
+            if (*i != '"' && *i != '\\' && !is_cntrl(*i)) {
+                value += *i++;
+                continue;
+            }
+
+            if (*i != '\\' || i + 1 == last || is_cntrl(i[1])) {
+                break;
+            }
+
+            switch (i[1]) {
+            case 'b': value += '\b'; break;
+            case 'f': value += '\f'; break;
+            case 'n': value += '\n'; break;
+            case 'r': value += '\r'; break;
+            case 't': value += '\t'; break;
+            case 'v': value += '\v'; break;
+            case 'e': value += '\e'; break;
+            default:  value += i[1]; break;
+            }
+            i += 2;
+        }
+
+        if (!at(i, '"')) {
+            throw expectation_failure{i, "\"\"\""};
+        }
+        p = i + 1;
+        return true;
+    }
+
+    bool symbol_literal(iterator &p, std::string &value) const
+    {
+        static char const* const symbol_chars = "=*/%+><&^|&!~_-";
+
+        skip(p);
+        if (!at(p, ':')) {
+            return false;
+        }
+        auto i = p + 1;
+        auto const is_symbol_char
+            = [](char const c)
+            {
+                return is_alnum(c) || (c != '\0' && std::strchr(symbol_chars, c) != nullptr);
+            };
+        while (i != last && is_symbol_char(*i)) {
+            value += *i++;
+        }
+        if (value.empty()) {
+            return false;
+        }
+        p = i;
+        return true;
+    }
+
+    // Note:
+    // Numbers are converted with Spirit's numeric parsers.  They give the same
+    // values (and the same behavior on overflow) as the Spirit front end.
+    bool boolean_literal(iterator &p, bool &value) const
+    {
+        skip(p);
+        auto i = p;
+        if (!qi::parse(i, last, qi::bool_, value) || followed_by_ident(i)) {
+            return false;
+        }
+        p = i;
+        return true;
+    }
+
+    bool float_literal(iterator &p, double &value) const
+    {
+        skip(p);
+        return qi::parse(p, last, qi::real_parser<double, strict_real_policies_disallowing_trailing_dot<double>>(), value);
+    }
+
+    bool uinteger_literal(iterator &p, unsigned int &value) const
+    {
+        skip(p);
+        auto i = p;
+        if (!qi::parse(i, last, ((qi::lit("0x") >> qi::hex) | ("0b" >> qi::bin) | ("0o" >> qi::oct) | qi::uint_) >> 'u', value)) {
+            return false;
+        }
+        if (followed_by_ident(i)) {
+            throw expectation_failure{i, "<end of unsigned integer literal>"};
+        }
+        p = i;
+        return true;
+    }
+
+    bool integer_literal(iterator &p, int &value) const
+    {
+        skip(p);
+        return qi::parse(p, last, (qi::lit("0x") >> qi::hex) | ("0b" >> qi::bin) | ("0o" >> qi::oct) | qi::int_, value);
+    }
+
+    // Note:
+    // Path of an imported module.  Each character is preceded by a skip as in the
+    // Spirit front end.  So blanks are dropped and the blanks after the path are consumed.
+    // '.' is appended before the following name is checked.
+    bool import_path(iterator &p, std::string &path) const
+    {
+        auto const name
+            = [this, &path](iterator &i)
+            {
+                bool found = false;
+                for (;;) {
+                    skip(i);
+                    if (i == last || !is_ident(*i)) {
+                        return found;
+                    }
+                    path += *i++;
+                    found = true;
+                }
+            };
+
+        auto i = p;
+        if (!name(i)) {
+            return false;
+        }
+        for (auto save = i;; save = i) {
+            if (!lit(i, '.')) {
+                p = save;
+                return true;
+            }
+            path += '.';
+            if (!name(i)) {
+                p = save;
+                return true;
+            }
+        }
+    }
+
+private:
+
+    bool identifier(iterator &p, std::string &name, bool const with_at, bool const with_question, bool const with_quotes, bool const with_bang) const
+    {
+        skip(p);
+        auto i = p;
+        std::string result;
+
+        if (with_at && at(i, '@')) {
+            result += *i++;
+        }
+        if (i == last || !(is_alpha(*i) || *i == '_')) {
+            return false;
+        }
+        while (i != last && is_ident(*i)) {
+            result += *i++;
+        }
+        if (with_question && at(i, '?')) {
+            result += *i++;
+        }
+        while (at(i, '\'')) {
+            if (with_quotes) {
+                result += '\'';
+            }
+            ++i;
+        }
+        if (with_bang && at(i, '!')) {
+            result += *i++;
+        }
+
+        name += result;
+        p = i;
+        return true;
+    }
+};
+
+} // namespace syntax
+} // namespace dachs
+
+#endif    // DACHS_PARSER_TOKENIZER_HPP_INCLUDED
@@ -7,6 +7,10 @@
 #include <tuple>
 #include <set>
 #include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <iostream>
 
 #include <boost/variant/apply_visitor.hpp>
 #include <boost/variant/static_visitor.hpp>
@@ -24,6 +28,7 @@
 #include "dachs/ast/ast.hpp"
 #include "dachs/ast/ast_walker.hpp"
 #include "dachs/ast/ast_copier.hpp"
+#include "dachs/ast/pass_fusion.hpp"
 #include "dachs/semantics/analyzer.hpp"
 #include "dachs/semantics/forward_analyzer_impl.hpp"
 #include "dachs/semantics/scope.hpp"
@@ -37,11 +42,13 @@
 #include "dachs/semantics/tmp_constructor_checker.hpp"
 #include "dachs/semantics/const_func_checker.hpp"
 #include "dachs/semantics/copy_resolver.hpp"
+#include "dachs/semantics/reachability.hpp"
 #include "dachs/fatal.hpp"
 #include "dachs/helper/variant.hpp"
 #include "dachs/helper/util.hpp"
 #include "dachs/helper/each.hpp"
 #include "dachs/helper/probable.hpp"
+#include "dachs/helper/parallel.hpp"
 
 namespace dachs {
 namespace semantics {
@@ -57,27 +64,48 @@ using boost::algorithm::all_of;
 using boost::algorithm::any_of;
 using type::type_of;
 
-struct return_types_gatherer {
-    std::vector<type::type> result_types;
-    std::vector<ast::node::return_stmt> failed_return_stmts;
+using return_stmts_map = std::unordered_map<scope::func_scope, std::vector<ast::node::return_stmt>>;
 
-    template<class Walker>
-    void visit(ast::node::return_stmt const& ret, Walker const& w)
-    {
-        w();
+// Note:
+// Pass to gather return statements of each function.  It observes the walk of symbol_analyzer
+// and records a return statement after its type is analyzed.  The return type of a function is
+// deduced from the records instead of walking the function again.  The records of a function
+// being analyzed are also used to resolve the return type of a recursive function.
+class return_types_gatherer {
+    scope::any_scope const& current_scope;
+    return_stmts_map &gathered;
 
-        if (!ret->ret_type) {
-            failed_return_stmts.push_back(ret);
-        } else {
-            result_types.push_back(ret->ret_type);
-        }
+public:
+
+    return_types_gatherer(scope::any_scope const& s, return_stmts_map &g) noexcept
+        : current_scope(s), gathered(g)
+    {}
+
+    template<class Node>
+    bool enter(Node const&) noexcept
+    {
+        return true;
     }
 
-    template<class T, class W>
-    void visit(T const&, W const& w)
+    void leave(ast::node::return_stmt const& ret)
     {
-        w();
+        auto const f = scope::enclosing_func_of(current_scope);
+        if (!f) {
+            return;
+        }
+
+        // Note:
+        // The same statement may be analyzed twice.  e.g. The body of constructor is
+        // analyzed to infer the instantiated class template before analyzing the constructor.
+        auto &rets = gathered[*f];
+        if (std::find(std::begin(rets), std::end(rets), ret) == std::end(rets)) {
+            rets.push_back(ret);
+        }
     }
+
+    template<class Node>
+    void leave(Node const&) noexcept
+    {}
 };
 
 // Note:
@@ -190,61 +218,100 @@ struct weak_ptr_locker : public boost::static_visitor<scope::any_scope> {
     }
 };
 
-// TODO:
-// If recursive call is used in 'if' expression, it fails to deduce
-// func fib(n)
-//     return (if n <= 1 then 1 else fib(n-1)+fib(n-2))
-// end
-struct recursive_function_return_type_resolver {
-    std::vector<type::type> result;
+// Note:
+// Pass to mark the nodes in lhs of assignment.  It observes the walk of symbol_analyzer
+// and marks a node before symbol_analyzer visits it.
+class var_ref_marker_for_lhs_of_assign {
+    std::vector<std::vector<ast::node::any_expr> const*> assignees;
+    std::size_t lhs_depth = 0u;
 
-    template<class Walker>
-    void visit(ast::node::return_stmt const& ret, Walker const&)
+    bool is_assignee(ast::node::any_expr const& e) const noexcept
     {
-        if (ret->ret_type) {
-            result.push_back(ret->ret_type);
+        if (assignees.empty()) {
+            return false;
+        }
+
+        for (auto const& a : *assignees.back()) {
+            if (&a == &e) {
+                return true;
+            }
         }
+
+        return false;
     }
 
-    template<class Node, class Walker>
-    void visit(Node const&, Walker const& w)
+public:
+
+    bool enter(ast::node::assignment_stmt const& assign)
     {
-        w();
+        assignees.push_back(&assign->assignees);
+        return true;
+    }
+
+    void leave(ast::node::assignment_stmt const&)
+    {
+        assignees.pop_back();
+    }
+
+    bool enter(ast::node::any_expr const& e) noexcept
+    {
+        if (is_assignee(e)) {
+            ++lhs_depth;
+        }
+        return true;
+    }
+
+    void leave(ast::node::any_expr const& e) noexcept
+    {
+        if (is_assignee(e)) {
+            --lhs_depth;
+        }
     }
-};
 
-struct var_ref_marker_for_lhs_of_assign {
     // Mark as lhs of assignment
-    template<class W>
-    void visit(ast::node::var_ref const& ref, W const&)
+    bool enter(ast::node::var_ref const& ref) noexcept
     {
-        ref->is_lhs_of_assignment = true;
+        if (lhs_depth > 0u) {
+            ref->is_lhs_of_assignment = true;
+        }
+        return true;
     }
 
     // Do not mark var ref in index access
-    template<class W>
-    void visit(ast::node::index_access const& a, W const&)
+    bool enter(ast::node::index_access const& a) noexcept
     {
+        if (lhs_depth == 0u) {
+            return true;
+        }
+
         // Note:
         // {expr}[{expr}] = {rhs}
         a->is_assign = true;
+        return false;
     }
 
     // Do not mark var ref in UFCS data access
-    template<class W>
-    void visit(ast::node::ufcs_invocation const& u, W const&)
+    bool enter(ast::node::ufcs_invocation const& u) noexcept
     {
+        if (lhs_depth == 0u) {
+            return true;
+        }
+
         // Note:
         // {expr}.name = {rhs}
         u->is_assign = true;
+        return false;
     }
 
-    // Otherwise, simply visit the node
-    template<class N, class W>
-    void visit(N const&, W const& w)
+    template<class Node>
+    bool enter(Node const&) noexcept
     {
-        w();
+        return true;
     }
+
+    template<class Node>
+    void leave(Node const&) noexcept
+    {}
 };
 
 struct var_ref_getter_for_lhs_of_assign {
@@ -393,57 +460,52 @@ struct class_template_instantiater : boost::static_visitor<boost::optional<std::
 };
 
 struct self_access_checker {
-    template<class Walker>
-    void visit(ast::node::var_ref const& var, Walker const& w)
+    bool enter(ast::node::var_ref const& var) noexcept
     {
         if (var->name == "self") {
             is_self_access = true;
-        } else {
-            w();
         }
+        return true;
     }
 
-    template<class Walker>
-    void visit(ast::node::func_invocation const& invocation, Walker const& w)
+    bool enter(ast::node::func_invocation const& invocation)
     {
         if (invocation->args.empty()) {
-            w();
-            return;
+            return true;
         }
 
         if (auto const a = get_as<ast::node::var_ref>(invocation->args[0])) {
             if ((*a)->name == "self") {
                 is_self_access_with_func = invocation;
             }
-            return;
+            return false;
         }
 
-        w();
+        return true;
     }
 
-    template<class Walker>
-    void visit(ast::node::ufcs_invocation const& invocation, Walker const& w)
+    bool enter(ast::node::ufcs_invocation const& invocation)
     {
         if (auto const a = get_as<ast::node::var_ref>(invocation->child)) {
             if ((*a)->name == "self") {
                 is_self_access_with_ufcs = invocation;
             }
-            return;
+            return false;
         }
 
-        w();
+        return true;
     }
 
-    template<class Node, class Walker>
-    void visit(Node const&, Walker const& w)
+    template<class Node>
+    bool enter(Node const&) const noexcept
     {
-        if (contains_self_access()) {
-            return;
-        }
-
-        w();
+        return !contains_self_access();
     }
 
+    template<class Node>
+    void leave(Node const&) const noexcept
+    {}
+
     bool contains_self_access() const noexcept
     {
         return is_self_access
@@ -457,14 +519,14 @@ struct self_access_checker {
         // @foo() -> self.foo() -> foo(self)
         if (is_self_access_with_func) {
             if (auto const callee_var = get_as<ast::node::var_ref>((*is_self_access_with_func)->child)) {
-                return (*callee_var)->name;
+                return (*callee_var)->name.str();
             }
         }
 
         // Note:
         // @foo -> self.foo
         if (is_self_access_with_ufcs) {
-            return (*is_self_access_with_ufcs)->member_name;
+            return (*is_self_access_with_ufcs)->member_name.str();
         }
 
         return boost::none;
@@ -486,6 +548,65 @@ private:
     boost::optional<ast::node::ufcs_invocation> is_self_access_with_ufcs = boost::none;
 };
 
+// Note:
+// Function bodies can be checked in parallel (see symbol_analyzer::analyze_in_parallel()).
+// Each worker has its own analyzer which checks only the bodies assigned to it.  The
+// requests which modify the states shared among functions (e.g. instantiating templates,
+// defining functions in global scope and resolving copiers) are processed one by one with
+// the owner analyzer.  The owner analyzed all other functions and keeps the shared states.
+// Workers read the shared states only while no request is being processed.
+template<class Analyzer>
+class instantiation_queue {
+    Analyzer &owner;
+    std::shared_timed_mutex mutex;
+
+public:
+
+    explicit instantiation_queue(Analyzer &o) noexcept
+        : owner(o)
+    {}
+
+    // Note:
+    // A worker must hold this lock while checking function bodies.
+    std::shared_lock<std::shared_timed_mutex> lock_for_worker()
+    {
+        return std::shared_lock<std::shared_timed_mutex>{mutex};
+    }
+
+    // Note:
+    // Process 'request' with the owner analyzer as if 'requester' did it.  The request
+    // sees the current scope of the requester and its errors are reported and counted
+    // by the requester.
+    template<class Request>
+    decltype(auto) process(Analyzer &requester, Request const& request)
+    {
+        // Note:
+        // Release the lock for the worker while waiting for other requests and workers.
+        // Otherwise, two workers requesting at the same time wait for each other.
+        mutex.unlock_shared();
+        BOOST_SCOPE_EXIT_ALL(this) {
+            mutex.lock_shared();
+        };
+
+        std::lock_guard<std::shared_timed_mutex> lock{mutex};
+
+        auto saved_scope = owner.current_scope;
+        auto const saved_diagnostics = owner.diagnostics;
+        auto const saved_failed = owner.failed;
+        owner.current_scope = requester.current_scope;
+        owner.diagnostics = requester.diagnostics;
+
+        BOOST_SCOPE_EXIT_ALL(&) {
+            requester.failed += owner.failed - saved_failed;
+            owner.failed = saved_failed;
+            owner.current_scope = std::move(saved_scope);
+            owner.diagnostics = saved_diagnostics;
+        };
+
+        return request(owner);
+    }
+};
+
 // Note: Walk to resolve symbol references
 class symbol_analyzer {
 
@@ -500,9 +621,26 @@ class symbol_analyzer {
     boost::optional<scope::func_scope> main_arg_ctor = boost::none;
     std::unordered_map<type::class_type, scope::weak_func_scope> copiers;
 
+    // Note:
+    // Results of the passes which observe the walk of this analyzer.
+    // (see walk_recursively())
+    return_stmts_map gathered_returns;
+    const_member_func_checker::states_type const_func_states;
+
+    // Note:
+    // Imported functions whose bodies are not checked until they are reached from 'main'
+    // (see defer_imported_functions()).
+    std::unordered_set<ast::node::function_definition> deferred_functions;
+
+    // Note:
+    // Set when this analyzer is a worker checking function bodies in parallel.
+    instantiation_queue<symbol_analyzer> *queue = nullptr;
+    std::ostream *diagnostics = &std::cerr;
+
     using class_instantiation_type_map_type = std::unordered_map<std::string, type::type>;
 
     friend class ctor_checker<symbol_analyzer &>;
+    friend class instantiation_queue<symbol_analyzer>;
 
     template<class Analyzer, class Node>
     friend class copy_resolver;
@@ -521,14 +659,14 @@ class symbol_analyzer {
     template<class Node, class Message>
     void semantic_error(Node const& n, Message const& msg)
     {
-        output_semantic_error(n, msg);
+        output_semantic_error(n, msg, *diagnostics);
         failed++;
     }
 
     template<class Message>
         void semantic_error(std::size_t const l, std::size_t const c, Message const& msg)
     {
-        output_semantic_error(l, c, msg);
+        output_semantic_error(l, c, msg, *diagnostics);
         failed++;
     }
 
@@ -557,13 +695,12 @@ class symbol_analyzer {
     }
 
     template<class FuncDef>
-    boost::optional<FuncDef> already_instantiated_func(FuncDef const& def, std::vector<type::type> const& arg_types) const
+    boost::optional<FuncDef> already_instantiated_func(FuncDef const& def, std::vector<type::type> const& arg_types, std::size_t const arg_types_hash) const
     {
-       auto const scope = def->scope.lock();
-
        auto const its_the_func
-           = [&]
+           = [&](auto const& d)
            {
+               auto const scope = d->scope.lock();
                for (auto const& lr : helper::zipped(scope->params, arg_types)) {
                    auto const& l = boost::get<0>(lr)->type;
                    auto const& r = boost::get<1>(lr);
@@ -573,16 +710,34 @@ class symbol_analyzer {
                }
                return true;
            };
-       if (its_the_func()) {
+
+       if (its_the_func(def)) {
            return def;
-       } else {
-           for (auto const& i : def->instantiated) {
-               if (auto const found = already_instantiated_func(i, arg_types)) {
-                   return found;
-               }
+       }
+
+       // Note:
+       // Only the instantiations whose hash values are the same as the argument types
+       // are compared.  The cost doesn't depend on the number of instantiations.
+       auto const candidates = def->instantiated_index.equal_range(arg_types_hash);
+       for (auto i = candidates.first; i != candidates.second; ++i) {
+           if (its_the_func(i->second)) {
+               return i->second;
            }
-           return boost::none;
        }
+
+       for (auto const& i : def->partially_instantiated) {
+           if (auto const found = already_instantiated_func(i, arg_types, arg_types_hash)) {
+               return found;
+           }
+       }
+
+       return boost::none;
+    }
+
+    template<class FuncDef>
+    boost::optional<FuncDef> already_instantiated_func(FuncDef const& def, std::vector<type::type> const& arg_types) const
+    {
+        return already_instantiated_func(def, arg_types, type::hash_types(arg_types));
     }
 
     template<class FuncDefNode>
@@ -593,6 +748,10 @@ class symbol_analyzer {
             std::vector<type::type> const& arg_types
         )
     {
+        if (queue) {
+            return queue->process(*this, [&](auto &a){ return a.instantiate_function_from_template(func_template_def, func_template_scope, arg_types); });
+        }
+
         assert(func_template_scope->is_template());
 
         // TODO:
@@ -604,7 +763,7 @@ class symbol_analyzer {
 
         // Note: No need to check functions duplication
         // Note: Type of parameters are analyzed here
-        failed += dispatch_forward_analyzer(instantiated_func_def, enclosing_scope, importer);
+        failed += dispatch_forward_analyzer(instantiated_func_def, enclosing_scope, importer, *diagnostics);
         assert(!instantiated_func_def->scope.expired());
         auto instantiated_func_scope = instantiated_func_def->scope.lock();
 
@@ -658,6 +817,14 @@ class symbol_analyzer {
 
         // Add instantiated function to function template node in AST
         func_template_def->instantiated.push_back(instantiated_func_def);
+        if (instantiated_func_scope->is_template()) {
+            func_template_def->partially_instantiated.push_back(instantiated_func_def);
+        } else {
+            // Note:
+            // Types of parameters are equal to the argument types here.  They are
+            // never changed after the function is fully instantiated.
+            func_template_def->instantiated_index.emplace(type::hash_types(arg_types), instantiated_func_def);
+        }
 
         return std::make_pair(instantiated_func_def, instantiated_func_scope);
     }
@@ -665,6 +832,10 @@ class symbol_analyzer {
     template<class ArgTypes>
     scope::func_scope instantiate_builtin_function(scope::func_scope const& scope, ArgTypes const& arg_types)
     {
+        if (queue) {
+            return queue->process(*this, [&](auto &a){ return a.instantiate_builtin_function(scope, arg_types); });
+        }
+
         auto func = scope::make<scope::func_scope>(nullptr, global, scope->name, true);
         func->body = scope::make<scope::local_scope>(func);
         auto func_var = symbol::make<symbol::var_symbol>(nullptr, scope->name, true, true);
@@ -676,8 +847,9 @@ class symbol_analyzer {
         helper::each(
                 [&func](auto const& p, auto const& t)
                 {
-                    func->params.push_back(symbol::make<symbol::var_symbol>(nullptr, p->name, true, true));
-                    func->params.back()->type = t;
+                    auto param = symbol::make<symbol::var_symbol>(nullptr, p->name, true, true);
+                    param->type = t;
+                    func->force_push_back_param(std::move(param));
                 },
                 scope->params,
                 arg_types
@@ -695,6 +867,12 @@ class symbol_analyzer {
 
     type::type from_type_node(ast::node::any_type const& n, bool const allow_omit_return = false)
     {
+        // Note:
+        // Class templates may be instantiated.
+        if (queue) {
+            return queue->process(*this, [&](auto &a){ return a.from_type_node(n, allow_omit_return); });
+        }
+
         return type::from_ast<decltype(*this)>(n, current_scope, *this, allow_omit_return).apply(
                 [](auto const& success){ return success; },
                 [&, this](auto const& failure)
@@ -722,6 +900,10 @@ class symbol_analyzer {
             return false;
         }
 
+        if (queue) {
+            return queue->process(*this, [&](auto &a){ return a.instantiate_param_types(t, n); });
+        }
+
         auto const error = with_current_scope(
             [&t, this](auto const& s)
             {
@@ -788,6 +970,12 @@ class symbol_analyzer {
     template<class Node>
     bool resolve_deep_copy(type::type const& t, Node const& node)
     {
+        // Note:
+        // Copiers may be defined.
+        if (queue) {
+            return queue->process(*this, [&](auto &a){ return a.resolve_deep_copy(t, node); });
+        }
+
         copy_resolver<symbol_analyzer, Node> resolver{*this, node};
         return t.apply_visitor(resolver);
     }
@@ -822,10 +1010,26 @@ class symbol_analyzer {
     bool walk_recursively(Node && node)
     {
         auto const saved_failed = failed;
-        ast::walk_topdown(std::forward<Node>(node), *this);
+
+        // Note:
+        // Auxiliary passes don't walk AST by themselves.  They observe this walk.
+        var_ref_marker_for_lhs_of_assign marker;
+        return_types_gatherer gatherer{current_scope, gathered_returns};
+        const_member_func_checker const_checker{current_scope, const_func_states};
+        auto passes = ast::fuse_passes(marker, gatherer, const_checker);
+        ast::walk_topdown(std::forward<Node>(node), ast::observe(*this, passes));
+
         return failed <= saved_failed;
     }
 
+    bool walk_function_body(ast::node::function_definition def)
+    {
+        // Note:
+        // enclosing scope of function scope is always global scope
+        deferred_functions.erase(def);
+        return walk_recursively_with(global, def);
+    }
+
     template<class Scope, class Node>
     bool walk_recursively_with(Scope const& scope, Node && node)
     {
@@ -855,6 +1059,12 @@ public:
         : current_scope{root}, global{global}, importer(i)
     {}
 
+    // Note:
+    // Analyzer for a worker which checks function bodies in parallel
+    symbol_analyzer(scope::global_scope const& global, syntax::importer &i, instantiation_queue<symbol_analyzer> &q) noexcept
+        : current_scope{global}, global{global}, importer(i), queue(&q)
+    {}
+
     size_t num_errors() const noexcept
     {
         return failed;
@@ -884,8 +1094,8 @@ public:
                     std::vector<type::type>{
                         clazz->type,
                         type::get_builtin_type("uint", type::no_opt),
-                        type::make<type::pointer_type>(
-                                type::make<type::pointer_type>(
+                        type::make_interned<type::pointer_type>(
+                                type::make_interned<type::pointer_type>(
                                     type::get_builtin_type("char", type::no_opt)
                                 )
                             )
@@ -1015,45 +1225,49 @@ public:
 
     bool /*success?*/ deduce_return_type(ast::node::function_definition const& func, scope::func_scope const& scope)
     {
-        return_types_gatherer gatherer;
-        {
-            auto func_ = func; // to remove const
-            ast::make_walker(gatherer).walk(func_);
+        std::vector<type::type> result_types;
+        std::vector<ast::node::return_stmt> failed_return_stmts;
+        for (auto const& ret : gathered_returns[scope]) {
+            if (!ret->ret_type) {
+                failed_return_stmts.push_back(ret);
+            } else {
+                result_types.push_back(ret->ret_type);
+            }
         }
 
-        if (!gatherer.failed_return_stmts.empty()) {
+        if (!failed_return_stmts.empty()) {
             semantic_error(
                 func,
                 boost::format(
                     "  Can't deduce return type of function '%1%' from return statement\n"
                     "  Note: return statement is here: %2%")
                     % func->name
-                    % gatherer.failed_return_stmts[0]->location
+                    % failed_return_stmts[0]->location
             );
             return false;
         }
 
-        if (!gatherer.result_types.empty()) {
+        if (!result_types.empty()) {
             if (func->kind == ast::symbol::func_kind::proc) {
-                if (gatherer.result_types.size() != 1 || gatherer.result_types[0] != type::get_unit_type()) {
+                if (result_types.size() != 1 || result_types[0] != type::get_unit_type()) {
                     semantic_error(func, boost::format("  proc '%1%' can't return any value") % func->name);
                     return false;
                 }
             }
 
             if (any_of(
-                    gatherer.result_types,
-                    [&](auto const& t){ return gatherer.result_types[0] != t; })
+                    result_types,
+                    [&](auto const& t){ return result_types[0] != t; })
             ) {
                 std::string msg = "  Mismatch among the result types of return statements in function '" + func->name + "'";
-                for (auto const& t : gatherer.result_types) {
+                for (auto const& t : result_types) {
                     msg += "\n  Note: Return type candidate is '" + t.to_string() + "'";
                 }
                 semantic_error(func, msg);
                 return false;
             }
 
-            auto const& deduced_type = gatherer.result_types[0];
+            auto const& deduced_type = result_types[0];
 
             if (func->ret_type) {
                 auto const& ret = *func->ret_type;
@@ -1113,18 +1327,36 @@ public:
     template<class Walker>
     void visit(ast::node::function_definition const& func, Walker const& w)
     {
+        if (helper::exists(deferred_functions, func)) {
+            return;
+        }
+
         if (already_visited(func)) {
             if (func->ret_type || func->kind == ast::symbol::func_kind::proc || func->is_template()) {
                 return;
             }
-            recursive_function_return_type_resolver resolver;
-            auto func_ = func; // To remove const
-            ast::make_walker(resolver).walk(func_);
-            if (resolver.result.empty()) {
+            // Note:
+            // The function is being analyzed and it is called recursively.
+            // Return statements analyzed so far are used to resolve the return type.
+            //
+            // TODO:
+            // If recursive call is used in 'if' expression, it fails to deduce
+            // func fib(n)
+            //     return (if n <= 1 then 1 else fib(n-1)+fib(n-2))
+            // end
+            assert(!func->scope.expired());
+            std::vector<type::type> result;
+            for (auto const& ret : gathered_returns[func->scope.lock()]) {
+                if (ret->ret_type) {
+                    result.push_back(ret->ret_type);
+                }
+            }
+
+            if (result.empty()) {
                 semantic_error(func, boost::format("  Can't deduce return type of function '%1%' from return statement") % func->name);
-            } else if (boost::algorithm::any_of(resolver.result, [&](auto const& t){ return resolver.result[0] != t; })) {
+            } else if (boost::algorithm::any_of(result, [&](auto const& t){ return result[0] != t; })) {
                 std::string note = "";
-                for (auto const& t : resolver.result) {
+                for (auto const& t : result) {
                     note += '\'' + t.to_string() + "' ";
                 }
                 semantic_error(
@@ -1136,9 +1368,8 @@ public:
                           % note
                     );
             } else {
-                func->ret_type = resolver.result[0];
-                assert(!func->scope.expired());
-                func->scope.lock()->ret_type = resolver.result[0];
+                func->ret_type = result[0];
+                func->scope.lock()->ret_type = result[0];
             }
             return;
         }
@@ -1195,11 +1426,9 @@ public:
             }
         }
 
-        {
-            auto func_ = func; // Note: Remove const by copy
-            const_member_func_checker const_checker{scope, func_};
-            scope->is_const_ = const_checker.check_const();
-        }
+        // Note:
+        // The body was checked by const_member_func_checker while walking it.
+        scope->is_const_ = const_member_func_checker::result_of(const_func_states, scope);
     }
 
     template<class Walker>
@@ -1248,7 +1477,7 @@ public:
                     }
                 }
 
-                if (!scope->define_variable(new_var)) {
+                if (!scope->define_variable(new_var, *diagnostics)) {
                     failed++;
                     return false;
                 }
@@ -1286,10 +1515,10 @@ public:
             return;
         }
 
-        auto name = var->name;
-        if (name.back() == '!') {
-            name.pop_back();
-        }
+        auto const name
+            = var->name.back() == '!'
+                ? helper::identifier{var->name.substr(0u, var->name.size() - 1u)}
+                : var->name;
 
         auto const maybe_var_symbol = boost::apply_visitor(scope::var_symbol_resolver{name}, current_scope);
         if (!maybe_var_symbol) {
@@ -1384,7 +1613,7 @@ public:
                 array_class,
                 std::vector<type::type>{
                     array_class->type,
-                    type::make<type::pointer_type>(elem_type),
+                    type::make_interned<type::pointer_type>(elem_type),
                     type::get_builtin_type("uint", type::no_opt)
                 }
             );
@@ -1477,7 +1706,7 @@ public:
                     str_scope,
                     std::vector<type::type>{
                         str_scope->type,
-                        type::make<type::pointer_type>(type::get_builtin_type("char", type::no_opt)),
+                        type::make_interned<type::pointer_type>(type::get_builtin_type("char", type::no_opt)),
                         type::get_builtin_type("uint", type::no_opt)
                     }
                 );
@@ -1509,7 +1738,7 @@ public:
         for (auto const& e : tuple_lit->element_exprs) {
             type->element_types.emplace_back(type_of(e));
         }
-        tuple_lit->type = type;
+        tuple_lit->type = type::intern(type);
     }
 
     template<class Walker>
@@ -1527,6 +1756,15 @@ public:
         auto const lambda_scope = lambda->def->scope.lock();
         assert(lambda_scope->is_anonymous());
 
+        register_lambda(lambda, lambda_scope);
+    }
+
+    void register_lambda(ast::node::lambda_expr const& lambda, scope::func_scope const& lambda_scope)
+    {
+        if (queue) {
+            return queue->process(*this, [&](auto &a){ a.register_lambda(lambda, lambda_scope); });
+        }
+
         global->define_function(lambda_scope);
         lambda->type = type::make<type::generic_func_type>(lambda_scope);
         lambdas.push_back(lambda);
@@ -1926,7 +2164,10 @@ public:
         if (!func_def->ret_type) {
             // Note:
             // enclosing scope of function scope is always global scope
-            if (!walk_recursively_with(global, func_def)) {
+            // The return type of the function is deduced by the owner of the queue because
+            // other workers may call the function at the same time.
+            auto const walk = [&](auto &a){ return a.walk_function_body(func_def); };
+            if (!(queue ? queue->process(*this, walk) : walk(*this))) {
                 return helper::oops_fmt(
                         "  Failed to analyze function '%1%' defined at %2%"
                      , func->to_string(), func_def->location
@@ -2293,7 +2534,9 @@ public:
                 return;
             }
         } else {
-            to->return_type = func->ret_type;
+            // Note:
+            // Don't set the return type to 'to' directly because it may be an interned type.
+            cast->type = type::intern(type::make<type::func_type>(to->param_types, func->ret_type));
         }
 
         cast->casted_func_scope = func;
@@ -2607,7 +2850,8 @@ public:
             auto &stmt = body_stmts[idx];
             if (idx < init_end_point_idx && !all_initialized()) {
                 self_access_checker checker;
-                ast::walk_topdown(stmt, checker);
+                auto passes = ast::fuse_passes(checker);
+                ast::walk_topdown(stmt, passes);
                 if (checker.contains_self_access()) {
                     if (auto const n = checker.violated_member_name()) {
                         if (!is_initialized(*n)) {
@@ -2688,7 +2932,7 @@ public:
                     auto const new_var = symbol::make<symbol::var_symbol>(decl, decl->name, !decl->is_var);
                     decl->symbol = new_var;
                     new_var->type = construct->type;
-                    ctor->body->define_variable(new_var);
+                    ctor->body->define_variable(new_var, *diagnostics);
                 }
 
                 auto init = ast::make<ast::node::initialize_stmt>(
@@ -2857,7 +3101,7 @@ public:
 
         auto copied_def = ast::copy_ast(def);
         auto const enclosing_scope = enclosing_scope_of(def->scope.lock());
-        failed += dispatch_forward_analyzer(copied_def, enclosing_scope, importer);
+        failed += dispatch_forward_analyzer(copied_def, enclosing_scope, importer, *diagnostics);
         assert(!copied_def->scope.expired());
 
         def->instantiated.push_back(copied_def);
@@ -2944,6 +3188,12 @@ public:
     auto visit_class_construct_impl(ClassScope &&scope, Types &&arg_types)
         -> helper::probable<std::pair<scope::class_scope, scope::func_scope>>
     {
+        // Note:
+        // Class templates and constructors may be instantiated.
+        if (queue) {
+            return queue->process(*this, [&](auto &a){ return a.visit_class_construct_impl(scope, arg_types); });
+        }
+
         auto const ctor_candidates = scope->resolve_ctor(arg_types);
 
         auto const note_msg
@@ -3135,7 +3385,7 @@ public:
                 }
                 tuple_type->element_types.push_back(t);
             }
-            ret->ret_type = tuple_type;
+            ret->ret_type = type::intern(tuple_type);
         }
     }
 
@@ -3238,7 +3488,8 @@ public:
             = [&, this](auto const& elem_type)
             {
                 auto copied_block = ast::copy_ast(for_->body_stmts);
-                auto const dispatch_failed = dispatch_forward_analyzer(copied_block, parent_scope, importer);
+                auto const dispatch = [&](auto &a){ return dispatch_forward_analyzer(copied_block, parent_scope, importer, *a.diagnostics); };
+                auto const dispatch_failed = queue ? queue->process(*this, dispatch) : dispatch(*this);
                 if (dispatch_failed > 0u) {
                     failed += dispatch_failed;
                     tuple_traverse_error(elem_type);
@@ -3253,7 +3504,7 @@ public:
                     {
                         auto new_var = symbol::make<symbol::var_symbol>(param, param->name, !param->is_var);
                         new_var->type = type;
-                        if (!scope->define_variable_without_shadowing_check(std::move(new_var))) {
+                        if (!scope->define_variable_without_shadowing_check(std::move(new_var), *diagnostics)) {
                             failed++;
                         }
                     };
@@ -3769,7 +4020,7 @@ public:
                 for (auto const& e : rhs_exprs) {
                     rhs_type->element_types.push_back(type_of(e));
                 }
-                substitute_type(decl, rhs_type);
+                substitute_type(decl, type::intern(rhs_type));
             }
         } else {
             if (rhs_exprs.size() == 1) {
@@ -3829,8 +4080,8 @@ public:
         assert(assign->assignees.size() == assign->rhs_exprs.size());
         assert(assign->op == "=");
 
-        ast::walk_topdown(assign->assignees, var_ref_marker_for_lhs_of_assign{});
-
+        // Note:
+        // Assignees are already marked by var_ref_marker_for_lhs_of_assign which observes this walk.
         w();
 
         // Note:
@@ -3946,13 +4197,158 @@ public:
             );
     }
 
+    template<class Node>
+    void analyze(Node &node)
+    {
+        walk_recursively(node);
+    }
+
+    // Note:
+    // Analyze the program checking the bodies of independent functions in parallel.
+    // A function is independent when its return type is specified and it is not a
+    // template, a member function nor a lambda.  Its body is not needed to check other
+    // functions.  At first, this analyzer checks all other parts of the program.  Then
+    // workers check the independent functions.  Diagnostics of each function are buffered
+    // and output in the order of functions after all workers finished.
+    void analyze_in_parallel(ast::node::inu &root, unsigned int const jobs)
+    {
+        std::vector<ast::node::function_definition> independent_funcs;
+        for (auto const& f : root->functions) {
+            if (!f->ret_type || f->scope.expired()) {
+                continue;
+            }
+
+            auto const scope = f->scope.lock();
+            if (scope->is_template() || scope->is_member_func || scope->is_anonymous() || helper::exists(deferred_functions, f)) {
+                continue;
+            }
+
+            independent_funcs.push_back(f);
+            already_visited_functions.insert(f);
+        }
+
+        walk_recursively(root);
+
+        if (independent_funcs.empty()) {
+            return;
+        }
+
+        auto const num_tasks = independent_funcs.size();
+        instantiation_queue<symbol_analyzer> queue{*this};
+        std::vector<std::unique_ptr<symbol_analyzer>> workers;
+        for (std::size_t w = 0u; w < helper::num_parallel_workers(num_tasks, jobs); ++w) {
+            workers.push_back(std::make_unique<symbol_analyzer>(global, importer, queue));
+        }
+        std::vector<std::ostringstream> outputs(num_tasks);
+
+        BOOST_SCOPE_EXIT_ALL(&) {
+            for (auto const& o : outputs) {
+                std::cerr << o.str();
+            }
+            for (auto const& w : workers) {
+                failed += w->failed;
+            }
+        };
+
+        helper::parallel_for_each_index_on_workers(
+                num_tasks,
+                jobs,
+                [&](std::size_t const w, std::size_t const i)
+                {
+                    auto &worker = *workers[w];
+                    auto const lock = queue.lock_for_worker();
+                    worker.diagnostics = &outputs[i];
+                    worker.analyze(independent_funcs[i]);
+                }
+            );
+    }
+
+    // Note:
+    // Imported modules (e.g. std.string) bring many functions which a program doesn't use.
+    // Bodies of imported non-template functions are not checked in the walk of the program.
+    // They are checked when they are reached from 'main' (see check_reachable_funcs()) or
+    // called while deducing the return type of a caller.
+    // When the program has no 'main', all functions are checked as before.
+    void defer_imported_functions(ast::node::inu const& root)
+    {
+        auto const file = root->location.file;
+        if (file == ast::source_files::no_file) {
+            return;
+        }
+
+        auto const has_main = boost::algorithm::any_of(global->functions, [](auto const& f){ return f->is_main_func(); });
+        if (!has_main) {
+            return;
+        }
+
+        for (auto const& f : root->functions) {
+            if (f->location.file == file
+                    || f->location.file == ast::source_files::no_file
+                    || f->scope.expired()) {
+                continue;
+            }
+
+            auto const scope = f->scope.lock();
+            if (scope->is_template() || scope->is_member_func) {
+                continue;
+            }
+
+            deferred_functions.insert(f);
+        }
+    }
+
+    // Note:
+    // Collect the functions reachable from 'main', the constructor for command line
+    // arguments and copiers.  Deferred functions are checked when they are reached.
+    // @return : empty if the program has no 'main'
+    std::unordered_set<scope::func_scope> check_reachable_funcs(ast::node::inu const& root)
+    {
+        auto const main_func = helper::find_if(global->functions, [](auto const& f){ return f->is_main_func(); });
+        if (!main_func) {
+            return {};
+        }
+
+        auto roots = collect_referred_funcs(root->global_constants);
+        roots.push_back(*main_func);
+        if (main_arg_ctor) {
+            roots.push_back(*main_arg_ctor);
+        }
+
+        std::unordered_set<scope::func_scope> reached;
+        while (!roots.empty()) {
+            collect_reachable_funcs(
+                    std::move(roots),
+                    reached,
+                    [this](auto const& def)
+                    {
+                        if (helper::exists(deferred_functions, def)) {
+                            walk_function_body(def);
+                        }
+                    }
+                );
+
+            // Note:
+            // Copiers are used by code generation for any copied value.  They may be
+            // defined while checking deferred functions.
+            roots.clear();
+            for (auto const& c : copiers) {
+                auto const copier = c.second.lock();
+                if (copier && !helper::exists(reached, copier)) {
+                    roots.push_back(copier);
+                }
+            }
+        }
+
+        return reached;
+    }
+
     template<class Root>
     auto resolve_lambda(Root const& root)
     {
         detail::lambda_resolver resolver;
 
         for (auto &l : lambdas) {
-            ast::walk_topdown(l, resolver);
+            resolver.resolve(l);
         }
 
         for (auto const& l : lambdas) {
@@ -4027,11 +4423,17 @@ public:
 
 } // namespace detail
 
-semantics_context check_semantics(ast::ast &a, scope::scope_tree &t, syntax::importer &i)
+semantics_context check_semantics(ast::ast &a, scope::scope_tree &t, syntax::importer &i, unsigned int const jobs)
 {
     detail::symbol_analyzer resolver{t.root, t.root, i};
-    ast::walk_topdown(a.root, resolver);
+    resolver.defer_imported_functions(a.root);
+    if (jobs > 1u) {
+        resolver.analyze_in_parallel(a.root, jobs);
+    } else {
+        resolver.analyze(a.root);
+    }
     resolver.analyze_main_func();
+    auto reachable_funcs = resolver.check_reachable_funcs(a.root);
     auto const failed = resolver.num_errors();
 
     if (failed > 0) {
@@ -4045,7 +4447,8 @@ semantics_context check_semantics(ast::ast &a, scope::scope_tree &t, syntax::imp
         t,
         resolver.resolve_lambda(a.root),
         resolver.get_main_arg_ctor(),
-        resolver.get_copiers()
+        resolver.get_copiers(),
+        std::move(reachable_funcs)
     };
 }
 
@@ -9,7 +9,9 @@
 namespace dachs {
 namespace semantics {
 
-semantics_context check_semantics(ast::ast &a, scope::scope_tree &t, syntax::importer &i);
+// Note:
+// When 'jobs' is greater than 1, bodies of independent functions are checked on 'jobs' threads.
+semantics_context check_semantics(ast::ast &a, scope::scope_tree &t, syntax::importer &i, unsigned int const jobs = 1u);
 
 } // namespace semantics
 } // namespace dachs
@@ -2,9 +2,14 @@
 #define      DACHS_SEMANTICS_CONST_FUNC_CHECKER_HPP_INCLUDED
 
 #include <typeinfo>
+#include <vector>
+#include <unordered_map>
+
+#include <boost/optional.hpp>
 
 #include "dachs/ast/ast.hpp"
 #include "dachs/ast/ast_walker.hpp"
+#include "dachs/ast/pass_fusion.hpp"
 #include "dachs/semantics/scope.hpp"
 #include "dachs/semantics/type.hpp"
 #include "dachs/helper/variant.hpp"
@@ -17,21 +22,90 @@ namespace detail {
 using helper::variant::get_as;
 using helper::variant::apply_lambda;
 
+// Note:
+// Pass to check that a member function is const.  A member function is const when it
+// doesn't assign to the instance variables of its receiver and calls only const member
+// functions of the receiver.
+// The checker observes the walk of symbol_analyzer and checks functions while they are
+// analyzed.  A member function which is not checked yet when it is called is checked
+// in its own walk (see check_const_member_func()).
 class const_member_func_checker {
+public:
+
+    // Note:
+    // false when the function is already known to be non-const
+    using states_type = std::unordered_map<scope::func_scope, bool>;
+
+private:
+
+    // Note:
+    // 'current_scope' is null when the checker walks only 'target'.
+    scope::any_scope const* const current_scope;
+    boost::optional<scope::func_scope> const target;
+    states_type &states;
+    std::vector<std::vector<ast::node::any_expr> const*> assignees;
+
+    scope_node::basic_scope const* cached_scope = nullptr;
+    boost::optional<scope::func_scope> cached_func = boost::none;
+
+    static bool is_checked(scope::func_scope const& f) noexcept
+    {
+        return f->is_member_func && !f->is_ctor() && !f->is_template();
+    }
+
+    boost::optional<scope::func_scope> const& checked_func()
+    {
+        if (!current_scope) {
+            return target;
+        }
+
+        // Note:
+        // Scopes are owned by the arena of the scope tree.  So the address of a scope
+        // is never reused while analyzing.
+        auto const s = scope_node::basic_scope::pointer_of(*current_scope);
+        if (s != cached_scope) {
+            cached_scope = s;
+            cached_func = scope::enclosing_func_of(*current_scope);
+            if (cached_func && !is_checked(*cached_func)) {
+                cached_func = boost::none;
+            }
+        }
+
+        return cached_func;
+    }
+
+    bool &state_of(scope::func_scope const& f)
+    {
+        return states.emplace(f, true).first->second;
+    }
 
-    bool is_const_func = true;
-    scope::func_scope const& scope;
-    ast::node::function_definition &def;
+    bool is_assignee(ast::node::any_expr const& e) const noexcept
+    {
+        if (assignees.empty()) {
+            return false;
+        }
+
+        for (auto const& a : *assignees.back()) {
+            if (&a == &e) {
+                return true;
+            }
+        }
+
+        return false;
+    }
 
-    void visit_lhs_of_assign(ast::node::ufcs_invocation const& invocation) noexcept
+    void visit_lhs_of_assign(scope::func_scope const& scope, ast::node::ufcs_invocation const& invocation)
     {
         if (invocation->is_instance_var_access()) {
             if (auto const child_ufcs = get_as<ast::node::ufcs_invocation>(invocation->child)) {
-                visit_lhs_of_assign(*child_ufcs);
+                visit_lhs_of_assign(scope, *child_ufcs);
             } else if (auto const var = get_as<ast::node::var_ref>(invocation->child)) {
-                assert(!(*var)->symbol.expired());
+                if ((*var)->symbol.expired()) {
+                    // Note: Already error occurred
+                    return;
+                }
                 if ((*var)->symbol.lock()->type == scope->params[0]->type) {
-                    is_const_func = false;
+                    state_of(scope) = false;
                 }
             }
         } else {
@@ -40,105 +114,152 @@ class const_member_func_checker {
     }
 
     template<class Node>
-    void visit_lhs_of_assign(Node const&) noexcept
+    void visit_lhs_of_assign(scope::func_scope const&, Node const&) noexcept
     {
         // Note: Do nothing
     }
 
+    template<class Invocation>
+    void visit_invocation(scope::func_scope const& scope, Invocation const& invocation);
+
 public:
 
-    const_member_func_checker(decltype(scope) const& s, decltype(def) const& d) noexcept
-        : scope(s), def(d)
+    // Note:
+    // Observe the walk of symbol_analyzer
+    const_member_func_checker(scope::any_scope const& s, states_type &ss) noexcept
+        : current_scope(&s), target(boost::none), states(ss)
+    {}
+
+    // Note:
+    // Check only 'f' in its own walk
+    const_member_func_checker(scope::func_scope const& f, states_type &ss) noexcept
+        : current_scope(nullptr), target(f), states(ss)
     {
-        assert(!s->is_template());
+        assert(!f->is_template());
     }
 
-    template<class Invocation>
-    void visit_invocation(Invocation const& invocation) noexcept
+    static bool result_of(states_type const& states, scope::func_scope const& f)
     {
-        if (invocation->callee_scope.expired()) {
-            // Note: Already error occurred
-            return;
-        }
-
-        auto const callee = invocation->callee_scope.lock();
-        if (callee == scope) {
-            return;
-        }
-
-        auto const receiver = callee->resolve_receiver();
-        if (!receiver) {
-            return;
-        }
-
-        if (scope->params[0]->type != (*receiver)->type) {
-            // Note:
-            // Check if the callee function is a member function of the same class
-            // as this function's.
-            return;
-        }
-
-        if (!callee->is_const_) {
-            // Note: Not determined yet if the callee is const or not.
-            auto callee_def = callee->get_ast_node();
-            const_member_func_checker checker{callee, callee_def};
-            callee->is_const_ = checker.check_const();
+        if (!is_checked(f)) {
+            return false;
         }
 
-        is_const_func = callee->is_const();
+        auto const s = states.find(f);
+        return s == std::end(states) || s->second;
     }
 
-    template<class Walker>
-    void visit(ast::node::func_invocation const& invocation, Walker const&) noexcept
+    bool enter(ast::node::func_invocation const&)
     {
-        visit_invocation(invocation);
+        // Note:
+        // Arguments of the invocation are not checked.
+        return !checked_func();
     }
 
-    template<class Walker>
-    void visit(ast::node::ufcs_invocation const& invocation) noexcept
+    void leave(ast::node::func_invocation const& invocation)
     {
-        if (!invocation->is_instance_var_access()) {
-            visit_invocation(invocation);
+        if (auto const& f = checked_func()) {
+            visit_invocation(*f, invocation);
         }
     }
 
-    template<class Walker>
-    void visit(ast::node::assignment_stmt const& assign, Walker const& w) noexcept
+    bool enter(ast::node::assignment_stmt const& assign)
     {
-        for (auto const& e : assign->assignees) {
-            apply_lambda(
-                    [this](auto const& node){ visit_lhs_of_assign(node); }
-                    , e
-                );
-        }
-
-        w(assign->rhs_exprs);
+        assignees.push_back(&assign->assignees);
+        return true;
     }
 
-    template<class Node, class Walker>
-    void visit(Node const&, Walker const& w) noexcept
+    void leave(ast::node::assignment_stmt const& assign)
     {
-        if (!is_const_func) {
-            // Note: Already it resulted in non-const function.
-            return;
+        assignees.pop_back();
+
+        if (auto const& f = checked_func()) {
+            for (auto const& e : assign->assignees) {
+                apply_lambda(
+                        [this, &f](auto const& node){ visit_lhs_of_assign(*f, node); }
+                        , e
+                    );
+            }
         }
-        w();
     }
 
-    bool check_const() noexcept
+    bool enter(ast::node::any_expr const& e)
     {
-        assert(!scope->is_const_);
-        if (!scope->is_member_func || scope->is_ctor()) {
+        auto const& f = checked_func();
+        if (!f) {
+            return true;
+        }
+
+        if (is_assignee(e)) {
+            // Note: lhs of assignment is checked in leave()
             return false;
         }
-        assert(!scope->params.empty());
 
-        is_const_func = true;
-        ast::walk_topdown(def, *this);
-        return is_const_func;
+        // Note: Already it resulted in non-const function.
+        return state_of(*f);
+    }
+
+    template<class Node>
+    bool enter(Node const&)
+    {
+        auto const& f = checked_func();
+        return !f || state_of(*f);
     }
+
+    template<class Node>
+    void leave(Node const&) noexcept
+    {}
 };
 
+inline bool check_const_member_func(scope::func_scope const& func)
+{
+    if (!func->is_member_func || func->is_ctor()) {
+        return false;
+    }
+
+    const_member_func_checker::states_type states;
+    const_member_func_checker checker{func, states};
+    auto passes = ast::fuse_passes(checker);
+    auto def = func->get_ast_node();
+    ast::walk_topdown(def, passes);
+
+    return const_member_func_checker::result_of(states, func);
+}
+
+template<class Invocation>
+void const_member_func_checker::visit_invocation(scope::func_scope const& scope, Invocation const& invocation)
+{
+    if (invocation->callee_scope.expired()) {
+        // Note: Already error occurred
+        return;
+    }
+
+    auto const callee = invocation->callee_scope.lock();
+    if (callee == scope) {
+        return;
+    }
+
+    auto const receiver = callee->resolve_receiver();
+    if (!receiver) {
+        return;
+    }
+
+    if (scope->params[0]->type != (*receiver)->type) {
+        // Note:
+        // Check if the callee function is a member function of the same class
+        // as this function's.
+        return;
+    }
+
+    if (!callee->is_const_) {
+        // Note: Not determined yet if the callee is const or not.
+        callee->is_const_ = check_const_member_func(callee);
+    }
+
+    if (!callee->is_const()) {
+        state_of(scope) = false;
+    }
+}
+
 class const_func_invocation_checker {
     boost::optional<symbol::var_symbol> result = boost::none;
 
@@ -6,6 +6,7 @@
 #include <unordered_set>
 #include <cstddef>
 #include <cassert>
+#include <iostream>
 
 #include <boost/format.hpp>
 #include <boost/algorithm/string/predicate.hpp>
@@ -39,6 +40,7 @@ class forward_symbol_analyzer {
 
     scope::any_scope current_scope;
     syntax::importer &importer;
+    std::ostream &diagnostics;
 
     // Introduce a new scope and ensure to restore the old scope
     // after the visit process
@@ -54,18 +56,24 @@ class forward_symbol_analyzer {
     template<class Node, class Message>
     void semantic_error(Node const& n, Message const& msg) noexcept
     {
-        output_semantic_error(n, msg);
+        output_semantic_error(n, msg, diagnostics);
         failed++;
     }
 
-    std::string get_lambda_name(ast::node::lambda_expr const& lambda) const noexcept
+    // Note:
+    // The name is built from the raw location.  Resolving the line and the column would
+    // lock the source file registry and read the file of a module restored from the cache.
+    // The name is unique to the compilation.  So it is not interned.
+    helper::identifier get_lambda_name(ast::node::lambda_expr const& lambda) const
     {
         auto const& l = lambda->location;
-        return "lambda."
-            + std::to_string(l.line)
-            + '.' + std::to_string(l.col)
-            + '.' + std::to_string(l.length)
-            + '.' + helper::hex_string_of_ptr(lambda->def.get());
+        return helper::identifier::unique(
+                "lambda."
+                + std::to_string(l.file)
+                + '.' + std::to_string(l.offset)
+                + '.' + std::to_string(l.length)
+                + '.' + helper::hex_string_of_ptr(lambda->def.get())
+            );
     }
 
     template<class Predicate>
@@ -93,6 +101,7 @@ class forward_symbol_analyzer {
                                 "  In %1%, '%2%' is redefined.\n"
                                 "  Note: Previous definition is at %3%"
                             ) % situation % (*right)->to_string() % lhs_def->location
+                            , diagnostics
                         );
                     failed++;
                 }
@@ -116,6 +125,7 @@ class forward_symbol_analyzer {
                                 "  Class '%1%' is redefined.\n"
                                 "  Note: Previous definition is at %2%"
                             ) % (*right)->name % (*left)->location
+                            , diagnostics
                         );
                     failed++;
                 }
@@ -157,7 +167,8 @@ class forward_symbol_analyzer {
             {
                 output_semantic_error(
                         f->get_ast_node(),
-                        "  Operator '" + f->name + "' must have just " + msg
+                        "  Operator '" + f->name + "' must have just " + msg,
+                        diagnostics
                     );
                 ++failed;
             };
@@ -189,7 +200,8 @@ class forward_symbol_analyzer {
             {
                 output_semantic_error(
                         f->get_ast_node(),
-                        std::forward<decltype(msg)>(msg)
+                        std::forward<decltype(msg)>(msg),
+                        diagnostics
                     );
                 ++failed;
             };
@@ -240,6 +252,7 @@ class forward_symbol_analyzer {
                         ) % r->params[0]->type.to_string()
                           % r->ret_type->to_string()
                           % ldef->location
+                        , diagnostics
                     );
                     ++failed;
                 }
@@ -355,8 +368,8 @@ public:
     size_t failed;
 
     template<class Scope>
-    forward_symbol_analyzer(Scope const& s, syntax::importer &i) noexcept
-        : current_scope(s), importer(i), failed(0)
+    forward_symbol_analyzer(Scope const& s, syntax::importer &i, std::ostream &d = std::cerr) noexcept
+        : current_scope(s), importer(i), diagnostics(d), failed(0)
     {}
 
     scope::class_scope define_new_class(ast::node::class_definition const& c, scope::global_scope const& global)
@@ -594,7 +607,7 @@ public:
                 = type::make<type::template_type>(decl);
         }
 
-        if (!scope->define_variable(new_var)) {
+        if (!scope->define_variable(new_var, diagnostics)) {
             failed++;
         }
 
@@ -690,7 +703,7 @@ public:
         auto const new_param_sym =
             symbol::make<symbol::var_symbol>(
                 param,
-                param->name == "_" ? std::to_string(reinterpret_cast<size_t>(param.get())) : param->name,
+                param->name == "_" ? helper::identifier::unique(std::to_string(reinterpret_cast<size_t>(param.get()))) : param->name,
                 !param->is_var
             );
         param->param_symbol = new_param_sym;
@@ -733,7 +746,7 @@ public:
                 new_param_sym->type = param->type;
             }
 
-            if (!func->define_param(new_param_sym)) {
+            if (!func->define_param(new_param_sym, diagnostics)) {
                 failed++;
                 return;
             }
@@ -769,7 +782,7 @@ public:
         for (auto const& i : for_->iter_vars) {
             assert(i->param_symbol.expired());
             auto const sym = get_param_sym(i);
-            if (!child_scope->define_variable(sym)) {
+            if (!child_scope->define_variable(sym, diagnostics)) {
                 failed++;
                 return;
             }
@@ -999,10 +1012,10 @@ public:
 } // namespace detail
 
 template<class Node, class Scope>
-std::size_t dispatch_forward_analyzer(Node &node, Scope const& scope_root, syntax::importer &i)
+std::size_t dispatch_forward_analyzer(Node &node, Scope const& scope_root, syntax::importer &i, std::ostream &diagnostics = std::cerr)
 {
     // Generate scope tree
-    detail::forward_symbol_analyzer forward_resolver{scope_root, i};
+    detail::forward_symbol_analyzer forward_resolver{scope_root, i, diagnostics};
     ast::walk_topdown(node, forward_resolver);
 
     return forward_resolver.failed;
@@ -5,6 +5,7 @@
 #include <memory>
 #include <unordered_map>
 #include <string>
+#include <vector>
 
 #include <boost/variant/static_visitor.hpp>
 #include <boost/variant/apply_visitor.hpp>
@@ -12,6 +13,7 @@
 #include "dachs/fatal.hpp"
 #include "dachs/ast/ast.hpp"
 #include "dachs/ast/ast_walker.hpp"
+#include "dachs/ast/pass_fusion.hpp"
 #include "dachs/semantics/symbol.hpp"
 #include "dachs/semantics/scope.hpp"
 #include "dachs/semantics/type.hpp"
@@ -84,8 +86,11 @@ struct capture_checker : boost::static_visitor<bool> {
     }
 };
 
+// Note:
+// Pass to collect the symbols captured by a lambda.  The symbols referred from the lambda
+// are replaced with the accesses to the lambda object by lambda_capture_replacer in the same walk.
 class lambda_capture_resolver {
-    captured_offset_map captures;
+    std::vector<lambda_capture> captures;
     scope::func_scope const& lambda_scope;
     size_t offset;
     scope::any_scope current_scope;
@@ -118,30 +123,26 @@ class lambda_capture_resolver {
         new_invocation->set_source_location(*var);
         new_invocation->type = symbol->type;
 
-        auto const result = captures.insert({new_invocation, offset, symbol});
-        assert(result.second);
-        (void) result;
+        captures.push_back({new_invocation, offset, symbol});
 
         ++offset;
         return new_invocation;
     }
 
-    template<class S, class W>
-    void with_scope(std::weak_ptr<S> const& ws, W const& w)
+    std::vector<scope::any_scope> saved_scopes;
+
+    template<class S>
+    void enter_scope(std::weak_ptr<S> const& ws)
     {
-        auto const tmp = current_scope;
+        saved_scopes.push_back(current_scope);
         current_scope = ws.lock();
-        w();
-        current_scope = tmp;
     }
 
-    template<class S, class W>
-    void with_scope(std::shared_ptr<S> const& ss, W const& w)
+    void leave_scope()
     {
-        auto const tmp = current_scope;
-        current_scope = ss;
-        w();
-        current_scope = tmp;
+        assert(!saved_scopes.empty());
+        current_scope = std::move(saved_scopes.back());
+        saved_scopes.pop_back();
     }
 
     symbol::var_symbol get_symbol_from_var(ast::node::var_ref const& var)
@@ -152,10 +153,10 @@ class lambda_capture_resolver {
             // it is never analyzed by symbol_analyzer and the
             // variable symbol is expired.
 
-            auto name = var->name;
-            if (name.back() == '!') {
-                name.pop_back();
-            }
+            auto const name
+                = var->name.back() == '!'
+                    ? helper::identifier{var->name.substr(0u, var->name.size() - 1u)}
+                    : var->name;
 
             auto const maybe_var_symbol = boost::apply_visitor(scope::var_symbol_resolver{name}, current_scope);
             if (!maybe_var_symbol) {
@@ -183,39 +184,58 @@ public:
         : captures(), lambda_scope(s), offset(0u), current_scope(current), receiver_symbol(r)
     {}
 
-    auto get_captures() const
+    // Note:
+    // Captured symbols and the accesses introduced for them, found so far
+    std::unordered_map<symbol::var_symbol, ast::node::ufcs_invocation> const& get_captured_symbols() const noexcept
     {
-        return captures;
+        return sym_map;
+    }
+
+    // Note:
+    // Build the table of the captures after the walk finished
+    captured_offset_map get_captures() &&
+    {
+        return captured_offset_map{std::move(captures)};
     }
 
-    template<class Walker>
-    void visit(ast::node::statement_block const& b, Walker const& w)
+    bool enter(ast::node::statement_block const& b)
     {
-        with_scope(b->scope, w);
+        enter_scope(b->scope);
+        return true;
     }
 
-    template<class Walker>
-    void visit(ast::node::block_expr const& b, Walker const& w)
+    void leave(ast::node::statement_block const&)
     {
-        with_scope(b->scope, w);
+        leave_scope();
     }
 
-    template<class Walker>
-    void visit(ast::node::lambda_expr const& lambda, Walker const&)
+    bool enter(ast::node::block_expr const& b)
+    {
+        enter_scope(b->scope);
+        return true;
+    }
+
+    void leave(ast::node::block_expr const&)
+    {
+        leave_scope();
+    }
+
+    bool enter(ast::node::lambda_expr const& lambda)
     {
         // Note:
         // Update symbols in lambda object instantiation
 
         assert(!lambda->type || type::is_a<type::generic_func_type>(lambda->type));
-        ast::walk_topdown(lambda->receiver, *this);
+        auto passes = ast::fuse_passes(*this);
+        ast::walk_topdown(lambda->receiver, passes);
+        return true;
     }
 
-    template<class Walker>
-    void visit(ast::node::var_ref const& var, Walker const& w)
+    bool enter(ast::node::var_ref const& var)
     {
         auto const symbol = get_symbol_from_var(var);
         if (!symbol) {
-            return;
+            return false;
         }
 
         if (symbol->is_builtin ||
@@ -224,31 +244,32 @@ public:
                 helper::exists(sym_map, symbol)) {
             // Note:
             // 1 ufcs_invocation instance per 1 captured symbol.
-            return;
+            return false;
         }
 
         sym_map[symbol] = generate_invocation_from(var, symbol);
 
-        w();
+        return true;
     }
 
-    template<class Node, class Walker>
-    void visit(Node const&, Walker const& w)
+    template<class Node>
+    bool enter(Node const&) noexcept
     {
-        w();
+        return true;
     }
-};
 
-template<class Node>
-captured_offset_map resolve_lambda_captures(Node &search_root, scope::func_scope const& lambda_scope, symbol::var_symbol const& receiver)
-{
-    lambda_capture_resolver resolver{lambda_scope, receiver};
-    ast::walk_topdown(search_root, resolver);
-    return resolver.get_captures();
-}
+    template<class Node>
+    void leave(Node const&) noexcept
+    {}
+};
 
+// Note:
+// Pass to replace the symbols captured by a lambda with the accesses to the lambda object.
+// It must be registered after lambda_capture_resolver to see the captures found in the
+// same walk.  This pass assumes that the walked nodes are already analyzed.  All symbols
+// and types should be resolved normally.
 class lambda_capture_replacer {
-    captured_offset_map const& captures;
+    std::unordered_map<symbol::var_symbol, ast::node::ufcs_invocation> const& captures;
 
 public:
 
@@ -256,74 +277,44 @@ public:
         : captures(cs)
     {}
 
-    template<class Walker>
-    void visit(ast::node::lambda_expr const& lambda, Walker const&)
+    bool enter(ast::node::lambda_expr const& lambda)
     {
-        ast::walk_topdown(lambda->receiver, *this);
+        auto passes = ast::fuse_passes(*this);
+        ast::walk_topdown(lambda->receiver, passes);
+        return true;
     }
 
-    template<class Walker>
-    void visit(ast::node::any_expr &e, Walker const& w)
+    template<class Node>
+    bool enter(Node const&) noexcept
+    {
+        return true;
+    }
+
+    void leave(ast::node::any_expr &e)
     {
         auto const maybe_var_ref = get_as<ast::node::var_ref>(e);
         if (!maybe_var_ref) {
-            w();
             return;
         }
 
-        auto const& symbol = (*maybe_var_ref)->symbol.lock();
-        auto const& indexed = captures.get<tags::refered_symbol>();
-        auto const capture = indexed.find(symbol);
-        if (capture != boost::end(indexed)) {
-            e = capture->introduced;
+        auto const capture = captures.find((*maybe_var_ref)->symbol.lock());
+        if (capture != std::end(captures)) {
+            e = capture->second;
         }
     }
 
-    template<class Node, class Walker>
-    void visit(Node const&, Walker const& w)
-    {
-        w();
-    }
+    template<class Node>
+    void leave(Node const&) noexcept
+    {}
 };
 
 // Note:
-// This function assumes that 'search_root' and its children are already analyzed.
-// All symbols and types should be resolved normally.
-template<class Node>
-void resolve_lambda_capture_access(Node &search_root, captured_offset_map const& captures)
-{
-    lambda_capture_replacer replacer{captures};
-    ast::walk_topdown(search_root, replacer);
-}
-
+// Resolve the captures of lambdas.  The body of a lambda is walked once.  The walk resolves
+// nested lambdas at first, then collects the captures and replaces the accesses to them
+// (lambda_capture_resolver and lambda_capture_replacer).
 class lambda_resolver {
     lambda_captures_type captures;
 
-    template<class Node>
-    void walk_recursively(Node &n)
-    {
-        ast::walk_topdown(n, *this);
-    }
-
-    symbol::var_symbol resolve_lambda_capture_map(ast::node::function_definition &func_def, type::generic_func_type const& lambda_type)
-    {
-        assert(!func_def->scope.expired());
-        auto const func_scope = func_def->scope.lock();
-
-        // Note:
-        //  1. Lambda function takes its lambda object (captured values) as 1st parameter
-        //  2. Analyze captures for the lambda function and return it to register
-
-        auto const lambda_object_sym = symbol::make<symbol::var_symbol>(nullptr, "lambda.receiver", /*immutable*/true /*TODO*/);
-        lambda_object_sym->type = lambda_type;
-
-        auto const capture_map = resolve_lambda_captures(func_def, func_scope, lambda_object_sym);
-
-        captures[lambda_type] = capture_map;
-
-        return lambda_object_sym;
-    }
-
     void set_lambda_receiver(type::generic_func_type const& lambda_type, ast::node::lambda_expr const& lambda)
     {
         // XXX:
@@ -344,11 +335,14 @@ class lambda_resolver {
             return;
         }
 
-        auto const receiver_type = *type::get<type::tuple_type>(lambda->receiver->type);
+        // Note:
+        // Make a new type for the receiver because the type of empty tuple is interned.
+        auto const receiver_type = type::make<type::tuple_type>();
+        lambda->receiver->type = receiver_type;
 
         // Note:
         // Substitute captured values as its fields
-        for (auto const& c : capture->second.template get<semantics::tags::offset>()) {
+        for (auto const& c : capture->second) {
             auto const& s = c.refered_symbol;
             auto const new_var_ref = ast::make<ast::node::var_ref>(s->name);
             new_var_ref->symbol = c.refered_symbol;
@@ -371,14 +365,25 @@ class lambda_resolver {
         scope->force_push_front_param(receiver_sym);
     }
 
-    template<class LambdaDef, class LambdaType>
-    void resolve_lambda(LambdaDef &l, LambdaType const& t)
+    void resolve_lambda(ast::node::function_definition &l, type::generic_func_type const& t)
     {
-        walk_recursively(l);
+        assert(!l->scope.expired());
+        auto const func_scope = l->scope.lock();
+
+        // Note:
+        //  1. Lambda function takes its lambda object (captured values) as 1st parameter
+        //  2. Analyze captures for the lambda function and register them
 
-        auto const receiver = resolve_lambda_capture_map(l, t);
+        auto const receiver = symbol::make<symbol::var_symbol>(nullptr, "lambda.receiver", /*immutable*/true /*TODO*/);
+        receiver->type = t;
+
+        lambda_capture_resolver capture_resolver{func_scope, receiver};
+        lambda_capture_replacer replacer{capture_resolver.get_captured_symbols()};
+        auto passes = ast::fuse_passes(*this, capture_resolver, replacer);
+        ast::walk_topdown(l, passes);
+
+        captures[t] = std::move(capture_resolver).get_captures();
         set_lambda_receiver(l, receiver);
-        resolve_lambda_capture_access(l, captures.at(t));
     }
 
 public:
@@ -393,8 +398,7 @@ public:
         return std::move(captures);
     }
 
-    template<class Walker>
-    void visit(ast::node::lambda_expr &lambda, Walker const&)
+    void resolve(ast::node::lambda_expr &lambda)
     {
         auto &def = lambda->def;
         assert(type::is_a<type::generic_func_type>(lambda->type));
@@ -417,11 +421,24 @@ public:
         set_lambda_receiver(type, lambda);
     }
 
-    template<class Node, class Walker>
-    void visit(Node &, Walker const& w)
+    bool enter(ast::node::lambda_expr &lambda)
+    {
+        // Note:
+        // Nested lambda must be resolved before collecting captures of the enclosing lambda
+        // because captures of the nested lambda may be also captured by the enclosing one.
+        resolve(lambda);
+        return true;
+    }
+
+    template<class Node>
+    bool enter(Node const&) noexcept
     {
-        w();
+        return true;
     }
+
+    template<class Node>
+    void leave(Node const&) noexcept
+    {}
 };
 
 
@@ -0,0 +1,296 @@
+#if !defined DACHS_SEMANTICS_REACHABILITY_HPP_INCLUDED
+#define      DACHS_SEMANTICS_REACHABILITY_HPP_INCLUDED
+
+#include <memory>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/variant/static_visitor.hpp>
+
+#include "dachs/ast/ast.hpp"
+#include "dachs/ast/ast_walker.hpp"
+#include "dachs/ast/pass_fusion.hpp"
+#include "dachs/semantics/scope.hpp"
+#include "dachs/semantics/type.hpp"
+#include "dachs/helper/util.hpp"
+
+namespace dachs {
+namespace semantics {
+namespace detail {
+
+// Note:
+// Collect the functions referred from generic function types in a type.
+// e.g. (int, func(foo))  ->  foo
+struct referred_func_in_type_collector : boost::static_visitor<void> {
+    std::vector<scope::func_scope> &found;
+
+    explicit referred_func_in_type_collector(std::vector<scope::func_scope> &f) noexcept
+        : found(f)
+    {}
+
+    void visit(type::type const& t)
+    {
+        if (t) {
+            t.apply_visitor(*this);
+        }
+    }
+
+    void operator()(type::generic_func_type const& g)
+    {
+        if (g->ref) {
+            if (auto const f = g->ref->lock()) {
+                found.push_back(f);
+            }
+        }
+    }
+
+    void operator()(type::tuple_type const& t)
+    {
+        for (auto const& e : t->element_types) {
+            visit(e);
+        }
+    }
+
+    void operator()(type::class_type const& t)
+    {
+        for (auto const& p : t->param_types) {
+            visit(p);
+        }
+    }
+
+    void operator()(type::array_type const& t)
+    {
+        visit(t->element_type);
+    }
+
+    void operator()(type::pointer_type const& t)
+    {
+        visit(t->pointee_type);
+    }
+
+    void operator()(type::qualified_type const& t)
+    {
+        visit(t->contained_type);
+    }
+
+    template<class T>
+    void operator()(T const&)
+    {}
+};
+
+// Note:
+// Pass to collect the functions referred from analyzed nodes.  Functions are referred
+// by the callee scopes which symbol_analyzer resolved, and by the types of expressions
+// (function references and lambdas).
+class referred_func_collector {
+    std::vector<scope::func_scope> &found;
+
+    void add(scope::weak_func_scope const& w)
+    {
+        if (auto const f = w.lock()) {
+            found.push_back(f);
+        }
+    }
+
+    void add(std::vector<scope::weak_func_scope> const& ws)
+    {
+        for (auto const& w : ws) {
+            add(w);
+        }
+    }
+
+    void add(std::vector<std::vector<scope::weak_func_scope>> const& wss)
+    {
+        for (auto const& ws : wss) {
+            add(ws);
+        }
+    }
+
+    void add_type(type::type const& t)
+    {
+        referred_func_in_type_collector collector{found};
+        collector.visit(t);
+    }
+
+    template<class Node>
+    void add_callees(Node const&)
+    {}
+
+    void add_callees(ast::node::func_invocation const& n)
+    {
+        add(n->callee_scope);
+    }
+
+    void add_callees(ast::node::ufcs_invocation const& n)
+    {
+        add(n->callee_scope);
+    }
+
+    void add_callees(ast::node::unary_expr const& n)
+    {
+        add(n->callee_scope);
+    }
+
+    void add_callees(ast::node::binary_expr const& n)
+    {
+        add(n->callee_scope);
+    }
+
+    void add_callees(ast::node::index_access const& n)
+    {
+        add(n->callee_scope);
+    }
+
+    void add_callees(ast::node::object_construct const& n)
+    {
+        add(n->callee_ctor_scope);
+    }
+
+    void add_callees(ast::node::array_literal const& n)
+    {
+        add(n->callee_ctor_scope);
+    }
+
+    void add_callees(ast::node::string_literal const& n)
+    {
+        add(n->callee_ctor_scope);
+    }
+
+    void add_callees(ast::node::switch_expr const& n)
+    {
+        add(n->when_callee_scopes);
+    }
+
+    void add_callees(ast::node::switch_stmt const& n)
+    {
+        add(n->when_callee_scopes);
+    }
+
+    void add_callees(ast::node::assignment_stmt const& n)
+    {
+        add(n->callee_scopes);
+    }
+
+    void add_callees(ast::node::parameter const& n)
+    {
+        add_type(n->type);
+    }
+
+    void add_callees(ast::node::cast_expr const& n)
+    {
+        add(n->callee_cast_scope);
+        add(n->casted_func_scope);
+    }
+
+    void add_callees(ast::node::for_stmt const& n)
+    {
+        add(n->index_callee_scope);
+        add(n->size_callee_scope);
+    }
+
+    template<class T>
+    void add_expr_type(std::shared_ptr<T> const& n, std::true_type)
+    {
+        add_type(n->type);
+    }
+
+    template<class T>
+    void add_expr_type(std::shared_ptr<T> const&, std::false_type)
+    {}
+
+public:
+
+    explicit referred_func_collector(std::vector<scope::func_scope> &f) noexcept
+        : found(f)
+    {}
+
+    bool enter(ast::node::lambda_expr const& lambda)
+    {
+        add_type(lambda->type);
+
+        // Note:
+        // The walker doesn't visit the children of lambda_expr.  Its definition is walked
+        // as a function.  Only the captured values in its receiver are walked here.
+        auto passes = ast::fuse_passes(*this);
+        ast::walk_topdown(lambda->receiver, passes);
+        return true;
+    }
+
+    template<class T>
+    bool enter(std::shared_ptr<T> const& n)
+    {
+        add_callees(n);
+        add_expr_type(n, std::is_base_of<ast::node_type::expression, T>{});
+        return true;
+    }
+
+    template<class Node>
+    bool enter(Node const&) noexcept
+    {
+        return true;
+    }
+
+    template<class Node>
+    void leave(Node const&) noexcept
+    {}
+};
+
+// Note:
+// Collect the functions referred from the nodes (e.g. initializers of global constants).
+template<class Nodes>
+std::vector<scope::func_scope> collect_referred_funcs(Nodes &nodes)
+{
+    std::vector<scope::func_scope> found;
+    referred_func_collector collector{found};
+    auto passes = ast::fuse_passes(collector);
+    for (auto &n : nodes) {
+        ast::walk_topdown(n, passes);
+    }
+    return found;
+}
+
+// Note:
+// Add the functions reachable from 'roots' through the call graph to 'reached'.
+// 'on_reached' is called with the definition of each newly reached function before its
+// body is walked.  It can analyze the body (e.g. when the body is not analyzed yet) to
+// resolve the functions referred from it.
+// Templates are never walked.  Their instantiations are referred directly.
+template<class OnReached>
+void collect_reachable_funcs(
+        std::vector<scope::func_scope> &&roots,
+        std::unordered_set<scope::func_scope> &reached,
+        OnReached const& on_reached
+    )
+{
+    auto worklist = std::move(roots);
+    referred_func_collector collector{worklist};
+    auto passes = ast::fuse_passes(collector);
+
+    while (!worklist.empty()) {
+        auto const f = std::move(worklist.back());
+        worklist.pop_back();
+
+        if (!reached.insert(f).second) {
+            continue;
+        }
+
+        if (f->is_builtin || f->is_template()) {
+            continue;
+        }
+
+        auto def = f->get_ast_node();
+        if (!def) {
+            continue;
+        }
+
+        on_reached(def);
+        ast::walk_topdown(def, passes);
+    }
+}
+
+} // namespace detail
+} // namespace semantics
+} // namespace dachs
+
+#endif    // DACHS_SEMANTICS_REACHABILITY_HPP_INCLUDED
@@ -5,6 +5,7 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <algorithm>
+#include <mutex>
 
 #include <boost/algorithm/cxx11/all_of.hpp>
 #include <boost/range/adaptor/transformed.hpp>
@@ -30,7 +31,7 @@ using boost::algorithm::all_of;
 using std::size_t;
 
 
-void basic_scope::warn_or_check_shadowing_var_recursively(maybe_var_t const& maybe_shadowing, symbol::var_symbol const& new_var) const
+void basic_scope::warn_or_check_shadowing_var_recursively(maybe_var_t const& maybe_shadowing, symbol::var_symbol const& new_var, std::ostream &diagnostics) const
 {
     if (maybe_shadowing) {
         auto const the_node = new_var->ast_node.get_shared();
@@ -40,29 +41,35 @@ void basic_scope::warn_or_check_shadowing_var_recursively(maybe_var_t const& may
             output_warning(the_node, boost::format(
                             "  Shadowing variable '%1%'. It shadows a variable at %2%"
                         ) % new_var->name % prev_node->location
-                    );
+                    , diagnostics
+                );
         } else {
             output_warning(the_node, boost::format(
                             "  Shadowing variable '%1%'. It shadows a built-in variable"
                         ) % new_var->name
-                    );
+                    , diagnostics
+                );
         }
     } else {
-        apply_lambda(
-            [&new_var](auto const& s){ s.lock()->check_shadowing_variable(new_var); },
-            enclosing_scope
-        );
+        assert(parent);
+        parent->check_shadowing_variable(new_var, diagnostics);
     }
 }
 
-void basic_scope::check_shadowing_variable(symbol::var_symbol const& new_var) const
+void basic_scope::check_shadowing_variable(symbol::var_symbol const& new_var, std::ostream &diagnostics) const
+{
+    assert(parent);
+    parent->check_shadowing_variable(new_var, diagnostics);
+}
+
+global_scope &basic_scope::get_root() noexcept
 {
-    apply_lambda(
-        [&new_var](auto const& s)
-        {
-            s.lock()->check_shadowing_variable(new_var);
-        }, enclosing_scope
-    );
+    auto *s = this;
+    while (s->parent) {
+        s = s->parent;
+    }
+    assert(dynamic_cast<global_scope *>(s));
+    return static_cast<global_scope &>(*s);
 }
 
 namespace detail {
@@ -207,7 +214,7 @@ get_overloaded_function_score(FuncScope const& func, ArgTypes const& arg_types)
 }
 
 template<class Funcs, class Types>
-auto generate_first_overload_set(Funcs const& candidates, std::string const& name, Types const& arg_types)
+auto generate_first_overload_set(Funcs const& candidates, helper::identifier const& name, Types const& arg_types)
 {
     std::vector<std::tuple<
         size_t, // matching score score
@@ -260,7 +267,7 @@ void narrow_down_score_by(Scores &scores) {
 }
 
 template<class Funcs, class Types>
-auto generate_overload_set(Funcs const& candidates, std::string const& name, Types const& arg_types)
+auto generate_overload_set(Funcs const& candidates, helper::identifier const& name, Types const& arg_types)
 {
     auto candidate_scores = generate_first_overload_set(candidates, name, arg_types);
 
@@ -284,7 +291,7 @@ auto generate_overload_set(Funcs const& candidates, std::string const& name, Typ
 }
 
 template<class Funcs, class Types>
-inline function_set get_overloaded_function(Funcs const& candidates, std::string const& name, Types const& arg_types)
+inline function_set get_overloaded_function(Funcs const& candidates, helper::identifier const& name, Types const& arg_types)
 {
     return generate_overload_set(candidates, name, arg_types);
 }
@@ -298,12 +305,42 @@ void global_scope::define_function(scope::func_scope const& new_func) noexcept
         cast_funcs.push_back(new_func);
     } else {
         functions.push_back(new_func);
+        function_index[new_func->name].push_back(new_func);
+        std::lock_guard<std::mutex> lock{resolution_cache_mutex};
+        resolution_cache.clear();
     }
 }
 
-function_set global_scope::resolve_func(std::string const& name, std::vector<type::type> const& arg_types) const
+void global_scope::define_class(scope::class_scope const& new_class) noexcept
+{
+    classes.push_back(new_class);
+    class_table.emplace(new_class->name, new_class);
+}
+
+function_set global_scope::resolve_func(helper::identifier const& name, std::vector<type::type> const& arg_types) const
 {
-    return detail::get_overloaded_function(functions, name, arg_types);
+    auto const same_name_funcs = function_index.find(name);
+    if (same_name_funcs == std::end(function_index)) {
+        return {};
+    }
+
+    if (!all_of(arg_types, [](auto const& t){ return type::is_interned(t); })) {
+        return detail::get_overloaded_function(same_name_funcs->second, name, arg_types);
+    }
+
+    resolution_key key{name, arg_types};
+    {
+        std::lock_guard<std::mutex> lock{resolution_cache_mutex};
+        auto const memoized = resolution_cache.find(key);
+        if (memoized != std::end(resolution_cache)) {
+            return memoized->second;
+        }
+    }
+
+    auto result = detail::get_overloaded_function(same_name_funcs->second, name, arg_types);
+    std::lock_guard<std::mutex> lock{resolution_cache_mutex};
+    resolution_cache.emplace(std::move(key), result);
+    return result;
 }
 
 global_scope::maybe_func_t global_scope::resolve_cast_func(type::type const& from, type::type const& to) const
@@ -326,7 +363,7 @@ global_scope::maybe_func_t global_scope::resolve_cast_func(type::type const& fro
     return result;
 }
 
-global_scope::maybe_class_t global_scope::resolve_class_template(std::string const& name, std::vector<type::type> const& specified) const
+global_scope::maybe_class_t global_scope::resolve_class_template(helper::identifier const& name, std::vector<type::type> const& specified) const
 {
     auto const c = resolve_class_by_name(name);
     if (!c || !(*c)->is_template()) {
@@ -440,7 +477,7 @@ std::string func_scope::to_string() const noexcept
                     params | transformed(
                         [](auto const& p)
                         {
-                            return p->name;
+                            return p->name.str();
                         }
                     ), ", "
                 )
@@ -5,6 +5,11 @@
 #include <string>
 #include <type_traits>
 #include <unordered_set>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <iostream>
+#include <utility>
 #include <cstddef>
 #include <cassert>
 
@@ -12,6 +17,7 @@
 #include <boost/format.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/cxx11/any_of.hpp>
+#include <boost/functional/hash.hpp>
 
 #include "dachs/warning.hpp"
 #include "dachs/semantics/scope_fwd.hpp"
@@ -22,13 +28,45 @@
 #include "dachs/helper/make.hpp"
 #include "dachs/helper/util.hpp"
 #include "dachs/helper/variant.hpp"
+#include "dachs/helper/identifier.hpp"
 
 namespace dachs {
 
+namespace scope_node {
+struct basic_scope;
+} // namespace scope_node
+
 // Dynamic resources to use actually
 namespace scope {
 
-using dachs::helper::make;
+// Note:
+// Owner of all nodes of one scope tree.  Every scope made with scope::make<>() is
+// registered to the arena of the root global scope and is never released until the
+// whole tree is released.  So a child can refer to its parent with a raw pointer
+// even if the parent was detached from the tree (e.g. a failed instantiation).
+// Registration is guarded by a mutex because scopes may be made while checking
+// function bodies concurrently.
+class scope_arena final {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<scope_node::basic_scope>> nodes;
+
+public:
+
+    scope_arena() = default;
+    scope_arena(scope_arena const&) = delete;
+    scope_arena &operator=(scope_arena const&) = delete;
+
+    void adopt(std::shared_ptr<scope_node::basic_scope> const& node)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        nodes.push_back(node);
+    }
+
+    std::size_t size() const noexcept
+    {
+        return nodes.size();
+    }
+};
 
 } // namespace scope
 
@@ -37,16 +75,19 @@ namespace scope_node {
 
 using dachs::helper::variant::apply_lambda;
 using function_set = std::unordered_set<scope::func_scope>;
+using symbol_table = std::unordered_map<helper::identifier, symbol::var_symbol>;
 
 struct basic_scope {
     // Note:
-    // I don't use base class pointer to check the parent is alive or not.
-    // Or should I?
+    // 'enclosing_scope' keeps the type of the parent for the passes which need it.
+    // Name resolution goes up the tree through 'parent' without locking weak pointers.
+    // The parent is kept alive by the arena of the tree (see scope::scope_arena).
     scope::enclosing_scope_type enclosing_scope;
+    basic_scope *parent = nullptr;
 
     template<class AnyScope>
-    explicit basic_scope(AnyScope const& parent) noexcept
-        : enclosing_scope(parent)
+    explicit basic_scope(AnyScope const& p) noexcept
+        : enclosing_scope(p), parent(pointer_of(p))
     {}
 
     basic_scope() noexcept
@@ -59,17 +100,34 @@ struct basic_scope {
     using maybe_class_t = boost::optional<scope::class_scope>;
     using maybe_var_t = boost::optional<symbol::var_symbol>;
 
+    template<class Scope>
+    static basic_scope *pointer_of(std::shared_ptr<Scope> const& s) noexcept
+    {
+        return s.get();
+    }
+
+    template<class... Scopes>
+    static basic_scope *pointer_of(boost::variant<Scopes...> const& s) noexcept
+    {
+        return apply_lambda([](auto const& p) -> basic_scope * { return p.get(); }, s);
+    }
+
+    global_scope &get_root() noexcept;
+
+    // Note:
+    // Errors are reported to 'diagnostics'.  The analyzer passes its own stream so that
+    // errors in function bodies checked in parallel are buffered per function.
     template<class Symbol>
-    bool define_symbol(std::vector<Symbol> &container, Symbol const& symbol)
+    bool define_symbol(std::vector<Symbol> &container, Symbol const& symbol, std::ostream &diagnostics = std::cerr)
     {
         if (boost::algorithm::starts_with(symbol->name, "__builtin_")) {
-            semantics::output_semantic_error(symbol->ast_node.get_shared(), "  '__builtin_' prefix is only permitted for built-in names");
+            semantics::output_semantic_error(symbol->ast_node.get_shared(), "  '__builtin_' prefix is only permitted for built-in names", diagnostics);
             return false;
         }
 
         static_assert(std::is_base_of<symbol_node::basic_symbol, typename Symbol::element_type>::value, "define_symbol(): Not a symbol");
         if (auto maybe_duplication = helper::find_if(container, [&symbol](auto const& s){ return *symbol == *s; })) {
-            semantics::print_duplication_error(symbol->ast_node.get_shared(), (*maybe_duplication)->ast_node.get_shared(), symbol->name);
+            semantics::print_duplication_error(symbol->ast_node.get_shared(), (*maybe_duplication)->ast_node.get_shared(), symbol->name, diagnostics);
             return false;
         }
 
@@ -78,59 +136,68 @@ struct basic_scope {
         return true;
     }
 
+    // Note:
+    // Define a variable symbol also to the hashed table of the container.
+    // Duplication is checked with the table instead of scanning the container.
+    bool define_symbol(std::vector<symbol::var_symbol> &container, symbol_table &table, symbol::var_symbol const& symbol, std::ostream &diagnostics = std::cerr)
+    {
+        if (boost::algorithm::starts_with(symbol->name, "__builtin_")) {
+            semantics::output_semantic_error(symbol->ast_node.get_shared(), "  '__builtin_' prefix is only permitted for built-in names", diagnostics);
+            return false;
+        }
+
+        auto const inserted = table.emplace(symbol->name, symbol);
+        if (!inserted.second) {
+            semantics::print_duplication_error(symbol->ast_node.get_shared(), inserted.first->second->ast_node.get_shared(), symbol->name, diagnostics);
+            return false;
+        }
+
+        container.push_back(symbol);
+        return true;
+    }
+
+    static maybe_var_t lookup(symbol_table const& table, helper::identifier const& name)
+    {
+        auto const found = table.find(name);
+        if (found == std::end(table)) {
+            return boost::none;
+        }
+        return found->second;
+    }
+
     // TODO resolve member variables and member functions
 
-    virtual function_set resolve_func(std::string const& name, std::vector<type::type> const& args) const
+    virtual function_set resolve_func(helper::identifier const& name, std::vector<type::type> const& args) const
     {
         // TODO:
         // resolve_func() now searches function scopes directly.
         // But it should search variables, check the result is funcref type, then resolve function overloads.
-        return apply_lambda(
-                [&](auto const& s)
-                    -> function_set
-                {
-                    return s.lock()->resolve_func(name, args);
-                }, enclosing_scope);
+        assert(parent);
+        return parent->resolve_func(name, args);
     }
 
-    virtual maybe_class_t resolve_class_by_name(std::string const& name) const
+    virtual maybe_class_t resolve_class_by_name(helper::identifier const& name) const
     {
-        return apply_lambda(
-                [&name](auto const& s)
-                    -> maybe_class_t
-                {
-                    return s.lock()->resolve_class_by_name(name);
-                }, enclosing_scope);
+        assert(parent);
+        return parent->resolve_class_by_name(name);
     }
 
-    virtual maybe_class_t resolve_class_template(std::string const& name, std::vector<type::type> const& specified) const
+    virtual maybe_class_t resolve_class_template(helper::identifier const& name, std::vector<type::type> const& specified) const
     {
-        return apply_lambda(
-                [&](auto const& s)
-                    -> maybe_class_t
-                {
-                    return s.lock()->resolve_class_template(name, specified);
-                }, enclosing_scope);
+        assert(parent);
+        return parent->resolve_class_template(name, specified);
     }
 
-    virtual maybe_var_t resolve_var(std::string const& name) const
+    virtual maybe_var_t resolve_var(helper::identifier const& name) const
     {
-        return apply_lambda(
-                [&name](auto const& s)
-                    -> maybe_var_t
-                {
-                    return s.lock()->resolve_var(name);
-                }, enclosing_scope);
+        assert(parent);
+        return parent->resolve_var(name);
     }
 
     virtual maybe_var_t resolve_receiver() const
     {
-        return apply_lambda(
-                [](auto const& s)
-                    -> maybe_var_t
-                {
-                    return s.lock()->resolve_receiver();
-                }, enclosing_scope);
+        assert(parent);
+        return parent->resolve_receiver();
     }
 
     struct enclosing_func_resolver : boost::static_visitor<maybe_func_t> {
@@ -154,8 +221,8 @@ struct basic_scope {
                 );
     }
 
-    void warn_or_check_shadowing_var_recursively(maybe_var_t const& maybe_shadowing, symbol::var_symbol const& new_var) const;
-    virtual void check_shadowing_variable(symbol::var_symbol const& new_var) const;
+    void warn_or_check_shadowing_var_recursively(maybe_var_t const& maybe_shadowing, symbol::var_symbol const& new_var, std::ostream &diagnostics) const;
+    virtual void check_shadowing_variable(symbol::var_symbol const& new_var, std::ostream &diagnostics = std::cerr) const;
 };
 
 struct global_scope final : public basic_scope {
@@ -164,6 +231,47 @@ struct global_scope final : public basic_scope {
     std::vector<scope::class_scope> classes;
     std::weak_ptr<ast::node_type::inu> ast_root;
     std::vector<scope::func_scope> cast_funcs;
+    scope::scope_arena arena;
+
+    // Note:
+    // Hashed indices of 'const_symbols' and 'classes'.  When the same name is defined
+    // twice, the first one is kept as the linear search did.
+    symbol_table const_symbol_table;
+    std::unordered_map<helper::identifier, scope::class_scope> class_table;
+
+    // Note:
+    // Functions in 'functions' indexed by their names.  Overload resolution only
+    // scores the functions which have the same name.
+    std::unordered_map<helper::identifier, std::vector<scope::func_scope>> function_index;
+
+    struct resolution_key {
+        helper::identifier name;
+        std::vector<type::type> arg_types;
+
+        bool operator==(resolution_key const& rhs) const noexcept
+        {
+            return name == rhs.name && arg_types == rhs.arg_types;
+        }
+    };
+
+    struct resolution_key_hash {
+        std::size_t operator()(resolution_key const& k) const noexcept
+        {
+            auto seed = std::hash<helper::identifier>{}(k.name);
+            boost::hash_combine(seed, type::hash_types(k.arg_types));
+            return seed;
+        }
+    };
+
+    // Note:
+    // Memoized results of resolve_func().  Only the calls whose argument types are all
+    // interned are memoized.  Interned types are never modified and can't match class
+    // types or template types partially, so the result doesn't change until a new function
+    // is defined.  define_function() clears this.
+    // resolve_func() is called from some threads when function bodies are checked in parallel.
+    // So the cache is guarded by the mutex.
+    mutable std::unordered_map<resolution_key, function_set, resolution_key_hash> resolution_cache;
+    mutable std::mutex resolution_cache_mutex;
 
     template<class RootType>
     global_scope(RootType const& ast_root) noexcept
@@ -174,9 +282,9 @@ struct global_scope final : public basic_scope {
     // Check function duplication after forward analysis because of overload resolution
     void define_function(scope::func_scope const& new_func) noexcept;
 
-    bool define_variable(symbol::var_symbol const& new_var) noexcept
+    bool define_variable(symbol::var_symbol const& new_var, std::ostream &diagnostics = std::cerr) noexcept
     {
-        return define_symbol(const_symbols, new_var);
+        return define_symbol(const_symbols, const_symbol_table, new_var, diagnostics);
     }
 
     // Note:
@@ -188,32 +296,34 @@ struct global_scope final : public basic_scope {
         // The same name variable as the function can be defined now.
         // It should be detected and error should be raised.
         const_symbols.push_back(new_var);
+        const_symbol_table.emplace(new_var->name, new_var);
     }
 
-    void define_class(scope::class_scope const& new_class) noexcept
-    {
-        // Note:
-        // Do not check the duplication of class here because it will be checked after in forward analyzer.
-        classes.push_back(new_class);
-    }
+    // Note:
+    // Do not check the duplication of class here because it will be checked after in forward analyzer.
+    void define_class(scope::class_scope const& new_class) noexcept;
 
-    function_set resolve_func(std::string const& name, std::vector<type::type> const& args) const override;
+    function_set resolve_func(helper::identifier const& name, std::vector<type::type> const& args) const override;
 
     maybe_func_t resolve_cast_func(type::type const& from, type::type const& to) const;
 
-    maybe_class_t resolve_class_by_name(std::string const& name) const override
+    maybe_class_t resolve_class_by_name(helper::identifier const& name) const override
     {
-        return helper::find_if(classes, [&name](auto const& c){ return c->name == name; });
+        auto const found = class_table.find(name);
+        if (found == std::end(class_table)) {
+            return boost::none;
+        }
+        return found->second;
     }
 
-    maybe_class_t resolve_class_template(std::string const& name, std::vector<type::type> const& specified) const override;
+    maybe_class_t resolve_class_template(helper::identifier const& name, std::vector<type::type> const& specified) const override;
 
-    maybe_var_t resolve_var(std::string const& name) const override
+    maybe_var_t resolve_var(helper::identifier const& name) const override
     {
-        return helper::find_if(const_symbols, [&name](auto const& v){ return v->name == name; });
+        return lookup(const_symbol_table, name);
     }
 
-    void check_shadowing_variable(symbol::var_symbol const&) const override
+    void check_shadowing_variable(symbol::var_symbol const&, std::ostream & = std::cerr) const override
     {
         // Note:
         // Do nothing
@@ -230,6 +340,7 @@ struct local_scope final : public basic_scope {
     std::vector<scope::local_scope> children;
     std::vector<symbol::var_symbol> local_vars;
     std::vector<scope::func_scope> unnamed_funcs;
+    symbol_table local_var_table;
 
     template<class AnyScope>
     explicit local_scope(AnyScope const& enclosing) noexcept
@@ -241,15 +352,15 @@ struct local_scope final : public basic_scope {
         children.push_back(child);
     }
 
-    bool define_variable(symbol::var_symbol const& new_var) noexcept
+    bool define_variable(symbol::var_symbol const& new_var, std::ostream &diagnostics = std::cerr) noexcept
     {
-        check_shadowing_variable(new_var);
-        return define_symbol(local_vars, new_var);
+        check_shadowing_variable(new_var, diagnostics);
+        return define_symbol(local_vars, local_var_table, new_var, diagnostics);
     }
 
-    bool define_variable_without_shadowing_check(symbol::var_symbol const& new_var) noexcept
+    bool define_variable_without_shadowing_check(symbol::var_symbol const& new_var, std::ostream &diagnostics = std::cerr) noexcept
     {
-        return define_symbol(local_vars, new_var);
+        return define_symbol(local_vars, local_var_table, new_var, diagnostics);
     }
 
     bool define_unnamed_func(scope::func_scope const& new_func) noexcept
@@ -257,20 +368,15 @@ struct local_scope final : public basic_scope {
         return define_symbol(unnamed_funcs, new_func);
     }
 
-    maybe_var_t resolve_var(std::string const& name) const override
+    maybe_var_t resolve_var(helper::identifier const& name) const override
     {
-        auto const target_var = helper::find_if(local_vars, [&name](auto const& v){ return v->name == name; });
-        return target_var ?
-                *target_var :
-                apply_lambda([&name](auto const& s){ return s.lock()->resolve_var(name); }, enclosing_scope);
+        auto const target_var = lookup(local_var_table, name);
+        return target_var ? target_var : basic_scope::resolve_var(name);
     }
 
-    void check_shadowing_variable(symbol::var_symbol const& new_var) const override
+    void check_shadowing_variable(symbol::var_symbol const& new_var, std::ostream &diagnostics = std::cerr) const override
     {
-        warn_or_check_shadowing_var_recursively(
-                helper::find_if(local_vars, [&new_var](auto const& v){ return v->name == new_var->name; }),
-                new_var
-            );
+        warn_or_check_shadowing_var_recursively(lookup(local_var_table, new_var->name), new_var, diagnostics);
     }
 };
 
@@ -280,12 +386,13 @@ struct func_scope final : public basic_scope, public symbol_node::basic_symbol {
     boost::optional<type::type> ret_type;
     bool is_member_func = false;
     boost::optional<bool> is_const_ = boost::none;
+    symbol_table param_table;
 
     template<class Node, class P>
     explicit func_scope(
               Node const& n
             , P const& p
-            , std::string const& s
+            , helper::identifier const& s
             , bool const is_builtin = false
     ) noexcept
         : basic_scope(p)
@@ -299,15 +406,22 @@ struct func_scope final : public basic_scope, public symbol_node::basic_symbol {
 
     func_scope(func_scope const&) = default;
 
-    bool define_param(symbol::var_symbol const& new_var) noexcept
+    bool define_param(symbol::var_symbol const& new_var, std::ostream &diagnostics = std::cerr) noexcept
     {
-        check_shadowing_variable(new_var);
-        return define_symbol(params, new_var);
+        check_shadowing_variable(new_var, diagnostics);
+        return define_symbol(params, param_table, new_var, diagnostics);
     }
 
     void force_push_front_param(symbol::var_symbol const& new_param) noexcept
     {
         params.insert(std::begin(params), new_param);
+        param_table[new_param->name] = new_param;
+    }
+
+    void force_push_back_param(symbol::var_symbol const& new_param) noexcept
+    {
+        params.push_back(new_param);
+        param_table.emplace(new_param->name, new_param);
     }
 
     bool is_template() const noexcept
@@ -347,23 +461,15 @@ struct func_scope final : public basic_scope, public symbol_node::basic_symbol {
 
     std::string to_string() const noexcept;
 
-    maybe_var_t resolve_var(std::string const& name) const override
+    maybe_var_t resolve_var(helper::identifier const& name) const override
     {
-        auto const target_var = helper::find_if(params, [&name](auto const& v){ return v->name == name; });
-        return target_var ?
-                *target_var :
-                apply_lambda([&name](auto const& s)
-                        {
-                            return s.lock()->resolve_var(name);
-                        }, enclosing_scope);
+        auto const target_var = lookup(param_table, name);
+        return target_var ? target_var : basic_scope::resolve_var(name);
     }
 
-    void check_shadowing_variable(symbol::var_symbol const& new_var) const override
+    void check_shadowing_variable(symbol::var_symbol const& new_var, std::ostream &diagnostics = std::cerr) const override
     {
-        warn_or_check_shadowing_var_recursively(
-                helper::find_if(params, [&new_var](auto const& v){ return v->name == new_var->name; }),
-                new_var
-            );
+        warn_or_check_shadowing_var_recursively(lookup(param_table, new_var->name), new_var, diagnostics);
     }
 
     maybe_var_t resolve_receiver() const override
@@ -394,11 +500,12 @@ struct func_scope final : public basic_scope, public symbol_node::basic_symbol {
 struct class_scope final : public basic_scope, public symbol_node::basic_symbol {
     std::vector<scope::func_scope> member_func_scopes;
     std::vector<symbol::var_symbol> instance_var_symbols;
+    symbol_table instance_var_table;
 
     // std::vector<type> for instanciated types (if this isn't template, it should contains only one element)
 
     template<class Node, class Parent>
-    explicit class_scope(Node const& ast_node, Parent const& p, std::string const& name, bool const is_builtin = false) noexcept
+    explicit class_scope(Node const& ast_node, Parent const& p, helper::identifier const& name, bool const is_builtin = false) noexcept
         : basic_scope(p)
         , basic_symbol(ast_node, name, is_builtin)
     {}
@@ -409,14 +516,14 @@ struct class_scope final : public basic_scope, public symbol_node::basic_symbol
         member_func_scopes.push_back(new_func);
     }
 
-    bool define_variable(symbol::var_symbol const& new_var) noexcept
+    bool define_variable(symbol::var_symbol const& new_var, std::ostream &diagnostics = std::cerr) noexcept
     {
-        return define_symbol(instance_var_symbols, new_var);
+        return define_symbol(instance_var_symbols, instance_var_table, new_var, diagnostics);
     }
 
-    maybe_var_t resolve_instance_var(std::string const& name) const
+    maybe_var_t resolve_instance_var(helper::identifier const& name) const
     {
-        return helper::find_if(instance_var_symbols, [&name](auto const& i){ return i->name == name; });
+        return lookup(instance_var_table, name);
     }
 
     bool is_template() const noexcept
@@ -426,10 +533,11 @@ struct class_scope final : public basic_scope, public symbol_node::basic_symbol
 
     function_set resolve_ctor(std::vector<type::type> const& arg_types) const
     {
-        return resolve_func("dachs.init", arg_types);
+        static helper::identifier const ctor_name = "dachs.init";
+        return resolve_func(ctor_name, arg_types);
     }
 
-    boost::optional<size_t> get_instance_var_offset_of(std::string const& name) const noexcept
+    boost::optional<size_t> get_instance_var_offset_of(helper::identifier const& name) const noexcept
     {
         for (auto offset = 0u; offset < instance_var_symbols.size(); ++offset) {
             if (name == instance_var_symbols[offset]->name) {
@@ -459,11 +567,44 @@ struct ast;
 
 namespace scope {
 
+inline void adopt_to_arena(global_scope const&) noexcept
+{
+    // Note:
+    // The root owns the arena.  It must not be owned by itself.
+}
+
+template<class Scope>
+inline void adopt_to_arena(std::shared_ptr<Scope> const& s)
+{
+    s->get_root().arena.adopt(s);
+}
+
+// Note:
+// Make a scope node and register it to the arena of its tree.
+template<class Scope, class... Args>
+inline Scope make(Args &&... args)
+{
+    auto const s = helper::make<Scope>(std::forward<Args>(args)...);
+    adopt_to_arena(s);
+    return s;
+}
+
+// Note:
+// Return the function which contains the scope.  A function scope contains itself.
+inline boost::optional<func_scope> enclosing_func_of(any_scope const& s)
+{
+    if (auto const f = boost::get<func_scope>(&s)) {
+        return *f;
+    }
+
+    return scope_node::apply_lambda([](auto const& scope){ return scope->get_enclosing_func(); }, s);
+}
+
 struct var_symbol_resolver
     : boost::static_visitor<boost::optional<symbol::var_symbol>> {
-    std::string const& name;
+    helper::identifier const name;
 
-    explicit var_symbol_resolver(std::string const& n) noexcept
+    explicit var_symbol_resolver(helper::identifier const& n) noexcept
         : name{n}
     {}
 
@@ -42,6 +42,9 @@ using enclosing_scope_type
                         , weak_class_scope
                     >;
 
+// Note:
+// The root global scope owns the arena of all nodes in the tree (see scope::scope_arena).
+// Nodes are released all together when the last reference to the root is released.
 struct scope_tree final {
     scope::global_scope root;
 
@@ -16,10 +16,10 @@
 namespace dachs {
 namespace semantics {
 
-semantics_context analyze_semantics(ast::ast &a, syntax::importer &i)
+semantics_context analyze_semantics(ast::ast &a, syntax::importer &i, unsigned int const jobs)
 {
     auto tree = analyze_symbols_forward(a, i);
-    return check_semantics(a, tree, i);
+    return check_semantics(a, tree, i, jobs);
 
     // TODO: Get type of global function variables' type on visit node::function_definition
     // Note:
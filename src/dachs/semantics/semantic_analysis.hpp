@@ -10,7 +10,7 @@ namespace dachs {
 namespace semantics {
 
 // FIXME: argument should be const
-semantics_context analyze_semantics(ast::ast &a, syntax::importer &i);
+semantics_context analyze_semantics(ast::ast &a, syntax::importer &i, unsigned int const jobs = 1u);
 
 } // namespace semantics
 } // namespace dachs
@@ -2,58 +2,108 @@
 #define      DACHS_SEMANTICS_SEMANTICS_CONTEXT_HPP_INCLUDED
 
 #include <cstddef>
+#include <cassert>
+#include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <iostream>
 #include <utility>
 #include <string>
 
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/member.hpp>
-#include <boost/multi_index/ordered_index.hpp>
 #include <boost/optional.hpp>
 
 #include "dachs/ast/ast.hpp"
 #include "dachs/semantics/scope.hpp"
 #include "dachs/semantics/type.hpp"
 #include "dachs/semantics/symbol.hpp"
+#include "dachs/helper/util.hpp"
 
 namespace dachs {
 namespace semantics {
 
-namespace tags {
-
-struct offset{};
-struct introduced{};
-struct refered_symbol{};
-
-} // namespace tags
-
 struct lambda_capture {
     ast::node::ufcs_invocation introduced;
     std::size_t offset;
     symbol::var_symbol refered_symbol;
 };
 
-namespace mi = boost::multi_index;
-
-using captured_offset_map
-    = boost::multi_index_container<
-            lambda_capture,
-            mi::indexed_by<
-                mi::ordered_unique<
-                    mi::tag<tags::offset>,
-                    mi::member<lambda_capture, std::size_t, &lambda_capture::offset>
-                >,
-                mi::ordered_unique<
-                    mi::tag<tags::introduced>,
-                    mi::member<lambda_capture, ast::node::ufcs_invocation, &lambda_capture::introduced>
-                >,
-                mi::ordered_unique<
-                    mi::tag<tags::refered_symbol>,
-                    mi::member<lambda_capture, symbol::var_symbol, &lambda_capture::refered_symbol>
-                >
-            >
-        >;
+// Note:
+// Captures of a lambda.  Captures are stored in a flat vector indexed by their offsets
+// in the lambda object, and looked up by the introduced accesses or the captured symbols
+// through hashed indices.  The table is built once after all captures of the lambda are
+// resolved and never modified after that.
+class captured_offset_map {
+    std::vector<lambda_capture> captures;
+    std::unordered_map<ast::node::ufcs_invocation, std::size_t> introduced_index;
+    std::unordered_map<symbol::var_symbol, std::size_t> symbol_index;
+
+    template<class Index, class Key>
+    boost::optional<lambda_capture const&> find_in(Index const& index, Key const& key) const
+    {
+        auto const found = index.find(key);
+        if (found == std::end(index)) {
+            return boost::none;
+        }
+        return captures[found->second];
+    }
+
+public:
+
+    using const_iterator = std::vector<lambda_capture>::const_iterator;
+
+    captured_offset_map() = default;
+
+    // Note:
+    // 'cs' must be ordered by their offsets.
+    explicit captured_offset_map(std::vector<lambda_capture> &&cs)
+        : captures(std::move(cs))
+    {
+        introduced_index.reserve(captures.size());
+        symbol_index.reserve(captures.size());
+        for (std::size_t i = 0u; i < captures.size(); ++i) {
+            auto const& c = captures[i];
+            assert(c.offset == i);
+            introduced_index.emplace(c.introduced, i);
+            symbol_index.emplace(c.refered_symbol, i);
+        }
+    }
+
+    boost::optional<lambda_capture const&> find_by_introduced(ast::node::ufcs_invocation const& introduced) const
+    {
+        return find_in(introduced_index, introduced);
+    }
+
+    boost::optional<lambda_capture const&> find_by_symbol(symbol::var_symbol const& sym) const
+    {
+        return find_in(symbol_index, sym);
+    }
+
+    lambda_capture const& operator[](std::size_t const offset) const noexcept
+    {
+        return captures[offset];
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return captures.begin();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return captures.end();
+    }
+
+    std::size_t size() const noexcept
+    {
+        return captures.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return captures.empty();
+    }
+};
+
 using lambda_captures_type = std::unordered_map<type::generic_func_type, captured_offset_map>;
 
 struct semantics_context {
@@ -62,11 +112,21 @@ struct semantics_context {
     boost::optional<scope::func_scope> main_arg_constructor;
     std::unordered_map<type::class_type, scope::weak_func_scope> copiers;
 
+    // Note:
+    // Functions reachable from 'main'.  Only they are emitted.  It is empty when the
+    // program has no 'main', and then all functions are treated as reachable.
+    std::unordered_set<scope::func_scope> reachable_funcs;
+
     semantics_context(semantics_context const&) = delete;
     semantics_context &operator=(semantics_context const&) = delete;
     semantics_context(semantics_context &&) = default;
     semantics_context &operator=(semantics_context &&) = default;
 
+    bool is_reachable(scope::func_scope const& f) const
+    {
+        return reachable_funcs.empty() || helper::exists(reachable_funcs, f);
+    }
+
     boost::optional<scope::func_scope> copier_of(type::class_type const& t) const
     {
         auto const itr = copiers.find(t);
@@ -93,7 +153,7 @@ struct semantics_context {
         out << "Lambda captures:" << std::endl;
         for (auto const& cs : lambda_captures) {
             out << "  " << cs.first->to_string() << std::endl;
-            for (auto const& c : cs.second.get<semantics::tags::offset>()) {
+            for (auto const& c : cs.second) {
                 out << "    " << c.refered_symbol->name << ':' << c.introduced->location << " -> " << c.introduced->member_name << std::endl;
             }
         }
@@ -8,6 +8,7 @@
 #include "dachs/semantics/type.hpp"
 #include "dachs/semantics/scope_fwd.hpp"
 #include "dachs/helper/make.hpp"
+#include "dachs/helper/identifier.hpp"
 
 namespace dachs {
 namespace symbol_node {
@@ -16,22 +17,22 @@ namespace symbol_node {
 // Any symbol has type (except for modules or namespaces?)
 
 struct basic_symbol {
-    std::string name;
+    helper::identifier name;
     type::type type;
     ast::node::any_node ast_node;
     bool is_builtin;
 
-    explicit basic_symbol(std::string const& s, bool const is_builtin = false) noexcept
+    explicit basic_symbol(helper::identifier const& s, bool const is_builtin = false) noexcept
         : name(s), type{}, ast_node{}, is_builtin(is_builtin)
     {}
 
     template<class Type>
-    basic_symbol(std::string const& s, Type const& t, bool const is_builtin = false) noexcept
+    basic_symbol(helper::identifier const& s, Type const& t, bool const is_builtin = false) noexcept
         : name(s), type{t}, ast_node{}, is_builtin(is_builtin)
     {}
 
     template<class Node>
-    basic_symbol(Node const& node, std::string const& s, bool const is_builtin = false) noexcept
+    basic_symbol(Node const& node, helper::identifier const& s, bool const is_builtin = false) noexcept
         : name(s), type{}, ast_node{node}, is_builtin(is_builtin)
     {}
 
@@ -54,7 +55,7 @@ struct var_symbol final : public basic_symbol {
     bool is_public = true;
 
     template<class Node>
-    var_symbol(Node const& node, std::string const& s, bool const immutable = true, bool const is_builtin = false) noexcept
+    var_symbol(Node const& node, helper::identifier const& s, bool const immutable = true, bool const is_builtin = false) noexcept
         : basic_symbol(node, s, is_builtin), immutable(immutable)
     {}
 
@@ -27,8 +27,17 @@ public:
         : obj(o), emitter(e)
     {}
 
-    result_type operator()(type::array_type const& a)
+    result_type operator()(type::array_type const& t)
     {
+        // Note:
+        // Size and element type of the array are determined below.  Modify a copy of
+        // the type because 't' may be an interned type.  Don't touch 't' after replacing
+        // the type of 'obj' because it refers to the old value.
+        auto const a = t->size
+            ? type::make<type::array_type>(t->element_type, *t->size)
+            : type::make<type::array_type>(t->element_type);
+        obj->type = a;
+
         if (obj->args.size() > 2) {
             return (boost::format("  Invalid argument for constructor of '%1%' (%2% for 0..2)") % a->to_string() % obj->args.size()).str();
         }
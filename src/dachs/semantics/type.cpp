@@ -1,5 +1,7 @@
 #include <cassert>
 #include <cstddef>
+#include <mutex>
+#include <unordered_map>
 
 #include <boost/optional.hpp>
 #include <boost/variant/static_visitor.hpp>
@@ -7,6 +9,8 @@
 #include <boost/range/adaptor/transformed.hpp>
 #include <boost/algorithm/string/join.hpp>
 #include <boost/algorithm/cxx11/any_of.hpp>
+#include <boost/range/algorithm/equal.hpp>
+#include <boost/functional/hash.hpp>
 
 #include "dachs/ast/ast.hpp"
 #include "dachs/semantics/type.hpp"
@@ -30,12 +34,12 @@ using boost::adaptors::transformed;
 
 static std::vector<builtin_type> const builtin_types
     = {
-        make<builtin_type>("int"),
-        make<builtin_type>("uint"),
-        make<builtin_type>("float"),
-        make<builtin_type>("char"),
-        make<builtin_type>("bool"),
-        make<builtin_type>("symbol"),
+        make_interned<builtin_type>("int"),
+        make_interned<builtin_type>("uint"),
+        make_interned<builtin_type>("float"),
+        make_interned<builtin_type>("char"),
+        make_interned<builtin_type>("bool"),
+        make_interned<builtin_type>("symbol"),
     };
 
 template<class T>
@@ -302,6 +306,285 @@ struct instantiation_checker : boost::static_visitor<bool> {
     }
 };
 
+inline type_node::basic_type const* node_of(any_type const& t) noexcept
+{
+    return apply_lambda([](auto const& n) -> type_node::basic_type const* { return n.get(); }, t.raw_value());
+}
+
+// Note:
+// Computes the structural hash of a type.  It must be consistent with
+// any_type::operator==.  So it doesn't look at what operator== ignores (e.g.
+// the qualifier of qualified type) and hashes the pointer of the function scope
+// for generic function type.  Instance variables of class are hashed down to
+// a limited depth not to loop forever on the class which refers itself.
+struct hasher : boost::static_visitor<size_t> {
+    unsigned int const depth;
+
+    static constexpr unsigned int max_class_depth = 2u;
+
+    explicit hasher(unsigned int const d = 0u) noexcept
+        : depth(d)
+    {}
+
+    result_type hash(any_type const& t) const noexcept
+    {
+        auto const node = node_of(t);
+        if (!node) {
+            // Note:
+            // Empty types are equal to each other even if their kinds are different.
+            return 0u;
+        }
+        if (node->interned) {
+            return node->interned_hash;
+        }
+        auto seed = static_cast<size_t>(t.raw_value().which()) + 1u;
+        boost::hash_combine(seed, t.apply_visitor(*this));
+        return seed;
+    }
+
+    result_type hash(std::vector<any_type> const& ts) const noexcept
+    {
+        size_t seed = ts.size();
+        for (auto const& t : ts) {
+            boost::hash_combine(seed, hash(t));
+        }
+        return seed;
+    }
+
+    result_type operator()(builtin_type const& t) const noexcept
+    {
+        return boost::hash_value(t->name);
+    }
+
+    result_type operator()(class_type const& t) const noexcept
+    {
+        auto seed = boost::hash_value(t->name);
+        if (depth >= max_class_depth) {
+            return seed;
+        }
+
+        auto const types = instance_var_types_of(*t);
+        if (!types) {
+            return seed;
+        }
+
+        hasher const h{depth + 1u};
+        for (auto const& i : *types) {
+            // Note:
+            // Template types of instance variables are equal to each other in class_type::operator==.
+            boost::hash_combine(seed, is_a<template_type>(i) ? size_t{1u} : h.hash(i));
+        }
+        return seed;
+    }
+
+    result_type operator()(tuple_type const& t) const noexcept
+    {
+        return hash(t->element_types);
+    }
+
+    result_type operator()(func_type const& t) const noexcept
+    {
+        auto seed = hash(t->param_types);
+        boost::hash_combine(seed, t->return_type ? hash(*t->return_type) : size_t{0u});
+        return seed;
+    }
+
+    result_type operator()(generic_func_type const& t) const noexcept
+    {
+        if (!t->ref) {
+            return 0u;
+        }
+        return boost::hash_value(t->ref->lock().get());
+    }
+
+    result_type operator()(array_type const& t) const noexcept
+    {
+        auto seed = hash(t->element_type);
+        boost::hash_combine(seed, t->size ? *t->size + 1u : size_t{0u});
+        return seed;
+    }
+
+    result_type operator()(pointer_type const& t) const noexcept
+    {
+        return hash(t->pointee_type);
+    }
+
+    result_type operator()(qualified_type const& t) const noexcept
+    {
+        return hash(t->contained_type);
+    }
+
+    result_type operator()(template_type const& t) const noexcept
+    {
+        // Note:
+        // Template type is not equal to any type.  Any value is OK.
+        return boost::hash_value(t.get());
+    }
+};
+
+// Note:
+// Table for hash consing of types.  See the comment of type::intern().
+class type_interner {
+    std::mutex mutex;
+    std::unordered_multimap<size_t, any_type> table;
+
+    // Note:
+    // Returns a new type whose children are all interned.  The given type is never
+    // returned because it is owned by the caller and may be visible to other threads.
+    // Only nodes created here are marked as interned.  Returns boost::none when the
+    // type can't be interned.
+    struct children_interner : boost::static_visitor<boost::optional<any_type>> {
+        type_interner &interner;
+
+        explicit children_interner(type_interner &i) noexcept
+            : interner(i)
+        {}
+
+        template<class Types>
+        bool intern_all(Types const& ts, std::vector<any_type> &interned) const
+        {
+            interned.reserve(ts.size());
+            for (auto const& t : ts) {
+                auto i = interner.intern_impl(t);
+                if (!i) {
+                    return false;
+                }
+                interned.push_back(std::move(*i));
+            }
+            return true;
+        }
+
+        result_type operator()(builtin_type const& t) const
+        {
+            return any_type{make<builtin_type>(t->name)};
+        }
+
+        result_type operator()(tuple_type const& t) const
+        {
+            std::vector<any_type> elems;
+            if (!intern_all(t->element_types, elems)) {
+                return boost::none;
+            }
+
+            return any_type{make<tuple_type>(elems)};
+        }
+
+        result_type operator()(func_type const& t) const
+        {
+            if (t->is_callable_template) {
+                return boost::none;
+            }
+
+            std::vector<any_type> params;
+            if (!intern_all(t->param_types, params)) {
+                return boost::none;
+            }
+
+            boost::optional<any_type> ret = boost::none;
+            if (t->return_type) {
+                ret = interner.intern_impl(*t->return_type);
+                if (!ret) {
+                    return boost::none;
+                }
+            }
+
+            return any_type{make<func_type>(std::move(params), std::move(ret))};
+        }
+
+        result_type operator()(array_type const& t) const
+        {
+            auto const elem = interner.intern_impl(t->element_type);
+            if (!elem) {
+                return boost::none;
+            }
+
+            return t->size
+                ? any_type{make<array_type>(*elem, *t->size)}
+                : any_type{make<array_type>(*elem)};
+        }
+
+        result_type operator()(pointer_type const& t) const
+        {
+            auto const pointee = interner.intern_impl(t->pointee_type);
+            if (!pointee) {
+                return boost::none;
+            }
+
+
+            return any_type{make<pointer_type>(*pointee)};
+        }
+
+        result_type operator()(qualified_type const& t) const
+        {
+            auto const contained = interner.intern_impl(t->contained_type);
+            if (!contained) {
+                return boost::none;
+            }
+
+
+            return any_type{make<qualified_type>(t->qualifier, *contained)};
+        }
+
+        // Note:
+        // Class types, generic function types and template types
+        template<class T>
+        result_type operator()(T const&) const noexcept
+        {
+            return boost::none;
+        }
+    };
+
+    boost::optional<any_type> intern_impl(any_type const& t)
+    {
+        auto const node = node_of(t);
+        if (!node) {
+            return boost::none;
+        }
+
+        if (node->interned) {
+            return t;
+        }
+
+        children_interner v{*this};
+        auto const candidate = t.apply_visitor(v);
+        if (!candidate) {
+            return boost::none;
+        }
+
+        auto const hash = hasher{}.hash(*candidate);
+        auto const found = table.equal_range(hash);
+        for (auto i = found.first; i != found.second; ++i) {
+            if (i->second == *candidate) {
+                return i->second;
+            }
+        }
+
+        // Note:
+        // The candidate is not visible to others until it is added to the table.
+        auto const n = const_cast<type_node::basic_type *>(node_of(*candidate));
+        n->interned_hash = hash;
+        n->interned = true;
+        table.emplace(hash, *candidate);
+
+        return candidate;
+    }
+
+public:
+
+    any_type intern(any_type const& t)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto const interned = intern_impl(t);
+        return interned ? *interned : t;
+    }
+
+    static type_interner &get()
+    {
+        static type_interner i;
+        return i;
+    }
+};
+
 } // namespace detail
 
 no_opt_t no_opt;
@@ -334,7 +617,7 @@ builtin_type get_builtin_type(char const* const name, no_opt_t) noexcept
 
 tuple_type const& get_unit_type() noexcept
 {
-    static auto const unit_type = make<tuple_type>();
+    static auto const unit_type = make_interned<tuple_type>();
     return unit_type;
 }
 
@@ -391,12 +674,38 @@ bool any_type::operator==(any_type const& rhs) const noexcept
                 if (!l || !r) {
                     // If both sides are empty, return true.  Otherwise return false.
                     return !l && !r;
+                } else if (l->interned && r->interned) {
+                    // Note:
+                    // Structurally equal interned types are the same object.
+                    return static_cast<type_node::basic_type const*>(l.get())
+                        == static_cast<type_node::basic_type const*>(r.get());
                 } else {
                     return *l == *r;
                 }
             }, value, rhs.value);
 }
 
+any_type intern(any_type const& t)
+{
+    return detail::type_interner::get().intern(t);
+}
+
+bool is_interned(any_type const& t) noexcept
+{
+    auto const node = detail::node_of(t);
+    return node && node->interned;
+}
+
+std::size_t hash_value(any_type const& t) noexcept
+{
+    return detail::hasher{}.hash(t);
+}
+
+std::size_t hash_types(std::vector<any_type> const& ts) noexcept
+{
+    return detail::hasher{}.hash(ts);
+}
+
 bool any_type::is_default_constructible() const noexcept
 {
     return apply_lambda([](auto const& t){ return t ? t->is_default_constructible() : false; });
@@ -5,6 +5,8 @@
 #include <memory>
 #include <vector>
 #include <type_traits>
+#include <utility>
+#include <cstddef>
 #include <cassert>
 
 #include <boost/variant/variant.hpp>
@@ -273,6 +275,12 @@ using dachs::helper::enable_if;
 using type::traits::is_type;
 
 struct basic_type {
+    // Note:
+    // Set by type::intern().  An interned type is shared by all places where
+    // the structurally same type appears.  So it must not be modified.
+    bool interned = false;
+    std::size_t interned_hash = 0u;
+
     virtual std::string to_string() const noexcept = 0;
     virtual bool is_default_constructible() const noexcept = 0;
     virtual ~basic_type() noexcept
@@ -722,6 +730,28 @@ bool any_type::is_instantiated_from(Type const& from) const
 
 bool fuzzy_match(any_type const& lhs, any_type const& rhs);
 
+// Note:
+// Returns the unique object for the structure of the type (hash consing).  Two interned
+// types are equal iff they are the same object, so comparing them is a pointer compare.
+// Only types which consist of builtin, tuple, function, array, pointer and qualified
+// types are interned.  Other types (e.g. class types and templates) are returned as is
+// because they are compared by the scopes they refer or they are modified after construction.
+any_type intern(any_type const& t);
+
+bool is_interned(any_type const& t) noexcept;
+
+template<class T, class... Args>
+inline T make_interned(Args &&... args)
+{
+    return *get<T>(intern(make<T>(std::forward<Args>(args)...)));
+}
+
+// Note:
+// Structural hash of types.  Equal types (in terms of any_type::operator==) have
+// the same hash value.  hash_value() is also found by boost::hash.
+std::size_t hash_value(any_type const& t) noexcept;
+std::size_t hash_types(std::vector<any_type> const& ts) noexcept;
+
 } // namespace type
 
 } // namespace dachs
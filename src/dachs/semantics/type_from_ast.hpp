@@ -178,7 +178,7 @@ helper::probable<any_type> from_ast_impl(ast::node::any_type const& t, Visitor &
         return helper::oops(*v.failed());
     }
 
-    return result;
+    return intern(result);
 }
 
 } // namespace detail
@@ -12,13 +12,15 @@
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/classification.hpp>
-#include <boost/algorithm/string/join.hpp>
 
 #include "dachs/compiler.hpp"
+#include "dachs/compile_server.hpp"
 #include "dachs/helper/colorizer.hpp"
 #include "dachs/helper/backtrace_printer.hpp"
 #include "dachs/exception.hpp"
 #include "dachs/codegen/opt_level.hpp"
+#include "dachs/parser/parser.hpp"
+#include "dachs/parser/module_cache.hpp"
 
 namespace dachs {
 namespace cmdline {
@@ -119,6 +121,11 @@ auto parse_command_options(ArgPtr arg)
         codegen::opt_level opt = codegen::opt_level::none;
         std::vector<std::string> run_args;
         std::vector<std::string> importdirs;
+        unsigned int jobs = 1u;
+        bool incremental = false;
+        bool server = false;
+        bool module_cache = true;
+        syntax::front_end front_end = syntax::front_end::spirit;
         bool help = false;
     } cmdopts;
 
@@ -128,6 +135,10 @@ auto parse_command_options(ArgPtr arg)
     std::string const debug_str = "--debug";
     std::string const release_str = "--release";
     std::string const help_str = "--help";
+    std::string const incremental_str = "--incremental";
+    std::string const server_str = "--server";
+    std::string const hand_written_parser_str = "--hand-written-parser";
+    std::string const no_module_cache_str = "--no-module-cache";
 
     for (; *arg; ++arg) {
         if (boost::algorithm::starts_with(*arg, "--runtimedir=")) {
@@ -152,6 +163,22 @@ auto parse_command_options(ArgPtr arg)
             cmdopts.opt = codegen::opt_level::release;
         } else if (boost::algorithm::starts_with(*arg, "--libdir=")) {
             cmdopts.importdirs += get_substitution_option(*arg, "--libdir=");
+        } else if (boost::algorithm::starts_with(*arg, "--jobs=")) {
+            auto const jobs = std::atoi(*arg + std::strlen("--jobs="));
+            if (jobs > 0) {
+                cmdopts.jobs = static_cast<unsigned int>(jobs);
+            } else {
+                // Note: Invalid number of jobs.  Treat it as an unknown option to show usage.
+                cmdopts.rest_args.emplace_back(*arg);
+            }
+        } else if (*arg == incremental_str) {
+            cmdopts.incremental = true;
+        } else if (*arg == server_str) {
+            cmdopts.server = true;
+        } else if (*arg == hand_written_parser_str) {
+            cmdopts.front_end = syntax::front_end::hand_written;
+        } else if (*arg == no_module_cache_str) {
+            cmdopts.module_cache = false;
         } else if (*arg == help_str) {
             cmdopts.help = true;
         } else {
@@ -204,21 +231,30 @@ int main(int const, char const* const argv[])
         [argv]()
         {
             std::cerr << "OVERVIEW\n  Dachs compiler\n\n"
-                      << "USAGE\n  " << argv[0] << " [--dump-ast|--dump-sym-table|--emit-llvm|--output-obj|--check-syntax] [--debug-compiler] [--debug|--release] [--libdir={path}] [--runtimedir={path}] [--disable-color] {file} [--run [args...]]\n" <<
+                      << "USAGE\n  " << argv[0] << " [--dump-ast|--dump-sym-table|--emit-llvm|--output-obj|--check-syntax] [--debug-compiler] [--debug|--release] [--libdir={path}] [--runtimedir={path}] [--jobs={N}] [--incremental] [--hand-written-parser] [--no-module-cache] [--disable-color] {file} [--run [args...]]\n"
+                      << "  " << argv[0] << " --server [--debug|--release] [--incremental] [--hand-written-parser] [--no-module-cache] [--disable-color]\n" <<
 R"(
 OPTIONS
   --dump-ast           Output AST to STDOUT
   --dump-sym-table     Output symbol table to STDOUT
   --emit-llvm          Print LLVM IR to STDOUT
   --output-obj         Generate object file instead of executable
-  --check-syntax       Check syntax and output parse error if exists
+  --check-syntax       Check syntax and output parse errors of all files which have them
   --debug-compiler     Output debug information to STDERR
   --debug              Do not optimize (equivalent to -O0)
   --release            Do aggressive optimization (equivalent to -O3)
   --libdir={path}      Add import path
-  --runtimedir={path}  Specify path of runtime directory
+  --runtimedir={path}  Specify path of runtime directory (not available with --run)
+  --jobs={N}           Compile (or check syntax of) source files in N threads in parallel
+  --incremental        Reuse object files in .dachs-build for unchanged source files
+  --server             Serve compile requests in JSON lines from STDIN and respond to STDOUT
+                       Requests are compiled in one thread (--jobs is ignored)
+  --hand-written-parser
+                       Parse with the hand-written parser instead of the Spirit grammar
+  --no-module-cache    Do not read or write parsed imported modules in the cache directory
+                       ($DACHS_CACHE_DIR, $XDG_CACHE_HOME/dachs/modules or ~/.cache/dachs/modules)
   --disable-color      Disable colorful output
-  --run [ARGS]...      Instantly run the program instead of generating executable
+  --run [ARGS]...      Instantly run the program with JIT instead of generating executable
                        All arguments after --run are treated as runtime options
   --help               Show this help
 
@@ -236,12 +272,39 @@ URL
         return 0;
     }
 
+    if (!cmdopts.module_cache) {
+        dachs::syntax::module_cache::default_dir = boost::none;
+    }
+
+    if (cmdopts.server) {
+        if (!cmdopts.rest_args.empty() || !cmdopts.source_files.empty() || cmdopts.run) {
+            show_usage();
+            return 1;
+        }
+
+        // Note:
+        // Source files and options are specified by each request.
+        // The server captures diagnostics of a request by redirecting STDERR.  Worker
+        // threads would write to the redirected buffer concurrently.  So the server
+        // always compiles in one thread.
+        dachs::compiler compiler{cmdopts.enable_color, cmdopts.debug_compiler, cmdopts.opt, 1u, cmdopts.incremental, cmdopts.front_end};
+        return dachs::compile_server{compiler}.serve(std::cin, std::cout);
+    }
+
     if (cmdopts.source_files.empty()) {
         std::cerr << "No input file: Source file must end with '.dcs'.\n";
         return 2;
     }
 
-    dachs::compiler compiler{cmdopts.enable_color, cmdopts.debug_compiler, cmdopts.opt};
+    // Note:
+    // --run executes the program with the runtime linked into the compiler.  No
+    // linker is invoked, so runtime directories would be silently ignored.
+    if (cmdopts.run && !cmdopts.libdirs.empty()) {
+        std::cerr << "--runtimedir can't be used with --run: The program is run with the runtime linked into the compiler.\n";
+        return 1;
+    }
+
+    dachs::compiler compiler{cmdopts.enable_color, cmdopts.debug_compiler, cmdopts.opt, cmdopts.jobs, cmdopts.incremental, cmdopts.front_end};
 
     switch (cmdopts.rest_args.size()) {
 
@@ -307,35 +370,22 @@ URL
         if (cmdopts.run && cmdopts.source_files.size() > 0) {
 
             // Note:
-            // When JIT compiler with LLVM JIT support will be implemented,
-            // '--run' option should use it.
-            return dachs::cmdline::do_compiler_action(
+            // Run the program with LLVM JIT in this process.  No executable
+            // is generated and no linker is invoked.
+            int status = 0;
+            auto const result = dachs::cmdline::do_compiler_action(
                     [&]
                     {
-                        auto tmpdir = dachs::cmdline::get_tmpdir();
-                        auto const executable = compiler.compile(
+                        status = compiler.run(
                                 cmdopts.source_files,
-                                cmdopts.libdirs,
                                 cmdopts.importdirs,
-                                std::move(tmpdir)
-                            );
-
-                        assert(!executable.empty() && executable.front() == '/');
-
-                        std::string const args = boost::algorithm::join(
-                                cmdopts.run_args,
-                                " "
-                            );
-
-                        std::system(
-                                (
-                                    executable + " " + args
-                                ).c_str()
+                                cmdopts.run_args
                             );
-                        std::remove(executable.c_str());
                     }
                 );
 
+            return result != 0 ? result : status;
+
         } else if (cmdopts.source_files.size() > 0) {
             return dachs::cmdline::do_compiler_action(
                 [&]
@@ -5,6 +5,9 @@
 #include "test_helper.hpp"
 
 #include <string>
+#include <set>
+#include <sstream>
+#include <iostream>
 
 #include "dachs/ast/ast.hpp"
 #include "dachs/parser/parser.hpp"
@@ -35,6 +38,21 @@ static dachs::syntax::parser p;
             BOOST_CHECK_THROW(dachs::semantics::analyze_semantics(t, i), dachs::not_implemented_error); \
         } while (false);
 
+struct analysis_fixture {
+    struct analyzed_program {
+        dachs::ast::ast ast;
+        dachs::semantics::semantics_context ctx;
+    };
+
+    analyzed_program analyze(char const* const code, unsigned int const jobs = 1u) const
+    {
+        auto t = p.parse(code, "test_file");
+        dachs::syntax::importer i{{}, "test_file"};
+        auto ctx = dachs::semantics::analyze_semantics(t, i, jobs);
+        return {std::move(t), std::move(ctx)};
+    }
+};
+
 BOOST_AUTO_TEST_SUITE(analyzer)
 
 BOOST_AUTO_TEST_CASE(symbol_duplication_ok)
@@ -4461,4 +4479,526 @@ BOOST_AUTO_TEST_CASE(unterminated_block_check)
     )");
 }
 
+BOOST_AUTO_TEST_CASE(repeated_instantiation)
+{
+    CHECK_NO_THROW_SEMANTIC_ERROR(R"(
+        class Foo
+            a
+
+            init(@a)
+            end
+        end
+
+        class Bar
+            a, b
+
+            init(@a, @b)
+            end
+        end
+
+        func main
+            f1 := new Foo{1}
+            f2 := new Foo{1}
+            f3 := new Foo{1.0}
+            f4 := new Foo{f1}
+            f5 := new Foo{new Foo{1}}
+            f6 := new Foo{[1, 2]}
+            f7 := new Foo{(1, 'a')}
+            f8 := new Foo{(1, 'a')}
+            b1 := new Bar{1, f1}
+            b2 := new Bar{1, f2}
+            b3 := new Bar{f3, 'a'}
+            b4 := new Bar{f3, 'a'}
+            l := -> x in x
+            g1 := new Foo{l}
+            g2 := new Foo{l}
+        end
+    )");
+}
+
+BOOST_AUTO_TEST_CASE(type_interning)
+{
+    using namespace dachs::type;
+
+    auto const i = get_builtin_type("int", no_opt);
+    auto const c = get_builtin_type("char", no_opt);
+
+    auto const p1 = intern(make<pointer_type>(i));
+    auto const p2 = intern(make<pointer_type>(i));
+    BOOST_CHECK(*get<pointer_type>(p1) == *get<pointer_type>(p2));
+    BOOST_CHECK(p1 == p2);
+    BOOST_CHECK(p1 != intern(make<pointer_type>(c)));
+    BOOST_CHECK(p1 == make<pointer_type>(i));
+
+    auto const t1 = intern(make<tuple_type>(std::vector<any_type>{i, p1, make<array_type>(c, 3u)}));
+    auto const t2 = intern(make<tuple_type>(std::vector<any_type>{i, make<pointer_type>(i), make<array_type>(c, 3u)}));
+    BOOST_CHECK(*get<tuple_type>(t1) == *get<tuple_type>(t2));
+    BOOST_CHECK(t1 != intern(make<tuple_type>(std::vector<any_type>{i, p1, make<array_type>(c)})));
+    BOOST_CHECK(hash_value(t1) == hash_value(make<tuple_type>(std::vector<any_type>{i, p1, make<array_type>(c, 3u)})));
+
+    BOOST_CHECK(*get<tuple_type>(intern(make<tuple_type>())) == get_unit_type());
+
+    // The given type is not modified even if its children are already interned
+    auto const owned = make<pointer_type>(i);
+    auto const interned = intern(owned);
+    BOOST_CHECK(!is_interned(owned));
+    BOOST_CHECK(is_interned(interned));
+    BOOST_CHECK(*get<pointer_type>(interned) != owned);
+    BOOST_CHECK(interned == p1);
+
+    // Template types are never interned
+    auto const tmpl = make<pointer_type>(make<template_type>(dachs::ast::node::any_node{}));
+    BOOST_CHECK(*get<pointer_type>(intern(tmpl)) == tmpl);
+}
+
+BOOST_AUTO_TEST_CASE(function_resolution)
+{
+    using namespace dachs;
+
+    auto const global = scope::make<scope::global_scope>(std::shared_ptr<ast::node_type::inu>{});
+    auto const define_func
+        = [&global](char const* const name, std::vector<type::type> const& param_types)
+        {
+            auto const f = scope::make<scope::func_scope>(nullptr, global, name, true);
+            for (auto const idx : helper::indices(param_types.size())) {
+                auto const param = symbol::make<symbol::var_symbol>(nullptr, "p" + std::to_string(idx), true, true);
+                param->type = param_types[idx];
+                f->define_param(param);
+            }
+            global->define_function(f);
+            return f;
+        };
+
+    auto const int_ = type::get_builtin_type("int", type::no_opt);
+    auto const float_ = type::get_builtin_type("float", type::no_opt);
+
+    // Same name functions with different arities
+    auto const foo1 = define_func("foo", {int_});
+    auto const foo2 = define_func("foo", {int_, int_});
+    auto const bar = define_func("bar", {int_});
+    BOOST_CHECK(global->resolve_func("foo", {int_}) == scope_node::function_set{foo1});
+    BOOST_CHECK(global->resolve_func("foo", {int_, int_}) == scope_node::function_set{foo2});
+    BOOST_CHECK(global->resolve_func("foo", {}).empty());
+    BOOST_CHECK(global->resolve_func("foo", {int_, int_, int_}).empty());
+    BOOST_CHECK(global->resolve_func("bar", {int_}) == scope_node::function_set{bar});
+    BOOST_CHECK(global->resolve_func("baz", {int_}).empty());
+
+    // Memoized results are the same as the first resolution
+    BOOST_CHECK(!global->resolution_cache.empty());
+    BOOST_CHECK(global->resolve_func("foo", {int_}) == scope_node::function_set{foo1});
+    BOOST_CHECK(global->resolve_func("foo", {int_, int_}) == scope_node::function_set{foo2});
+
+    // A memoized result is invalidated by a newly defined function
+    BOOST_CHECK(global->resolve_func("foo", {float_}).empty());
+    auto const foo3 = define_func("foo", {float_});
+    BOOST_CHECK(global->resolution_cache.empty());
+    BOOST_CHECK(global->resolve_func("foo", {float_}) == scope_node::function_set{foo3});
+    BOOST_CHECK(global->resolve_func("foo", {int_}) == scope_node::function_set{foo1});
+
+    // Class types are not interned and are never memoized
+    auto const clazz = scope::make<scope::class_scope>(nullptr, global, "Foo");
+    global->define_class(clazz);
+    auto const class_type_of = [&clazz]{ return type::type{type::make<type::class_type>(clazz)}; };
+    BOOST_CHECK(!type::is_interned(class_type_of()));
+
+    auto const foo4 = define_func("foo", {class_type_of()});
+    auto const foo5 = define_func("foo", {class_type_of(), int_});
+    BOOST_CHECK(global->resolve_func("foo", {class_type_of()}) == scope_node::function_set{foo4});
+    BOOST_CHECK(global->resolve_func("foo", {class_type_of(), int_}) == scope_node::function_set{foo5});
+    BOOST_CHECK(global->resolve_func("foo", {class_type_of(), float_}).empty());
+    BOOST_CHECK(global->resolution_cache.empty());
+
+    auto const foo6 = define_func("foo", {class_type_of(), float_});
+    BOOST_CHECK(global->resolve_func("foo", {class_type_of(), float_}) == scope_node::function_set{foo6});
+    BOOST_CHECK(global->resolve_func("foo", {class_type_of()}) == scope_node::function_set{foo4});
+}
+
+BOOST_AUTO_TEST_CASE(scope_arena)
+{
+    using namespace dachs;
+
+    auto const var = [](char const* const name){ return symbol::make<symbol::var_symbol>(nullptr, name, true, true); };
+
+    auto const global = scope::make<scope::global_scope>(std::shared_ptr<ast::node_type::inu>{});
+    auto const func = scope::make<scope::func_scope>(nullptr, global, "f", true);
+    func->body = scope::make<scope::local_scope>(func);
+    BOOST_CHECK(func->parent == global.get());
+    BOOST_CHECK(&func->body->get_root() == global.get());
+
+    auto const g = var("g");
+    auto const a = var("a");
+    auto const b = var("b");
+    BOOST_CHECK(global->define_variable(g));
+    BOOST_CHECK(func->define_param(a));
+    BOOST_CHECK(func->body->define_variable_without_shadowing_check(b));
+
+    // A scope which is not attached to the tree is still alive in the arena
+    std::weak_ptr<scope_node::local_scope> detached;
+    detached = scope::make<scope::local_scope>(func->body);
+    BOOST_CHECK(!detached.expired());
+    BOOST_CHECK_EQUAL(global->arena.size(), 3u);
+
+    auto const inner = detached.lock();
+    BOOST_CHECK(*inner->resolve_var("a") == a);
+    BOOST_CHECK(*inner->resolve_var("b") == b);
+    BOOST_CHECK(*inner->resolve_var("g") == g);
+    BOOST_CHECK(!inner->resolve_var("unknown"));
+
+    // The parameter pushed in front wins
+    auto const self = var("a");
+    func->force_push_front_param(self);
+    BOOST_CHECK(*inner->resolve_var("a") == self);
+}
+
+BOOST_AUTO_TEST_CASE(fused_passes)
+{
+    using namespace dachs;
+
+    // Const member functions, lhs of assignments and return types are checked in the walk of analyzer
+    auto t = p.parse(R"(
+        class Counter
+          - count : int
+            init(@count)
+            end
+
+            func get
+                ret @count
+            end
+
+            func get_via
+                ret @get
+            end
+
+            func set(c : int)
+                @count = c
+            end
+
+            func set_via(c : int)
+                @set(c)
+            end
+        end
+
+        func fib(n)
+            ret 1 if n <= 1
+            ret fib(n-1) + fib(n-2)
+        end
+
+        func main
+            var c := new Counter{fib(3)}
+            c.set_via(c.get_via)
+        end
+    )", "test_file");
+    syntax::importer i{{}, "test_file"};
+    auto const ctx = semantics::analyze_semantics(t, i);
+
+    // Note: Member functions are defined in global scope
+    auto num_checked = 0u;
+    for (auto const& f : ctx.scopes.root->functions) {
+        if (f->is_template()) {
+            continue;
+        }
+
+        if (f->is_member_func && !f->is_ctor()) {
+            auto const expected = f->name == "get" || f->name == "get_via";
+            BOOST_CHECK_MESSAGE(f->is_const() == expected, f->name);
+            ++num_checked;
+        } else if (f->name == "fib") {
+            BOOST_REQUIRE(f->ret_type);
+            BOOST_CHECK(*f->ret_type == type::get_builtin_type("int", type::no_opt));
+            ++num_checked;
+        }
+    }
+    BOOST_CHECK_EQUAL(num_checked, 5u);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_checking)
+{
+    using namespace dachs;
+
+    // Bodies of functions whose return types are specified are checked in parallel
+    auto t = p.parse(R"(
+        class Box
+          + v
+            init(@v)
+            end
+        end
+
+        func id(x)
+            ret x
+        end
+
+        func twice(x)
+            ret x + x
+        end
+
+        func sum(a : [int]) : int
+            var s := 0
+            for e in a
+                s += e
+            end
+            ret s
+        end
+
+        func apply(n : int) : int
+            ret ([1, 2, 3].size as int) + (-> x in twice(x))(n) + id(n)
+        end
+
+        func box(f : float) : float
+            ret (new Box{f}).v + twice(f) + id(f)
+        end
+
+        func greet(s : string) : string
+            ret id(s)
+        end
+
+        func total(n : int) : int
+            ret sum([n, twice(n), id(n)]) + apply(n)
+        end
+
+        func main
+            print(total(1))
+            print(box(1.0))
+            print(greet("hi"))
+        end
+    )", "test_file");
+    syntax::importer i{{}, "test_file"};
+    auto const ctx = semantics::analyze_semantics(t, i, 4u);
+
+    auto num_checked = 0u;
+    for (auto const& f : t.root->functions) {
+        if (f->name == "twice" && !f->instantiated.empty()) {
+            BOOST_CHECK_EQUAL(f->instantiated.size(), 2u);
+            ++num_checked;
+        } else if (f->name == "id" && !f->instantiated.empty()) {
+            BOOST_CHECK_EQUAL(f->instantiated.size(), 3u);
+            ++num_checked;
+        }
+    }
+    BOOST_CHECK_EQUAL(num_checked, 2u);
+
+    {
+        auto t = p.parse(R"(
+            func id(x)
+                ret x
+            end
+
+            func foo(n : int) : int
+                ret id(n)
+            end
+
+            func bar(n : int) : int
+                ret id(n) + 'a'
+            end
+
+            func main
+                print(foo(1) + bar(1))
+            end
+        )", "test_file");
+        syntax::importer i{{}, "test_file"};
+        BOOST_CHECK_THROW(semantics::analyze_semantics(t, i, 4u), semantic_check_error);
+    }
+
+    {
+        // Note:
+        // Errors and warnings of symbol definitions (e.g. redefinition and shadowing)
+        // are output in the same order as sequential checking.
+        auto const code = R"(
+            func foo(n : int) : int
+                ret n + 'a'
+            end
+
+            func bar(n : int) : int
+                a := 1
+                a := 2
+                ret a + n
+            end
+
+            func baz(n : int) : int
+                if true
+                    n := 2
+                    ret n
+                end
+                ret n
+            end
+
+            func main
+                print(foo(1) + bar(1) + baz(1))
+            end
+        )";
+
+        auto const diagnostics_of
+            = [&](unsigned int const jobs)
+            {
+                auto t = p.parse(code, "test_file");
+                syntax::importer i{{}, "test_file"};
+                std::ostringstream out;
+                auto *const saved = std::cerr.rdbuf(out.rdbuf());
+                try {
+                    semantics::analyze_semantics(t, i, jobs);
+                    BOOST_ERROR("semantic_check_error is not thrown");
+                }
+                catch (semantic_check_error const&) {}
+                std::cerr.rdbuf(saved);
+                return out.str();
+            };
+
+        auto const sequential = diagnostics_of(1u);
+        BOOST_CHECK(sequential.find("redefined") != std::string::npos);
+        BOOST_CHECK(sequential.find("Shadowing") != std::string::npos);
+        BOOST_CHECK_EQUAL(sequential, diagnostics_of(4u));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(lambda_capture_table)
+{
+    using namespace dachs;
+
+    auto t = p.parse(R"(
+        func main
+            var a := 1
+            b := 'b'
+            c := "c"
+            f := -> x in a + x + (b as int) + c.size as int + a
+            print(f(1))
+        end
+    )", "test_file");
+    syntax::importer i{{}, "test_file"};
+    auto const ctx = semantics::analyze_semantics(t, i);
+
+    // Note: Lambdas in the prelude are also included
+    auto num_checked = 0u;
+    for (auto const& entry : ctx.lambda_captures) {
+        auto const& captures = entry.second;
+        std::set<std::string> names;
+        for (auto const& c : captures) {
+            names.insert(c.refered_symbol->name);
+        }
+        if (names != std::set<std::string>{"a", "b", "c"}) {
+            continue;
+        }
+
+        BOOST_REQUIRE_EQUAL(captures.size(), 3u);
+
+        std::size_t offset = 0u;
+        for (auto const& c : captures) {
+            BOOST_CHECK_EQUAL(c.offset, offset);
+            BOOST_CHECK_EQUAL(&captures[offset], &c);
+            auto const by_introduced = captures.find_by_introduced(c.introduced);
+            BOOST_REQUIRE(by_introduced);
+            BOOST_CHECK_EQUAL(by_introduced->offset, offset);
+            auto const by_symbol = captures.find_by_symbol(c.refered_symbol);
+            BOOST_REQUIRE(by_symbol);
+            BOOST_CHECK_EQUAL(by_symbol->offset, offset);
+            ++offset;
+        }
+
+        BOOST_CHECK(!captures.find_by_symbol(nullptr));
+        ++num_checked;
+    }
+    BOOST_CHECK_EQUAL(num_checked, 1u);
+}
+
+BOOST_FIXTURE_TEST_CASE(reachable_functions, analysis_fixture)
+{
+    auto const reachable
+        = [](auto const& ctx, auto const& name)
+        {
+            auto num_reachable = 0u;
+            for (auto const& f : ctx.scopes.root->functions) {
+                if (f->name == name && !f->is_template() && ctx.is_reachable(f)) {
+                    ++num_reachable;
+                }
+            }
+            return num_reachable;
+        };
+
+    {
+        auto const a = analyze(R"(
+            import std.numeric
+
+            func foo(i)
+                ret i.even?
+            end
+
+            func bar(i : int) : bool
+                ret i.odd?
+            end
+
+            func main
+                f := foo
+                print(f(42))
+            end
+        )");
+
+        BOOST_CHECK_EQUAL(reachable(a.ctx, "main"), 1u);
+        BOOST_CHECK_EQUAL(reachable(a.ctx, "foo"), 1u);
+        BOOST_CHECK_EQUAL(reachable(a.ctx, "even?"), 1u);
+        BOOST_CHECK_EQUAL(reachable(a.ctx, "bar"), 0u);
+        BOOST_CHECK_EQUAL(reachable(a.ctx, "odd?"), 0u);
+        BOOST_CHECK_EQUAL(reachable(a.ctx, "to_string"), 0u);
+    }
+
+    {
+        // Note:
+        // The imported function is called only from the copier, which code generation
+        // calls when the object is copied.
+        auto const a = analyze(R"(
+            import std.numeric
+
+            class Counter
+              + count : int
+
+                init(@count)
+                end
+
+                copy
+                    ret new Counter{@count.succ}
+                end
+            end
+
+            func main
+                c := new Counter{1}
+                var d := c
+                print(d.count)
+            end
+        )");
+
+        BOOST_CHECK_EQUAL(reachable(a.ctx, "succ"), 1u);
+        BOOST_CHECK_EQUAL(reachable(a.ctx, "even?"), 0u);
+    }
+
+    {
+        // Note:
+        // The imported functions are called only from size() and [] which the for
+        // statement calls to iterate the range.
+        auto const a = analyze(R"(
+            import std.numeric
+
+            class Seq
+              + n : uint
+            end
+
+            func size(s : Seq) : uint
+                ret s.n.succ
+            end
+
+            func [](_ : Seq, i : uint) : bool
+                ret i.even?
+            end
+
+            func main
+                for e in new Seq{3u}
+                    print(e)
+                end
+            end
+        )");
+
+        BOOST_CHECK_EQUAL(reachable(a.ctx, "size"), 1u);
+        BOOST_CHECK_EQUAL(reachable(a.ctx, "[]"), 1u);
+        BOOST_CHECK_EQUAL(reachable(a.ctx, "succ"), 1u);
+        BOOST_CHECK_EQUAL(reachable(a.ctx, "even?"), 1u);
+        BOOST_CHECK_EQUAL(reachable(a.ctx, "odd?"), 0u);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -8,6 +8,9 @@
 #include <boost/test/included/unit_test.hpp>
 
 #include "dachs/helper/probable.hpp"
+#include "dachs/helper/source_buffer.hpp"
+#include "dachs/helper/identifier.hpp"
+#include "dachs/helper/util.hpp"
 
 using namespace dachs::helper;
 
@@ -134,6 +137,71 @@ BOOST_AUTO_TEST_CASE(edge_case_string)
     BOOST_CHECK(*f == "bbbb");
 }
 
+BOOST_AUTO_TEST_CASE(source_buffer_mapping_file)
+{
+    std::string const path = DACHS_ROOT_DIR "/test/assets/samples/fizzbuzz.dcs";
+    auto const code = read_file<std::string>(path);
+    BOOST_CHECK(code);
+
+    auto const buffer = source_buffer::open(path);
+    BOOST_CHECK(buffer);
+    BOOST_CHECK(!buffer->empty());
+    BOOST_CHECK(buffer->size() == code->size());
+    BOOST_CHECK(buffer->equals(*code));
+    BOOST_CHECK(buffer->str() == *code);
+    BOOST_CHECK(std::string(buffer->begin(), buffer->end()) == *code);
+
+    BOOST_CHECK(!source_buffer::open(DACHS_ROOT_DIR "/test/assets/samples/does_not_exist.dcs"));
+    BOOST_CHECK(!read_file<std::string>(DACHS_ROOT_DIR "/test/assets/samples/does_not_exist.dcs"));
+
+    auto const s = source_buffer::from_string("func main\nend\n");
+    BOOST_CHECK(s->size() == 14u);
+    BOOST_CHECK(s->equals("func main\nend\n"));
+    BOOST_CHECK(!s->equals("func main\nend"));
+    BOOST_CHECK(source_buffer::from_string("")->empty());
+}
+
+BOOST_AUTO_TEST_CASE(identifier_interning)
+{
+    identifier const i1 = "foo";
+    identifier const i2 = std::string{"fo"} + 'o';
+    identifier const i3 = "bar";
+
+    BOOST_CHECK(i1 == i2);
+    BOOST_CHECK(i1.id() == i2.id());
+    BOOST_CHECK(i1 != i3);
+    BOOST_CHECK(i1.id() != i3.id());
+    BOOST_CHECK(&i1.str() == &i2.str());
+
+    BOOST_CHECK(i1 == "foo");
+    BOOST_CHECK(i1 != "bar");
+    BOOST_CHECK(std::string{"foo"} == i1);
+    BOOST_CHECK(i3 < i1);
+    BOOST_CHECK("<" + i1 + '>' == "<foo>");
+
+    identifier const empty;
+    BOOST_CHECK(empty.empty());
+    BOOST_CHECK(empty == identifier{""});
+    BOOST_CHECK(std::hash<identifier>{}(i1) == std::hash<identifier>{}(i2));
+
+    // Unique identifiers are not interned but equal to the same characters
+    auto const u1 = identifier::unique("foo");
+    auto const u2 = identifier::unique("foo");
+    BOOST_CHECK(i1.is_interned());
+    BOOST_CHECK(!u1.is_interned());
+    BOOST_CHECK(&u1.str() != &u2.str());
+    BOOST_CHECK(&u1.str() != &i1.str());
+    BOOST_CHECK(u1 == u2);
+    BOOST_CHECK(u1 == i1);
+    BOOST_CHECK(i1 == u1);
+    BOOST_CHECK(u1 != i3);
+    BOOST_CHECK(u1 == "foo");
+    BOOST_CHECK(std::hash<identifier>{}(u1) == std::hash<identifier>{}(i1));
+
+    auto const copied = u1;
+    BOOST_CHECK(&copied.str() == &u1.str());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()
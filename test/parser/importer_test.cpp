@@ -6,12 +6,15 @@
 
 #include <string>
 #include <vector>
+#include <fstream>
 
 #include <boost/test/included/unit_test.hpp>
 
 #include "dachs/ast/ast.hpp"
 #include "dachs/parser/parser.hpp"
 #include "dachs/parser/importer.hpp"
+#include "dachs/parser/module_pool.hpp"
+#include "dachs/parser/module_cache.hpp"
 #include "dachs/exception.hpp"
 #include "dachs/semantics/semantic_analysis.hpp"
 
@@ -47,6 +50,23 @@ static std::string dummy_file = DACHS_ROOT_DIR "/test/assets/import_test/dummy/d
         ); \
     } while (false)
 
+#define CHECK_NO_THROW_IMPORT_WITH_POOL(pool, ...) do { \
+        auto t = p.parse((__VA_ARGS__ "\nfunc main; end"), dummy_file); \
+        dachs::syntax::importer i{importdirs, dummy_file, pool}; \
+        BOOST_CHECK_NO_THROW( \
+            dachs::semantics::analyze_semantics(t, i) \
+        ); \
+    } while (false)
+
+#define CHECK_THROW_SEMANTC_ERROR_WITH_POOL(pool, ...) do { \
+        auto t = p.parse((__VA_ARGS__ "\nfunc main; end"), dummy_file); \
+        dachs::syntax::importer i{importdirs, dummy_file, pool}; \
+        BOOST_CHECK_THROW( \
+            dachs::semantics::analyze_semantics(t, i), \
+            dachs::semantic_check_error \
+        ); \
+    } while (false)
+
 BOOST_AUTO_TEST_SUITE(importer)
 
 BOOST_AUTO_TEST_CASE(normal_cases)
@@ -107,5 +127,100 @@ BOOST_AUTO_TEST_CASE(abnormal_cases)
     CHECK_THROW_SEMANTC_ERROR("import error2");
 }
 
+BOOST_AUTO_TEST_CASE(shared_modules)
+{
+    dachs::syntax::module_pool pool;
+
+    // Note:
+    // Modules imported at the second time are copied from the pool.
+    // Analyzing the first program must not affect the second one.
+    CHECK_NO_THROW_IMPORT_WITH_POOL(pool, "import std.range\nimport foo\nimport foo.aaa");
+    CHECK_NO_THROW_IMPORT_WITH_POOL(pool, "import std.range\nimport foo\nimport foo.aaa");
+    CHECK_NO_THROW_IMPORT_WITH_POOL(pool, "import main2");
+    CHECK_NO_THROW_IMPORT_WITH_POOL(pool, "import main2");
+    CHECK_THROW_SEMANTC_ERROR_WITH_POOL(pool, "import error2");
+    CHECK_THROW_SEMANTC_ERROR_WITH_POOL(pool, "import error2");
+}
+
+BOOST_AUTO_TEST_CASE(module_cache_directory)
+{
+    using dachs::syntax::module_cache;
+
+    // Note:
+    // The global fixture points the cache at a temporary directory.
+    BOOST_REQUIRE(module_cache::default_dir);
+    BOOST_CHECK(module_cache::default_dir->parent_path() == fs::temp_directory_path());
+
+    CHECK_NO_THROW_IMPORT("import foo");
+    BOOST_CHECK(fs::exists(*module_cache::default_dir));
+    BOOST_CHECK(!fs::is_empty(*module_cache::default_dir));
+
+    auto const saved = module_cache::default_dir;
+    module_cache::default_dir = boost::none;
+    BOOST_CHECK(!module_cache{}.enabled());
+    BOOST_CHECK(!module_cache{}.find(DACHS_ROOT_DIR "/test/assets/import_test/foo.dcs"));
+    module_cache::default_dir = saved;
+    BOOST_CHECK(module_cache{}.enabled());
+}
+
+BOOST_AUTO_TEST_CASE(pooled_module_freshness)
+{
+    using identity = dachs::helper::source_buffer::file_identity;
+
+    auto const path = fs::temp_directory_path() / fs::unique_path("dachs-%%%%-%%%%.dcs");
+    auto const write = [&path](char const* const code)
+        {
+            std::ofstream out{path.string()};
+            out << code;
+        };
+
+    dachs::syntax::module_pool pool;
+    auto const root = p.parse("func foo; end", path.string()).root;
+
+    write("func foo; end\n");
+    pool.add(path, root, identity::of(path.string()));
+    BOOST_CHECK(pool.find(path));
+
+    // Note:
+    // Modified in the same second.  The size and the nanoseconds of mtime differ.
+    write("func foo2; end\n");
+    BOOST_CHECK(!pool.find(path));
+
+    // Note:
+    // The file is modified after its identity is captured (i.e. after it was read).
+    // The module must not be found with the new identity.
+    auto const before_modified = identity::of(path.string());
+    write("func foo; end\n");
+    pool.add(path, root, before_modified);
+    BOOST_CHECK(!pool.find(path));
+
+    fs::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(resolved_imports)
+{
+    using dachs::syntax::find_import_path;
+
+    auto const aaa = find_import_path("foo.aaa", importdirs, dummy_file);
+    BOOST_REQUIRE(aaa);
+    BOOST_CHECK(fs::equivalent(*aaa, DACHS_ROOT_DIR "/test/assets/import_test/foo/aaa.dcs"));
+
+    // Note:
+    // Modules which are not in the import directories are searched in the directory of the source.
+    auto const relative = find_import_path("relative_path_test", importdirs, dummy_file);
+    BOOST_REQUIRE(relative);
+    BOOST_CHECK(fs::equivalent(*relative, DACHS_ROOT_DIR "/test/assets/import_test/dummy/relative_path_test.dcs"));
+    BOOST_CHECK(!find_import_path("relative_path_test", importdirs, DACHS_ROOT_DIR "/test/assets/import_test/main.dcs"));
+
+    BOOST_CHECK(!find_import_path("unknown_file", importdirs, dummy_file));
+
+    auto t = p.parse("import foo.aaa\nimport std.range\nfunc main; end", dummy_file);
+    dachs::syntax::importer i{importdirs, dummy_file};
+    dachs::semantics::analyze_semantics(t, i);
+    BOOST_REQUIRE(i.resolved_imports.count("foo.aaa") == 1u);
+    BOOST_CHECK(fs::equivalent(i.resolved_imports["foo.aaa"], *aaa));
+    BOOST_CHECK(i.resolved_imports.count("std.range") == 1u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -7,16 +7,73 @@
 #include "dachs/parser/parser.hpp"
 #include "dachs/exception.hpp"
 #include "dachs/ast/ast_walker.hpp"
+#include "dachs/ast/stringize_ast.hpp"
+#include "dachs/ast/source_files.hpp"
+#include "dachs/helper/source_buffer.hpp"
 #include "dachs/helper/util.hpp"
 
 #include <string>
+#include <fstream>
 
 #include <boost/test/included/unit_test.hpp>
 
 using namespace dachs::test;
 
+// Note:
+// Parse the code with both front ends and check they agree.  The hand-written
+// parser must accept the same code and build the same AST as the Spirit grammar.
+// The result of the Spirit grammar is returned and its exception is propagated.
+class both_front_ends {
+    dachs::syntax::parser spirit;
+    dachs::syntax::parser hand_written{dachs::syntax::node_allocation::heap, dachs::syntax::front_end::hand_written};
+
+    template<class Parse>
+    static auto expect_accepted(Parse const& parse)
+    {
+        try {
+            return parse();
+        }
+        catch (dachs::parse_error const&) {
+            BOOST_ERROR("The hand-written parser accepted the code which the Spirit grammar rejects");
+            throw;
+        }
+    }
+
+public:
+
+    dachs::ast::ast parse(std::string const& code, std::string const& file_name) const
+    {
+        std::string other;
+        try {
+            other = dachs::ast::stringize_ast(hand_written.parse(code, file_name));
+        }
+        catch (dachs::parse_error const&) {
+            BOOST_CHECK_THROW(spirit.parse(code, file_name), dachs::parse_error);
+            throw;
+        }
+
+        auto result = expect_accepted([&]{ return spirit.parse(code, file_name); });
+        BOOST_CHECK_EQUAL(dachs::ast::stringize_ast(result), other);
+        return result;
+    }
+
+    void check_syntax(std::string const& code) const
+    {
+        try {
+            hand_written.check_syntax(code);
+        }
+        catch (dachs::parse_error const&) {
+            BOOST_CHECK_THROW(spirit.check_syntax(code), dachs::parse_error);
+            throw;
+        }
+
+        expect_accepted([&]{ spirit.check_syntax(code); });
+    }
+
+};
+
 // NOTE: use global variable to avoid executing heavy construction of parser
-static dachs::syntax::parser p;
+static both_front_ends p;
 
 // TODO: More checks
 struct test_var_searcher {
@@ -2660,4 +2717,50 @@ BOOST_AUTO_TEST_CASE(do_not_degrade)
     )"));
 }
 
+BOOST_AUTO_TEST_CASE(source_locations)
+{
+    auto const ast = p.parse("func foo\nend\n\nfunc main\nend\n", "release_test_file");
+    auto const& loc = ast.root->functions[1]->location;
+    BOOST_CHECK_EQUAL(loc.line(), 4u);
+    BOOST_CHECK_EQUAL(loc.col(), 1u);
+    BOOST_CHECK_EQUAL(loc.get_path().filename().string(), "release_test_file");
+
+    // Released entries are treated as 'no file'
+    dachs::ast::source_files::release(boost::filesystem::absolute("release_test_file"));
+    BOOST_CHECK_EQUAL(loc.line(), 0u);
+    BOOST_CHECK(loc.get_path().empty());
+}
+
+BOOST_AUTO_TEST_CASE(source_rewritten_in_place)
+{
+    namespace fs = boost::filesystem;
+    using dachs::helper::source_buffer;
+
+    auto const path = fs::temp_directory_path() / fs::unique_path("dachs-%%%%-%%%%.dcs");
+    auto const write = [&path](char const* const code)
+        {
+            std::ofstream out{path.string()};
+            out << code;
+        };
+
+    write("func main\nend\n");
+    auto const first = source_buffer::open(path.string());
+    BOOST_REQUIRE(first);
+    BOOST_CHECK(!source_buffer::read(path.string())->is_mapped());
+    auto const first_id = dachs::ast::source_files::add(path, first);
+    BOOST_CHECK_EQUAL(dachs::ast::source_files::add(path, source_buffer::open(path.string())), first_id);
+
+    // Note:
+    // Rewrite the file with the code of the same size.  The mapping of 'first' shows
+    // the new code, so the change must be detected by the modification time.
+    auto const mtime = fs::last_write_time(path);
+    write("func mian\nend\n");
+    fs::last_write_time(path, mtime + 1);
+    auto const second_id = dachs::ast::source_files::add(path, source_buffer::open(path.string()));
+    BOOST_CHECK(first_id != second_id);
+
+    dachs::ast::source_files::release(path);
+    fs::remove(path);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -8,9 +8,13 @@
 #include "dachs/parser/parser.hpp"
 #include "dachs/exception.hpp"
 #include "dachs/ast/ast_walker.hpp"
+#include "dachs/ast/ast_serializer.hpp"
+#include "dachs/ast/stringize_ast.hpp"
 #include "dachs/helper/util.hpp"
 
 #include <string>
+#include <vector>
+#include <algorithm>
 
 #include <boost/test/included/unit_test.hpp>
 
@@ -54,6 +58,66 @@ void check_throw_in_all_cases_in_directory(std::string const& dir_name)
             });
 }
 
+inline
+void check_serialization_in_all_cases_in_directory(std::string const& dir_name)
+{
+    dachs::syntax::parser parser;
+    check_all_cases_in_directory(dir_name, [&parser](fs::path const& p){
+                std::cout << "testing serialization of " << p.c_str() << std::endl;
+                auto const ast = parser.parse(
+                        *dachs::helper::read_file<std::string>(p.c_str()),
+                        p.c_str()
+                    );
+                auto const restored = dachs::ast::deserialize_ast(
+                        dachs::ast::serialize_ast(ast.root),
+                        ast.root->location.file
+                    );
+                BOOST_REQUIRE(restored);
+                BOOST_CHECK_EQUAL(
+                        dachs::ast::stringize_ast(ast),
+                        dachs::ast::stringize_ast({*restored, ast.name})
+                    );
+            });
+}
+
+inline
+void check_arena_allocation_in_all_cases_in_directory(std::string const& dir_name)
+{
+    dachs::syntax::parser heap_parser;
+    dachs::syntax::parser arena_parser{dachs::syntax::node_allocation::arena};
+    check_all_cases_in_directory(dir_name, [&](fs::path const& p){
+                std::cout << "testing arena allocation of " << p.c_str() << std::endl;
+                auto const code = *dachs::helper::read_file<std::string>(p.c_str());
+                auto const expected = dachs::ast::stringize_ast(heap_parser.parse(code, p.c_str()));
+
+                // Note:
+                // Nodes must be valid after the parser and the ast are destroyed.
+                dachs::ast::node::inu root;
+                {
+                    dachs::syntax::parser parser{dachs::syntax::node_allocation::arena};
+                    root = parser.parse(code, p.c_str()).root;
+                }
+                BOOST_CHECK_EQUAL(expected, dachs::ast::stringize_ast({root, p.c_str()}));
+
+                BOOST_CHECK_EQUAL(expected, dachs::ast::stringize_ast(arena_parser.parse(code, p.c_str())));
+            });
+}
+
+inline
+void check_hand_written_parser_in_all_cases_in_directory(std::string const& dir_name)
+{
+    dachs::syntax::parser spirit_parser;
+    dachs::syntax::parser hand_written_parser{dachs::syntax::node_allocation::arena, dachs::syntax::front_end::hand_written};
+    check_all_cases_in_directory(dir_name, [&](fs::path const& p){
+                std::cout << "testing hand-written parser with " << p.c_str() << std::endl;
+                auto const code = *dachs::helper::read_file<std::string>(p.c_str());
+                BOOST_CHECK_NO_THROW(hand_written_parser.check_syntax(code));
+                BOOST_CHECK_EQUAL(
+                        dachs::ast::stringize_ast(spirit_parser.parse(code, p.c_str())),
+                        dachs::ast::stringize_ast(hand_written_parser.parse(code, p.c_str()))
+                    );
+            });
+}
 
 BOOST_AUTO_TEST_SUITE(parser)
 BOOST_AUTO_TEST_SUITE(samples)
@@ -68,5 +132,57 @@ BOOST_AUTO_TEST_CASE(samples)
     check_no_throw_in_all_cases_in_directory(DACHS_ROOT_DIR "/test/assets/samples");
 }
 
+BOOST_AUTO_TEST_CASE(serialization)
+{
+    check_serialization_in_all_cases_in_directory(DACHS_ROOT_DIR "/test/assets/comprehensive");
+    check_serialization_in_all_cases_in_directory(DACHS_ROOT_DIR "/test/assets/samples");
+    check_serialization_in_all_cases_in_directory(DACHS_ROOT_DIR "/lib/dachs/std");
+}
+
+BOOST_AUTO_TEST_CASE(arena_allocation)
+{
+    check_arena_allocation_in_all_cases_in_directory(DACHS_ROOT_DIR "/test/assets/comprehensive");
+    check_arena_allocation_in_all_cases_in_directory(DACHS_ROOT_DIR "/test/assets/samples");
+}
+
+BOOST_AUTO_TEST_CASE(implicit_imports_in_arena)
+{
+    auto const code = R"(
+        func main(args)
+            a := [1, 2, 3]
+            for i in 0..3
+                println("foo")
+            end
+        end
+    )";
+
+    auto const check_imports
+        = [&code](dachs::syntax::parser const& p)
+        {
+            // Note:
+            // Parse twice to check the installer is not reset before installing the imports.
+            for (int i = 0; i < 2; ++i) {
+                auto const ast = p.parse(code, "test_file");
+                std::vector<std::string> imported;
+                for (auto const& import : ast.root->imports) {
+                    imported.push_back(import->path);
+                }
+                std::sort(imported.begin(), imported.end());
+                BOOST_CHECK((imported == std::vector<std::string>{"std.argv", "std.array", "std.range", "std.string"}));
+            }
+        };
+
+    check_imports(dachs::syntax::parser{dachs::syntax::node_allocation::heap});
+    check_imports(dachs::syntax::parser{dachs::syntax::node_allocation::arena});
+    check_imports(dachs::syntax::parser{dachs::syntax::node_allocation::arena, dachs::syntax::front_end::hand_written});
+}
+
+BOOST_AUTO_TEST_CASE(hand_written_parser)
+{
+    check_hand_written_parser_in_all_cases_in_directory(DACHS_ROOT_DIR "/test/assets/comprehensive");
+    check_hand_written_parser_in_all_cases_in_directory(DACHS_ROOT_DIR "/test/assets/samples");
+    check_hand_written_parser_in_all_cases_in_directory(DACHS_ROOT_DIR "/lib/dachs/std");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 BOOST_AUTO_TEST_SUITE_END()
@@ -12,11 +12,24 @@
 #include <boost/range/adaptors.hpp>
 
 #include "dachs/helper/colorizer.hpp"
+#include "dachs/parser/module_cache.hpp"
 
 struct initializer_before_all_tests {
+    // Note:
+    // Tests must not write parsed modules to the user's cache directory.
+    boost::filesystem::path const module_cache_dir
+        = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("dachs-test-cache-%%%%-%%%%-%%%%");
+
     initializer_before_all_tests()
     {
         dachs::helper::colorizer::enabled = false;
+        dachs::syntax::module_cache::default_dir = module_cache_dir;
+    }
+
+    ~initializer_before_all_tests()
+    {
+        boost::system::error_code err;
+        boost::filesystem::remove_all(module_cache_dir, err);
     }
 };
 